@@ -12,6 +12,68 @@
  * `strsafe_` functions have the rest of the arguments, StrSafe (if the argument is string)
  * `cstr_` functions have the rest of the arguments char* (if the argument is string)
  *
+ * Capacity grows geometrically (see `strsafe_grow_capacity`) so repeated appends are
+ * amortized O(1). The policy can be tuned at compile time before including this header:
+ * - `STRSAFE_GROWTH_POLICY`: `STRSAFE_GROWTH_2X` (default), `STRSAFE_GROWTH_1_5X` or `STRSAFE_GROWTH_EXACT`.
+ * - `STRSAFE_MIN_CAPACITY`: smallest buffer allocated on first growth (default 16).
+ * - `STRSAFE_GROW_CAPACITY(cur_cap, min_cap)`: replaces the policy with a custom expression.
+ * - `STRSAFE_ZERO_FILL`: zero new capacity on growth (off by default).
+ * `strsafe_trim` remains the explicit way to give unused capacity back.
+ *
+ * `strsafe_appendf` formats straight into the spare capacity of a string, growing it at most
+ * once; `strsafe_append_int`, `strsafe_append_u64` and `strsafe_append_double` write numbers
+ * with digit-pair tables instead of going through printf.
+ *
+ * Shrinking edits (`strsafe_substr`, the `remove` functions) work in place and keep the
+ * buffer, so a loop of edits on one string does not allocate. `STRSAFE_TRIM_POLICY` picks
+ * what happens to the freed capacity: `STRSAFE_TRIM_EXPLICIT` (default) leaves it for later
+ * growth, `STRSAFE_TRIM_ON_SHRINK` trims after every shrinking edit.
+ *
+ * Defining `STRSAFE_SSO` switches `StrSafe` to a small-string layout: contents shorter than
+ * `STRSAFE_SSO_CAPACITY` are stored inside the struct itself and move to the heap
+ * transparently when they grow. In that mode the `data`/`len`/`cap` fields are only valid
+ * for heap strings, so read strings through `strsafe_cstr`, `strsafe_length` and
+ * `strsafe_capacity`, which work in both layouts.
+ *
+ * Memory comes from `STRSAFE_MALLOC`/`STRSAFE_REALLOC`/`STRSAFE_FREE` (libc by default).
+ * Functions ending in `_ex` take a `StrSafe_allocator` instead, such as the bump arena
+ * from `strsafe_arena_allocator`; strings obtained that way must only be resized or freed
+ * through `_ex` functions given the same allocator.
+ *
+ * Defining `STRSAFE_POOL` puts a buffer pool in front of the default heap: buffers of up
+ * to `1 << STRSAFE_POOL_MAX_SHIFT` bytes are rounded up to a power-of-two size class, and
+ * freeing one files it on a bounded free list of the calling thread instead of calling
+ * `STRSAFE_FREE`, so the next allocation or growth of that class reuses it. A thread cache
+ * that overflows hands half its blocks to a mutex-protected global list. `strsafe_pool_stats`
+ * reports the hit rate; threads should call `strsafe_pool_flush` before exiting. The pool
+ * state is `static`, so each translation unit including this header keeps its own.
+ *
+ * Substring search runs on SSE2, AVX2 or NEON kernels when the target supports them;
+ * on x86 builds without `-mavx2` the AVX2 kernel is picked at runtime from cpuid.
+ * Define `STRSAFE_NO_SIMD` to force the portable scalar search. A `StrSafe_needle` does the
+ * kernel selection once for a pattern searched many times; on scalar builds needles of at
+ * least `STRSAFE_NEEDLE_SKIP_MIN` bytes (default 16) use a Boyer-Moore-Horspool skip table.
+ *
+ * `strsafe_share` turns a heap buffer into a reference-counted one that any number of
+ * strings can point at; `strsafe_copy` of a shared string then only bumps the count. The
+ * count is atomic, so shared strings may be handed to other threads. Every mutating
+ * function first makes its own copy when the buffer is still shared (copy-on-write), and
+ * the last string to be freed releases the buffer.
+ *
+ * Defining `STRSAFE_STATS` compiles in per-thread counters of allocations, reallocations,
+ * bytes copied, searches and bytes scanned, kept per group of functions (`StrSafe_stat_fn`).
+ * `strsafe_stats_snapshot` and `strsafe_stats_reset` read and clear them, and
+ * `strsafe_stats_set_hook` installs a callback that sees every event as it happens. Without
+ * the flag the counting sites expand to nothing.
+ *
+ * `strsafe_hash` and its view, C-string and seeded variants hash contents with a
+ * wyhash-style function that consumes 48 bytes per round. `StrSafe_hashed` keeps a string
+ * together with its hash so `strsafe_hashed_compare` can reject unequal keys without
+ * touching their bytes.
+ *
+ * The header also compiles as C++ with the same layout, so strings can cross between C and
+ * C++ code; `StrSafe.hpp` wraps them in RAII classes with move semantics.
+ *
  */
 
 #ifndef SAFE_STR_H
@@ -20,8 +82,195 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdio.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+#if !defined(STRSAFE_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STRSAFE_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define STRSAFE_HAVE_AVX2 1
+#include <immintrin.h>
+#elif defined(STRSAFE_HAVE_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define STRSAFE_HAVE_AVX2 1
+#define STRSAFE_AVX2_RUNTIME 1
+#define STRSAFE_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(STRSAFE_HAVE_SSE2) && defined(_MSC_VER)
+#define STRSAFE_HAVE_AVX2 1
+#define STRSAFE_AVX2_RUNTIME 1
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define STRSAFE_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+#endif // STRSAFE_NO_SIMD
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+typedef volatile long strsafe_refcount;
+#define STRSAFE_REF_INIT(ref, n) (*(ref) = (n))
+#define STRSAFE_REF_LOAD(ref) _InterlockedOr((ref), 0)
+#define STRSAFE_REF_INC(ref) ((void)_InterlockedIncrement(ref))
+#define STRSAFE_REF_DEC(ref) _InterlockedDecrement(ref)
+#elif defined(__cplusplus)
+#include <atomic>
+typedef std::atomic<size_t> strsafe_refcount;
+#define STRSAFE_REF_INIT(ref, n) std::atomic_init((ref), (size_t)(n))
+#define STRSAFE_REF_LOAD(ref) std::atomic_load_explicit((ref), std::memory_order_acquire)
+#define STRSAFE_REF_INC(ref) ((void)std::atomic_fetch_add_explicit((ref), (size_t)1, std::memory_order_relaxed))
+#define STRSAFE_REF_DEC(ref) (std::atomic_fetch_sub_explicit((ref), (size_t)1, std::memory_order_acq_rel) - 1)
+#else
+#include <stdatomic.h>
+typedef atomic_size_t strsafe_refcount;
+#define STRSAFE_REF_INIT(ref, n) atomic_init((ref), (n))
+#define STRSAFE_REF_LOAD(ref) atomic_load_explicit((ref), memory_order_acquire)
+#define STRSAFE_REF_INC(ref) ((void)atomic_fetch_add_explicit((ref), 1, memory_order_relaxed))
+#define STRSAFE_REF_DEC(ref) (atomic_fetch_sub_explicit((ref), 1, memory_order_acq_rel) - 1)
+#endif
+
+#ifndef STRSAFE_AVX2_TARGET
+#define STRSAFE_AVX2_TARGET
+#endif
+
+#ifdef STRSAFE_POOL
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+typedef SRWLOCK strsafe_pool_lock;
+#define STRSAFE_POOL_LOCK_INIT SRWLOCK_INIT
+#define STRSAFE_POOL_LOCK(lock) AcquireSRWLockExclusive(lock)
+#define STRSAFE_POOL_UNLOCK(lock) ReleaseSRWLockExclusive(lock)
+#else
+#include <pthread.h>
+typedef pthread_mutex_t strsafe_pool_lock;
+#define STRSAFE_POOL_LOCK_INIT PTHREAD_MUTEX_INITIALIZER
+#define STRSAFE_POOL_LOCK(lock) pthread_mutex_lock(lock)
+#define STRSAFE_POOL_UNLOCK(lock) pthread_mutex_unlock(lock)
+#endif
+#endif // STRSAFE_POOL
+
+#if defined(__cplusplus)
+#define STRSAFE_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER) && !defined(__clang__)
+#define STRSAFE_THREAD_LOCAL __declspec(thread)
+#else
+#define STRSAFE_THREAD_LOCAL _Thread_local
+#endif
+
+#if defined(__cplusplus)
+#define STRSAFE_ALIGNOF(type) alignof(type)
+#else
+#define STRSAFE_ALIGNOF(type) _Alignof(type)
+#endif
+
+/** @brief Growth policies selectable through `STRSAFE_GROWTH_POLICY`. */
+#define STRSAFE_GROWTH_EXACT 0
+#define STRSAFE_GROWTH_1_5X 1
+#define STRSAFE_GROWTH_2X 2
+
+#ifndef STRSAFE_GROWTH_POLICY
+#define STRSAFE_GROWTH_POLICY STRSAFE_GROWTH_2X
+#endif
+
+/** @brief Trim policies selectable through `STRSAFE_TRIM_POLICY`. */
+#define STRSAFE_TRIM_EXPLICIT 0
+#define STRSAFE_TRIM_ON_SHRINK 1
+
+#ifndef STRSAFE_TRIM_POLICY
+#define STRSAFE_TRIM_POLICY STRSAFE_TRIM_EXPLICIT
+#endif
+
+#ifndef STRSAFE_MIN_CAPACITY
+#define STRSAFE_MIN_CAPACITY 16
+#endif
+
+#ifndef STRSAFE_APPENDF_MIN
+#define STRSAFE_APPENDF_MIN 64   /**< Room `strsafe_appendf` makes before formatting into a string without spare capacity. */
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define STRSAFE_PRINTF_FORMAT(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define STRSAFE_PRINTF_FORMAT(fmt, args)
+#endif
+
+#ifndef STRSAFE_MALLOC
+#define STRSAFE_MALLOC(size) malloc(size)
+#define STRSAFE_REALLOC(ptr, size) realloc(ptr, size)
+#define STRSAFE_FREE(ptr) free(ptr)
+#endif
+
+#ifndef STRSAFE_ARENA_BLOCK_SIZE
+#define STRSAFE_ARENA_BLOCK_SIZE 65536
+#endif
+
+#ifndef STRSAFE_POOL_MAX_SHIFT
+#define STRSAFE_POOL_MAX_SHIFT 12        /**< Largest size class kept by `STRSAFE_POOL` is `1 << STRSAFE_POOL_MAX_SHIFT` bytes. */
+#endif
+
+#ifndef STRSAFE_POOL_THREAD_CACHE
+#define STRSAFE_POOL_THREAD_CACHE 64     /**< Blocks per size class cached by each thread before half move to the global list. */
+#endif
+
+#ifndef STRSAFE_POOL_GLOBAL_CACHE
+#define STRSAFE_POOL_GLOBAL_CACHE 1024   /**< Blocks per size class kept on the global list; beyond it blocks go back to the heap. */
+#endif
+
+#ifndef STRSAFE_MATCH_STACK
+#define STRSAFE_MATCH_STACK 64   /**< Match offsets recorded on the stack before spilling to the heap. */
+#endif
+
+#ifndef STRSAFE_NEEDLE_SKIP_MIN
+#if defined(STRSAFE_HAVE_SSE2) || defined(STRSAFE_HAVE_NEON)
+#define STRSAFE_NEEDLE_SKIP_MIN SIZE_MAX   /**< The first/last byte filter outruns the skip table at every length. */
+#else
+#define STRSAFE_NEEDLE_SKIP_MIN 16         /**< Needle length from which `StrSafe_needle` searches with a skip table. */
+#endif
+#endif
+
+#ifdef STRSAFE_SSO
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "STRSAFE_SSO requires a little-endian target"
+#endif
+
+/**
+ * @struct StrSafe
+ * @brief Represents a string stored inline when short and on the heap otherwise.
+ *
+ * The last byte of `sso` is a tag: with its high bit clear the string is inline and the
+ * tag holds its length; with it set the `data`/`len`/`cap` fields describe a heap buffer
+ * and the flag lives in the top bit of `cap`. A zeroed struct is a valid empty string.
+ */
+typedef struct {
+	union {
+		struct {
+			char* data;   /**< Pointer to the string data (null-terminated), heap form only. */
+			size_t len;   /**< Length of the string (excluding null terminator), heap form only. */
+			size_t cap;   /**< Capacity of the allocated buffer plus the heap flag, heap form only. */
+		};
+		char sso[3 * sizeof(size_t)];   /**< Inline contents followed by the tag byte. */
+	};
+} StrSafe;
+
+/** @brief Bytes available inline, including the null terminator. */
+#define STRSAFE_SSO_CAPACITY (sizeof(StrSafe) - 1)
+
+/** @brief Bit of `cap` marking a heap-allocated string. */
+#define STRSAFE_HEAP_FLAG (~(SIZE_MAX >> 1))
+
+#else
 
 /**
  * @struct StrSafe
@@ -33,6 +282,14 @@ typedef struct {
 	size_t cap;   /**< Capacity of the allocated buffer (including null terminator). */
 } StrSafe;
 
+#endif // STRSAFE_SSO
+
+/** @brief Bit of `cap` marking a buffer shared through a `StrSafe_shared` header. */
+#define STRSAFE_SHARED_FLAG ((SIZE_MAX >> 1) & ~(SIZE_MAX >> 2))
+
+/** @brief Bit of `cap` caching a successful `strsafe_utf8_check`; only set with `STRSAFE_UTF8_CACHE`. */
+#define STRSAFE_UTF8_FLAG ((SIZE_MAX >> 2) & ~(SIZE_MAX >> 3))
+
 /**
  * @struct StrSafe_array
  * @brief Represents an array of `StrSafe` strings.
@@ -40,688 +297,4020 @@ typedef struct {
 typedef struct {
 	StrSafe* arr;     /**< Pointer to array of `StrSafe` strings. */
 	int array_size;   /**< Number of elements in the array. */
+	int capacity;     /**< Number of elements allocated. */
 } StrSafe_array;
 
 /**
- * @brief Initializes a `StrSafe` string to empty.
- * @param strsafe Pointer to the `StrSafe` to initialize.
+ * @struct StrSafe_packed_array
+ * @brief Array of strings stored back to back in one buffer, indexed by an offsets table.
+ *
+ * Element `i` is the null-terminated run starting at `blob + offsets[i]`, of length
+ * `offsets[i + 1] - offsets[i] - 1`; `offsets` holds `count + 1` entries once allocated.
  */
-static inline void strsafe_init(StrSafe* strsafe) {
-	strsafe->data = NULL;
-	strsafe->len = 0;
-	strsafe->cap = 0;
-}
+typedef struct {
+	char* blob;           /**< Element bytes, each followed by a null terminator. */
+	size_t blob_len;      /**< Bytes of `blob` in use. */
+	size_t blob_cap;      /**< Bytes of `blob` allocated. */
+	size_t* offsets;      /**< Start of each element, plus the end of the last one. */
+	size_t offsets_cap;   /**< Entries of `offsets` allocated. */
+	size_t count;         /**< Number of elements. */
+} StrSafe_packed_array;
 
 /**
- * @brief Initializes a `StrSafe_array` string to empty.
- * @param new_strsafe_array Pointer to the `StrSafe` to initialize.
+ * @struct StrSafe_view
+ * @brief Non-owning, read-only slice of characters; not necessarily null-terminated.
  */
-static inline void strsafe_array_init(StrSafe_array* new_strsafe_array) {
-	new_strsafe_array->arr = NULL;
-	new_strsafe_array->array_size = 0;
-}
+typedef struct {
+	const char* ptr;   /**< First character of the slice. */
+	size_t len;        /**< Number of characters in the slice. */
+} StrSafe_view;
 
 /**
- * @brief Frees memory used by a `StrSafe` string.
- * @param strsafe Pointer to the `StrSafe` to free.
+ * @struct StrSafe_view_array
+ * @brief Growable array of views that keeps its storage between calls.
  */
-static inline void strsafe_free(StrSafe* strsafe) {
-	free(strsafe->data);
-	strsafe->data = NULL;
-	strsafe->len = 0;
-	strsafe->cap = 0;
-}
+typedef struct {
+	StrSafe_view* views;   /**< Pointer to the views. */
+	size_t count;          /**< Number of views in use. */
+	size_t cap;            /**< Number of views allocated. */
+} StrSafe_view_array;
 
 /**
- * @brief Ensures the string has at least `min_cap` capacity.
- * @param strsafe Pointer to the string.
- * @param min_cap Minimum required capacity.
- * @return `true` if successful, `false` if allocation failed.
+ * @struct StrSafe_needle
+ * @brief Search pattern prepared once by `strsafe_needle_init` and reused across many haystacks.
+ *
+ * The needle bytes are not copied and must outlive the needle.
  */
-static inline bool strsafe_ensure_capacity(StrSafe* src, size_t min_cap) {
-
-	if (src->cap >= min_cap) {
-		return true;
-	}
-
-	size_t old_cap = src->cap;
-	char* new_data = realloc(src->data, min_cap);
-	if (!new_data) {
-		return false;
-	}
-
-	memset(new_data + old_cap, '\0', min_cap - old_cap);
-
-	src->data = new_data;
-	src->cap = min_cap;
-	return true;
-}
+typedef struct {
+	const char* ptr;     /**< Needle bytes. */
+	size_t len;          /**< Number of needle bytes. */
+	bool use_skip;       /**< Search with the Boyer-Moore-Horspool `skip` table. */
+	bool use_avx2;       /**< The AVX2 kernel is available on this CPU. */
+	size_t skip[256];    /**< Shift for each byte under the last needle position; filled when `use_skip`. */
+} StrSafe_needle;
 
 /**
- * @brief Trims the capacity of the string to fit its current length.
- * @param strsafe Pointer to the string.
+ * @struct StrSafe_hashed
+ * @brief A `StrSafe` paired with the hash of its contents.
+ *
+ * Call `strsafe_hashed_rehash` after modifying `str` directly.
  */
-static inline void strsafe_trim(StrSafe* src) {
-	if (src->len == 0) {
-		free(src->data);
-		src->data = NULL;
-		src->cap = 0;
-		return;
-	}
-	char* trimmed = realloc(src->data, src->len + 1);
-	if (trimmed) {
-		src->data = trimmed;
-		src->cap = src->len + 1;
-	}
-}
+typedef struct {
+	StrSafe str;     /**< The owned string. */
+	uint64_t hash;   /**< `strsafe_hash` of `str`. */
+} StrSafe_hashed;
 
 /**
- * @brief Frees all strings in a `StrSafe_array` and the array itself.
- * @param strsafe_array Pointer to the array.
+ * @struct StrSafe_allocator
+ * @brief Memory backend used by the `_ex` functions.
+ *
+ * `realloc` and `free` receive the size of the block being resized or released so that
+ * backends without per-block headers (such as the arena) can work. A `NULL` allocator
+ * pointer selects `STRSAFE_MALLOC`/`STRSAFE_REALLOC`/`STRSAFE_FREE`.
  */
-static inline void strsafe_array_free(StrSafe_array* strsafe_array) {
-	for (int i = 0; i < strsafe_array->array_size; ++i) {
-		strsafe_free(&strsafe_array->arr[i]);
-	}
-	free(strsafe_array->arr);
-	strsafe_array->arr = NULL;
-	strsafe_array->array_size = 0;
-}
+typedef struct {
+	void* (*alloc)(void* ctx, size_t size);                                   /**< Returns a new block or `NULL`. */
+	void* (*realloc)(void* ctx, void* ptr, size_t old_size, size_t new_size); /**< Resizes a block, keeping its contents. */
+	void (*free)(void* ctx, void* ptr, size_t size);                          /**< Releases a block. */
+	void* ctx;                                                                /**< Passed to every callback. */
+} StrSafe_allocator;
 
 /**
- * @brief Finds the first occurrence of a substring in a `StrSafe` string.
+ * @struct StrSafe_shared
+ * @brief Header placed in front of the contents of a shared buffer.
  *
- * @param haystack The string to search.
- * @param needle The substring to find.
- * @return Position of the first match, or -1 if not found.
+ * The block starts with this header and the string data follows it; `cap` of each sharing
+ * string still counts only the data bytes.
  */
-static inline ssize_t cstr_find(StrSafe* haystack, const char* needle) {
-	char* pos = strstr(haystack->data, needle);
-	return pos ? (ssize_t)(pos - haystack->data) : -1;
-}
+typedef struct {
+	strsafe_refcount refs;                 /**< Number of strings pointing at the buffer. */
+	const StrSafe_allocator* allocator;    /**< Allocator the block came from; must outlive it. */
+} StrSafe_shared;
 
 /**
- * @brief Replaces the first occurrence of a substring with another in a `StrSafe` string.
- *
- * This function allocates a new buffer sized exactly for the result and replaces
- * the first match of `old_str` with `new_str`. Memory is freed before exiting.
+ * @struct StrSafe_arena_block
+ * @brief One chunk of memory owned by a `StrSafe_arena`.
+ */
+typedef struct StrSafe_arena_block {
+	struct StrSafe_arena_block* next;   /**< Previously filled block. */
+	size_t size;                        /**< Total bytes in the block, header included. */
+	size_t used;                        /**< Bytes handed out so far. */
+	size_t last;                        /**< Offset of the most recent allocation. */
+} StrSafe_arena_block;
+
+/**
+ * @struct StrSafe_arena
+ * @brief Bump allocator whose allocations are all released at once by `strsafe_arena_reset`.
  *
- * @param dst The target string to modify.
- * @param old_str The substring to be replaced.
- * @param new_str The replacement string.
- * @return Pointer to `dst`, or `NULL` on allocation failure.
+ * The embedded allocator points back at the arena, so an initialized arena must not be moved.
  */
-static inline StrSafe* cstr_replace(StrSafe* dst, const char* old_str, const char* new_str) {
-	ssize_t pos = cstr_find(dst, old_str);
-	if (pos < 0) return dst;
+typedef struct {
+	StrSafe_arena_block* head;      /**< Block currently being filled. */
+	size_t block_size;              /**< Minimum size of new blocks. */
+	StrSafe_allocator allocator;    /**< Allocator returned by `strsafe_arena_allocator`. */
+} StrSafe_arena;
 
-	size_t old_len = strlen(old_str);
-	size_t new_len = strlen(new_str);
-	size_t final_len = dst->len - old_len + new_len;
+#ifdef STRSAFE_POOL
 
-	char* buffer = malloc(final_len + 1);
-	if (!buffer) return NULL;
+/** @brief Smallest size class of the pool, `1 << STRSAFE_POOL_MIN_SHIFT` bytes. */
+#define STRSAFE_POOL_MIN_SHIFT 4
+#define STRSAFE_POOL_CLASSES (STRSAFE_POOL_MAX_SHIFT - STRSAFE_POOL_MIN_SHIFT + 1)
 
-	memcpy(buffer, dst->data, pos);
-	memcpy(buffer + pos, new_str, new_len);
-	memcpy(buffer + pos + new_len, dst->data + pos + old_len, dst->len - pos - old_len);
-	buffer[final_len] = '\0';
+#if STRSAFE_POOL_MAX_SHIFT < STRSAFE_POOL_MIN_SHIFT || STRSAFE_POOL_MAX_SHIFT > 30
+#error "STRSAFE_POOL_MAX_SHIFT must be between 4 and 30"
+#endif
+#if STRSAFE_POOL_THREAD_CACHE < 2
+#error "STRSAFE_POOL_THREAD_CACHE must be at least 2"
+#endif
 
-	free(dst->data);
-	dst->data = buffer;
-	dst->len = final_len;
-	dst->cap = final_len + 1;
-	return dst;
-}
+/**
+ * @struct StrSafe_pool_block
+ * @brief Free block in the pool; the link is stored in the block itself.
+ */
+typedef struct StrSafe_pool_block {
+	struct StrSafe_pool_block* next;   /**< Next free block of the same size class. */
+} StrSafe_pool_block;
 
 /**
- * @brief Counts the number of times a substring appears in a `StrSafe` string.
- *
- * @param haystack The string to search.
- * @param needle The substring to count.
- * @return Number of occurrences found.
+ * @struct StrSafe_pool_stats
+ * @brief Counters of the calling thread's use of the pool.
  */
-static inline size_t cstr_count(const StrSafe* haystack, const char* needle) {
-	size_t count = 0;
-	const char* p = haystack->data;
-	size_t needle_len = strlen(needle);
-	while ((p = strstr(p, needle))) {
-		++count;
-		p += needle_len;
-	}
-	return count;
-}
+typedef struct {
+	size_t hits;       /**< Allocations served by a pooled block. */
+	size_t misses;     /**< Allocations of a pooled size that went to the heap. */
+	size_t returns;    /**< Frees whose block was kept in the pool. */
+	size_t releases;   /**< Pooled blocks handed back to `STRSAFE_FREE` because both caches were full. */
+	size_t cached;     /**< Blocks currently held in the calling thread's cache. */
+} StrSafe_pool_stats;
 
 /**
- * @brief Replaces all occurrences of a substring with another in a `StrSafe` string.
- *
- * This function precalculates the required capacity and performs a single allocation
- * for the final result. All matches of `old_str` are replaced with `new_str`.
- *
- * @param dst The target string to modify.
- * @param old_str The substring to be replaced.
- * @param new_str The replacement string.
- * @return Pointer to `dst`, or `NULL` on allocation failure.
+ * @struct StrSafe_pool_cache
+ * @brief Free lists of one thread, bounded to `STRSAFE_POOL_THREAD_CACHE` blocks per class.
  */
-static inline StrSafe* cstr_replace_all(StrSafe* dst, const char* old_str, const char* new_str) {
-	size_t count = cstr_count(dst, old_str);
-	if (count == 0) return dst;
+typedef struct {
+	StrSafe_pool_block* head[STRSAFE_POOL_CLASSES];   /**< Free list of each size class. */
+	size_t count[STRSAFE_POOL_CLASSES];               /**< Blocks on each list. */
+	StrSafe_pool_stats stats;                         /**< Counters; `cached` is computed on demand. */
+} StrSafe_pool_cache;
 
-	size_t old_len = strlen(old_str);
-	size_t new_len = strlen(new_str);
-	size_t final_len = dst->len + count * (new_len - old_len);
+/**
+ * @struct StrSafe_pool_global
+ * @brief Overflow lists shared by all threads, bounded to `STRSAFE_POOL_GLOBAL_CACHE` blocks per class.
+ */
+typedef struct {
+	strsafe_pool_lock lock;                           /**< Protects the fields below. */
+	StrSafe_pool_block* head[STRSAFE_POOL_CLASSES];   /**< Free list of each size class. */
+	size_t count[STRSAFE_POOL_CLASSES];               /**< Blocks on each list. */
+} StrSafe_pool_global;
 
-	char* buffer = malloc(final_len + 1);
-	if (!buffer) return NULL;
+static STRSAFE_THREAD_LOCAL StrSafe_pool_cache strsafe_pool_local;
+static StrSafe_pool_global strsafe_pool_shared = { STRSAFE_POOL_LOCK_INIT, { NULL }, { 0 } };
 
-	char* src = dst->data;
-	char* out = buffer;
-	while (*src) {
-		if (strncmp(src, old_str, old_len) == 0) {
-			memcpy(out, new_str, new_len);
-			out += new_len;
-			src += old_len;
-		}
-		else {
-			*out++ = *src++;
-		}
+/**
+ * @brief Returns the index of the highest set bit of `size`.
+ * @param size A non-zero value.
+ * @return `floor(log2(size))`.
+ */
+static inline unsigned strsafe_pool_log2(size_t size) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned)(63 - __builtin_clzll((unsigned long long)size));
+#elif defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanReverse64(&index, size);
+	return (unsigned)index;
+#else
+	unsigned index = 0;
+	while (size >>= 1) {
+		++index;
 	}
-	*out = '\0';
-
-	free(dst->data);
-	dst->data = buffer;
-	dst->len = final_len;
-	dst->cap = final_len + 1;
-	return dst;
+	return index;
+#endif
 }
 
 /**
- * @brief Finds the first occurrence of a substring starting from a given position.
- *
- * @param haystack The string to search.
- * @param needle The substring to find.
- * @param pos The position to start searching from.
- * @return Position of the first match, or -1 if not found.
+ * @brief Returns the size class whose blocks hold `size` bytes.
+ * @param size Requested size, at most `1 << STRSAFE_POOL_MAX_SHIFT`.
+ * @return Index of the smallest class of at least `size` bytes.
  */
-static inline ssize_t cstr_find_from_pos(StrSafe* haystack, const char* needle, size_t pos) {
-	if (pos >= haystack->len) return -1;
-	char* start = haystack->data + pos;
-	char* found = strstr(start, needle);
-	return found ? (ssize_t)(found - haystack->data) : -1;
+static inline unsigned strsafe_pool_class(size_t size) {
+	return size <= ((size_t)1 << STRSAFE_POOL_MIN_SHIFT) ? 0 : strsafe_pool_log2(size - 1) + 1 - STRSAFE_POOL_MIN_SHIFT;
 }
 
 /**
- * @brief Compares a `StrSafe` string with a C-string for equality.
+ * @brief Rounds an allocation size up to the block size the pool hands out for it.
  *
- * @param a The `StrSafe` string.
- * @param b The C-string.
- * @return `true` if the strings are equal, `false` otherwise.
+ * Strings record the rounded size as their capacity so that their buffer returns to
+ * the class it came from. Sizes above the largest class are returned unchanged.
+ *
+ * @param size Requested size.
+ * @return The size to allocate.
  */
-static inline bool cstr_compare(const StrSafe* a, const char* b) {
-	return strcmp(a->data, b) == 0;
+static inline size_t strsafe_pool_size(size_t size) {
+	if (size > ((size_t)1 << STRSAFE_POOL_MAX_SHIFT)) {
+		return size;
+	}
+	return (size_t)1 << (strsafe_pool_class(size) + STRSAFE_POOL_MIN_SHIFT);
 }
 
 /**
- * @brief Removes the first occurrence of a substring from a `StrSafe` string.
- *
- * This function shifts the remaining content and trims the capacity before exiting.
- *
- * @param dst The target string to modify.
- * @param str_to_remove The substring to remove.
- * @return Pointer to `dst`.
+ * @brief Takes a free block of class `cls`, refilling the thread cache from the global list.
+ * @param cls Size class.
+ * @return The block, or `NULL` when both caches are empty.
  */
-static inline StrSafe* cstr_remove(StrSafe* dst, const char* str_to_remove) {
-	ssize_t pos = cstr_find(dst, str_to_remove);
-	if (pos < 0) return dst;
-
-	size_t rem_len = strlen(str_to_remove);
-	memmove(dst->data + pos, dst->data + pos + rem_len, dst->len - pos - rem_len + 1);
-	dst->len -= rem_len;
-	strsafe_trim(dst);
-	return dst;
+static inline void* strsafe_pool_take(unsigned cls) {
+	StrSafe_pool_cache* cache = &strsafe_pool_local;
+	StrSafe_pool_block* block = cache->head[cls];
+	if (!block) {
+		StrSafe_pool_global* global = &strsafe_pool_shared;
+		StrSafe_pool_block* last = NULL;
+		size_t taken = 0;
+		STRSAFE_POOL_LOCK(&global->lock);
+		block = global->head[cls];
+		for (StrSafe_pool_block* it = block; it && taken < STRSAFE_POOL_THREAD_CACHE / 2; it = it->next) {
+			last = it;
+			++taken;
+		}
+		if (last) {
+			global->head[cls] = last->next;
+			global->count[cls] -= taken;
+			last->next = NULL;
+		}
+		STRSAFE_POOL_UNLOCK(&global->lock);
+		if (!block) {
+			return NULL;
+		}
+		cache->count[cls] = taken;
+	}
+	cache->head[cls] = block->next;
+	--cache->count[cls];
+	return block;
 }
 
 /**
- * @brief Removes all occurrences of a substring from a `StrSafe` string.
+ * @brief Puts a block of at least the size of class `cls` into the thread cache.
  *
- * This function performs in-place removal and trims the capacity before exiting.
+ * A full cache first moves half of its blocks to the global list, or back to the heap
+ * when the global list is full as well.
  *
- * @param dst The target string to modify.
- * @param str_to_remove The substring to remove.
- * @return Pointer to `dst`.
+ * @param ptr Block to keep.
+ * @param cls Size class the block can serve.
  */
-static inline StrSafe* cstr_remove_all(StrSafe* dst, const char* str_to_remove) {
-	size_t rem_len = strlen(str_to_remove);
-	char* src = dst->data;
-	char* dst_ptr = dst->data;
-	while (*src) {
-		if (strncmp(src, str_to_remove, rem_len) == 0) {
-			src += rem_len;
+static inline void strsafe_pool_put(void* ptr, unsigned cls) {
+	StrSafe_pool_cache* cache = &strsafe_pool_local;
+	if (cache->count[cls] >= STRSAFE_POOL_THREAD_CACHE) {
+		StrSafe_pool_global* global = &strsafe_pool_shared;
+		size_t moved = STRSAFE_POOL_THREAD_CACHE / 2;
+		StrSafe_pool_block* first = cache->head[cls];
+		StrSafe_pool_block* last = first;
+		for (size_t i = 1; i < moved; ++i) {
+			last = last->next;
 		}
-		else {
-			*dst_ptr++ = *src++;
+		cache->head[cls] = last->next;
+		cache->count[cls] -= moved;
+
+		bool kept = false;
+		STRSAFE_POOL_LOCK(&global->lock);
+		if (global->count[cls] + moved <= STRSAFE_POOL_GLOBAL_CACHE) {
+			last->next = global->head[cls];
+			global->head[cls] = first;
+			global->count[cls] += moved;
+			kept = true;
+		}
+		STRSAFE_POOL_UNLOCK(&global->lock);
+		if (!kept) {
+			last->next = NULL;
+			while (first) {
+				StrSafe_pool_block* next = first->next;
+				STRSAFE_FREE(first);
+				first = next;
+			}
+			cache->stats.releases += moved;
 		}
 	}
-	*dst_ptr = '\0';
-	dst->len = dst_ptr - dst->data;
-	strsafe_trim(dst);
-	return dst;
+	StrSafe_pool_block* block = (StrSafe_pool_block*)ptr;
+	block->next = cache->head[cls];
+	cache->head[cls] = block;
+	++cache->count[cls];
+	++cache->stats.returns;
 }
 
 /**
- * @brief Appends a C-string to a `StrSafe` string.
- *
- * Ensures capacity and performs a single allocation if needed.
- *
- * @param dst The target string to append to.
- * @param suffix The C-string to append.
- * @return Pointer to `dst`, or `NULL` on allocation failure.
+ * @brief Allocates `size` bytes, reusing a pooled block when one of its class is free.
+ * @param size Number of bytes.
+ * @return Pointer to the block, or `NULL` on failure.
  */
-static inline StrSafe* cstr_append(StrSafe* dst, const char* suffix) {
-	size_t suffix_len = strlen(suffix);
-	size_t new_len = dst->len + suffix_len;
-	if (!strsafe_ensure_capacity(dst, new_len + 1)) return NULL;
-	memcpy(dst->data + dst->len, suffix, suffix_len + 1);
-	dst->len = new_len;
-	return dst;
+static inline void* strsafe_pool_alloc(size_t size) {
+	if (size > ((size_t)1 << STRSAFE_POOL_MAX_SHIFT)) {
+		return STRSAFE_MALLOC(size);
+	}
+	unsigned cls = strsafe_pool_class(size);
+	void* block = strsafe_pool_take(cls);
+	if (block) {
+		++strsafe_pool_local.stats.hits;
+		return block;
+	}
+	++strsafe_pool_local.stats.misses;
+	return STRSAFE_MALLOC((size_t)1 << (cls + STRSAFE_POOL_MIN_SHIFT));
 }
 
 /**
- * @brief Appends multiple C-strings to a `StrSafe` string.
+ * @brief Returns a block to the pool, or to the heap when it is too small or too large.
  *
- * Precalculates total length and performs a single allocation.
- * The list must be terminated with a `NULL` argument.
+ * The block is filed under the largest class it can serve, so buffers that were not
+ * rounded by `strsafe_pool_size` are still safe to pool.
  *
- * @param dst The target string to append to.
- * @param suffix The first C-string to append.
- * @param ... Additional C-strings, terminated by `NULL`.
- * @return Pointer to `dst`, or `NULL` on allocation failure.
+ * @param ptr Block to release, or `NULL`.
+ * @param size Size of the block.
  */
-static inline StrSafe* cstr_appendv(StrSafe* dst, const char* suffix, ...) {
-	va_list args;
-	va_start(args, suffix);
-	size_t total_len = strlen(suffix);
-	const char* s;
-	while ((s = va_arg(args, const char*))) {
-		total_len += strlen(s);
+static inline void strsafe_pool_free(void* ptr, size_t size) {
+	if (!ptr) {
+		return;
 	}
-	va_end(args);
-
-	if (!strsafe_ensure_capacity(dst, dst->len + total_len + 1)) return NULL;
+	if (size < ((size_t)1 << STRSAFE_POOL_MIN_SHIFT) || size >= ((size_t)2 << STRSAFE_POOL_MAX_SHIFT)) {
+		STRSAFE_FREE(ptr);
+		return;
+	}
+	strsafe_pool_put(ptr, strsafe_pool_log2(size) - STRSAFE_POOL_MIN_SHIFT);
+}
 
-	va_start(args, suffix);
-	memcpy(dst->data + dst->len, suffix, strlen(suffix));
-	dst->len += strlen(suffix);
-	while ((s = va_arg(args, const char*))) {
-		size_t l = strlen(s);
-		memcpy(dst->data + dst->len, s, l);
-		dst->len += l;
+/**
+ * @brief Grows a block into a pooled one of the new class when available, else reallocates it.
+ * @param ptr Block to resize, or `NULL`.
+ * @param old_size Current size of the block.
+ * @param new_size Requested size.
+ * @return Pointer to the resized block, or `NULL` on failure (`ptr` stays valid).
+ */
+static inline void* strsafe_pool_realloc(void* ptr, size_t old_size, size_t new_size) {
+	if (!ptr) {
+		return strsafe_pool_alloc(new_size);
 	}
-	dst->data[dst->len] = '\0';
-	va_end(args);
-	return dst;
+	if (new_size > old_size && new_size <= ((size_t)1 << STRSAFE_POOL_MAX_SHIFT)) {
+		unsigned cls = strsafe_pool_class(new_size);
+		void* block = strsafe_pool_take(cls);
+		if (block) {
+			++strsafe_pool_local.stats.hits;
+			memcpy(block, ptr, old_size);
+			strsafe_pool_free(ptr, old_size);
+			return block;
+		}
+		++strsafe_pool_local.stats.misses;
+		new_size = (size_t)1 << (cls + STRSAFE_POOL_MIN_SHIFT);
+	}
+	return STRSAFE_REALLOC(ptr, new_size);
 }
 
 /**
- * @brief Splits a `StrSafe` string into an array of substrings using a C-string delimiter.
+ * @brief Returns the pool counters of the calling thread.
+ * @return The counters, with `cached` filled in.
+ */
+static inline StrSafe_pool_stats strsafe_pool_stats(void) {
+	StrSafe_pool_stats stats = strsafe_pool_local.stats;
+	stats.cached = 0;
+	for (unsigned cls = 0; cls < STRSAFE_POOL_CLASSES; ++cls) {
+		stats.cached += strsafe_pool_local.count[cls];
+	}
+	return stats;
+}
+
+/**
+ * @brief Returns the fraction of the calling thread's pooled-size allocations served by the pool.
+ * @return `hits / (hits + misses)`, or 0 before the first allocation.
+ */
+static inline double strsafe_pool_hit_rate(void) {
+	size_t total = strsafe_pool_local.stats.hits + strsafe_pool_local.stats.misses;
+	return total ? (double)strsafe_pool_local.stats.hits / (double)total : 0.0;
+}
+
+/**
+ * @brief Clears the pool counters of the calling thread.
+ */
+static inline void strsafe_pool_reset_stats(void) {
+	memset(&strsafe_pool_local.stats, 0, sizeof(strsafe_pool_local.stats));
+}
+
+/**
+ * @brief Moves every block cached by the calling thread to the global list.
+ *
+ * Call before a thread exits so its blocks stay usable by the others; what does not fit
+ * on the global list is freed.
+ */
+static inline void strsafe_pool_flush(void) {
+	StrSafe_pool_cache* cache = &strsafe_pool_local;
+	StrSafe_pool_global* global = &strsafe_pool_shared;
+	for (unsigned cls = 0; cls < STRSAFE_POOL_CLASSES; ++cls) {
+		StrSafe_pool_block* rest = NULL;
+		size_t released = 0;
+		STRSAFE_POOL_LOCK(&global->lock);
+		while (cache->head[cls]) {
+			StrSafe_pool_block* block = cache->head[cls];
+			cache->head[cls] = block->next;
+			if (global->count[cls] < STRSAFE_POOL_GLOBAL_CACHE) {
+				block->next = global->head[cls];
+				global->head[cls] = block;
+				++global->count[cls];
+			}
+			else {
+				block->next = rest;
+				rest = block;
+				++released;
+			}
+		}
+		STRSAFE_POOL_UNLOCK(&global->lock);
+		cache->count[cls] = 0;
+		cache->stats.releases += released;
+		while (rest) {
+			StrSafe_pool_block* next = rest->next;
+			STRSAFE_FREE(rest);
+			rest = next;
+		}
+	}
+}
+
+/**
+ * @brief Frees the blocks cached by the calling thread and every block on the global list.
+ */
+static inline void strsafe_pool_purge(void) {
+	StrSafe_pool_cache* cache = &strsafe_pool_local;
+	StrSafe_pool_global* global = &strsafe_pool_shared;
+	for (unsigned cls = 0; cls < STRSAFE_POOL_CLASSES; ++cls) {
+		STRSAFE_POOL_LOCK(&global->lock);
+		StrSafe_pool_block* shared = global->head[cls];
+		global->head[cls] = NULL;
+		global->count[cls] = 0;
+		STRSAFE_POOL_UNLOCK(&global->lock);
+
+		StrSafe_pool_block* lists[2] = { cache->head[cls], shared };
+		for (int i = 0; i < 2; ++i) {
+			while (lists[i]) {
+				StrSafe_pool_block* next = lists[i]->next;
+				STRSAFE_FREE(lists[i]);
+				lists[i] = next;
+			}
+		}
+		cache->head[cls] = NULL;
+		cache->count[cls] = 0;
+	}
+}
+
+#endif // STRSAFE_POOL
+
+/**
+ * @enum StrSafe_stat_fn
+ * @brief Rows of `StrSafe_stats`, one per instrumented group of functions.
+ */
+typedef enum {
+	STRSAFE_STAT_HEAP,              /**< Every block from `strsafe_mem_alloc`/`strsafe_mem_realloc`/`strsafe_mem_free`. */
+	STRSAFE_STAT_ENSURE_CAPACITY,   /**< `strsafe_ensure_capacity` and `strsafe_reserve`, with the buffer moves they caused. */
+	STRSAFE_STAT_ASSIGN,            /**< `strsafe_assign` and the `set` functions. */
+	STRSAFE_STAT_APPEND,            /**< `cstr_append_n` and the append functions built on it. */
+	STRSAFE_STAT_FIND,              /**< The `find` functions on strings, views and prepared needles. */
+	STRSAFE_STAT_COUNT,             /**< The `count` functions. */
+	STRSAFE_STAT_REPLACE,           /**< `strsafe_needle_replace_all` and the `replace_all` functions built on it. */
+	STRSAFE_STAT_SPLIT,             /**< The `split` functions into arrays, view arrays and packed arrays. */
+	STRSAFE_STAT_FUNCTIONS          /**< Number of rows. */
+} StrSafe_stat_fn;
+
+/**
+ * @enum StrSafe_stat_event
+ * @brief What a `StrSafe_stats_hook` is told about.
+ */
+typedef enum {
+	STRSAFE_EVENT_CALL,      /**< The function ran; `bytes` is 0. */
+	STRSAFE_EVENT_ALLOC,     /**< A block of `bytes` was allocated. */
+	STRSAFE_EVENT_REALLOC,   /**< A block was resized to `bytes`. */
+	STRSAFE_EVENT_FREE,      /**< A block of `bytes` was released. */
+	STRSAFE_EVENT_COPY,      /**< `bytes` were copied into a string. */
+	STRSAFE_EVENT_SCAN       /**< `bytes` of a haystack were searched. */
+} StrSafe_stat_event;
+
+/**
+ * @struct StrSafe_stat_counters
+ * @brief Counters of one `StrSafe_stat_fn` row.
+ */
+typedef struct {
+	size_t calls;             /**< Times the functions ran; for searches, the number of searches. */
+	size_t allocs;            /**< Blocks allocated. */
+	size_t reallocs;          /**< Blocks resized. */
+	size_t frees;             /**< Blocks released. */
+	size_t bytes_allocated;   /**< Sizes requested by `allocs` and `reallocs`. */
+	size_t bytes_copied;      /**< Bytes copied into strings, including contents moved to a larger buffer. */
+	size_t bytes_scanned;     /**< Haystack bytes searched, up to the end of the match that stopped a search. */
+} StrSafe_stat_counters;
+
+/**
+ * @struct StrSafe_stats
+ * @brief Per-thread snapshot of the `STRSAFE_STATS` counters.
+ */
+typedef struct {
+	StrSafe_stat_counters fn[STRSAFE_STAT_FUNCTIONS];   /**< Counters indexed by `StrSafe_stat_fn`. */
+} StrSafe_stats;
+
+/** @brief Callback receiving every counted event; `ctx` is the pointer given to `strsafe_stats_set_hook`. */
+typedef void (*StrSafe_stats_hook)(void* ctx, StrSafe_stat_fn fn, StrSafe_stat_event event, size_t bytes);
+
+#ifdef STRSAFE_STATS
+
+static STRSAFE_THREAD_LOCAL StrSafe_stats strsafe_stats_local;
+static StrSafe_stats_hook strsafe_stats_hook_fn;
+static void* strsafe_stats_hook_ctx;
+
+/**
+ * @brief Adds one event to the calling thread's counters and reports it to the hook.
+ * @param fn Row of the function that caused it.
+ * @param event What happened.
+ * @param bytes Size involved, as described by `StrSafe_stat_event`.
+ */
+static inline void strsafe_stats_record(StrSafe_stat_fn fn, StrSafe_stat_event event, size_t bytes) {
+	StrSafe_stat_counters* counters = &strsafe_stats_local.fn[fn];
+	switch (event) {
+	case STRSAFE_EVENT_CALL: ++counters->calls; break;
+	case STRSAFE_EVENT_ALLOC: ++counters->allocs; counters->bytes_allocated += bytes; break;
+	case STRSAFE_EVENT_REALLOC: ++counters->reallocs; counters->bytes_allocated += bytes; break;
+	case STRSAFE_EVENT_FREE: ++counters->frees; break;
+	case STRSAFE_EVENT_COPY: counters->bytes_copied += bytes; break;
+	case STRSAFE_EVENT_SCAN: counters->bytes_scanned += bytes; break;
+	}
+	if (strsafe_stats_hook_fn) {
+		strsafe_stats_hook_fn(strsafe_stats_hook_ctx, fn, event, bytes);
+	}
+}
+
+/**
+ * @brief Returns a copy of the calling thread's counters.
+ * @return The counters accumulated since the thread started or last called `strsafe_stats_reset`.
+ */
+static inline StrSafe_stats strsafe_stats_snapshot(void) {
+	return strsafe_stats_local;
+}
+
+/**
+ * @brief Clears the calling thread's counters.
+ */
+static inline void strsafe_stats_reset(void) {
+	memset(&strsafe_stats_local, 0, sizeof(strsafe_stats_local));
+}
+
+/**
+ * @brief Installs a callback that sees every counted event on every thread.
+ *
+ * The hook runs on the thread that caused the event, inside the library call, so it must
+ * not call back into instrumented functions. Install it before other threads use the
+ * library; `NULL` removes it.
+ *
+ * @param hook The callback, or `NULL`.
+ * @param ctx Passed to every call of `hook`.
+ */
+static inline void strsafe_stats_set_hook(StrSafe_stats_hook hook, void* ctx) {
+	strsafe_stats_hook_ctx = ctx;
+	strsafe_stats_hook_fn = hook;
+}
+
+/**
+ * @brief Returns a short name for a counter row, for reports.
+ * @param fn The row.
+ * @return Static string such as `"split"`.
+ */
+static inline const char* strsafe_stat_name(StrSafe_stat_fn fn) {
+	static const char* const names[STRSAFE_STAT_FUNCTIONS] = {
+		"heap", "ensure_capacity", "assign", "append", "find", "count", "replace", "split"
+	};
+	return (unsigned)fn < STRSAFE_STAT_FUNCTIONS ? names[fn] : "unknown";
+}
+
+#define STRSAFE_STAT(fn, event, bytes) strsafe_stats_record((fn), (event), (bytes))
+#define STRSAFE_STAT_SEARCH(fn, scanned) (strsafe_stats_record((fn), STRSAFE_EVENT_CALL, 0), strsafe_stats_record((fn), STRSAFE_EVENT_SCAN, (scanned)))
+
+#else
+
+#define STRSAFE_STAT(fn, event, bytes) ((void)0)
+#define STRSAFE_STAT_SEARCH(fn, scanned) ((void)0)
+
+#endif // STRSAFE_STATS
+
+/**
+ * @brief Allocates `size` bytes from `allocator`, or the default heap when it is `NULL`.
+ * @param allocator Allocator to use.
+ * @param size Number of bytes.
+ * @return Pointer to the block, or `NULL` on failure.
+ */
+static inline void* strsafe_mem_alloc(const StrSafe_allocator* allocator, size_t size) {
+	STRSAFE_STAT(STRSAFE_STAT_HEAP, STRSAFE_EVENT_ALLOC, size);
+#ifdef STRSAFE_POOL
+	return allocator ? allocator->alloc(allocator->ctx, size) : strsafe_pool_alloc(size);
+#else
+	return allocator ? allocator->alloc(allocator->ctx, size) : STRSAFE_MALLOC(size);
+#endif
+}
+
+/**
+ * @brief Resizes a block obtained from `allocator`.
+ * @param allocator Allocator the block came from.
+ * @param ptr Block to resize, or `NULL`.
+ * @param old_size Current size of the block.
+ * @param new_size Requested size.
+ * @return Pointer to the resized block, or `NULL` on failure (`ptr` stays valid).
+ */
+static inline void* strsafe_mem_realloc(const StrSafe_allocator* allocator, void* ptr, size_t old_size, size_t new_size) {
+	STRSAFE_STAT(STRSAFE_STAT_HEAP, ptr ? STRSAFE_EVENT_REALLOC : STRSAFE_EVENT_ALLOC, new_size);
+#ifdef STRSAFE_POOL
+	return allocator ? allocator->realloc(allocator->ctx, ptr, old_size, new_size) : strsafe_pool_realloc(ptr, old_size, new_size);
+#else
+	return allocator ? allocator->realloc(allocator->ctx, ptr, old_size, new_size) : STRSAFE_REALLOC(ptr, new_size);
+#endif
+}
+
+/**
+ * @brief Releases a block obtained from `allocator`.
+ * @param allocator Allocator the block came from.
+ * @param ptr Block to release, or `NULL`.
+ * @param size Size of the block.
+ */
+static inline void strsafe_mem_free(const StrSafe_allocator* allocator, void* ptr, size_t size) {
+	if (ptr) {
+		STRSAFE_STAT(STRSAFE_STAT_HEAP, STRSAFE_EVENT_FREE, size);
+	}
+	if (allocator) {
+		if (ptr) {
+			allocator->free(allocator->ctx, ptr, size);
+		}
+	}
+	else {
+#ifdef STRSAFE_POOL
+		strsafe_pool_free(ptr, size);
+#else
+		STRSAFE_FREE(ptr);
+#endif
+	}
+}
+
+static inline void* strsafe_arena_alloc_cb(void* ctx, size_t size) {
+	StrSafe_arena* arena = (StrSafe_arena*)ctx;
+	size_t align = STRSAFE_ALIGNOF(max_align_t);
+	size = (size + align - 1) & ~(align - 1);
+
+	StrSafe_arena_block* block = arena->head;
+	if (!block || block->size - block->used < size) {
+		size_t header = (sizeof(StrSafe_arena_block) + align - 1) & ~(align - 1);
+		size_t block_size = size > arena->block_size ? size : arena->block_size;
+		block = (StrSafe_arena_block*)STRSAFE_MALLOC(header + block_size);
+		if (!block) {
+			return NULL;
+		}
+		block->next = arena->head;
+		block->size = header + block_size;
+		block->used = header;
+		arena->head = block;
+	}
+
+	block->last = block->used;
+	block->used += size;
+	return (char*)block + block->last;
+}
+
+static inline void* strsafe_arena_realloc_cb(void* ctx, void* ptr, size_t old_size, size_t new_size) {
+	StrSafe_arena* arena = (StrSafe_arena*)ctx;
+	StrSafe_arena_block* block = arena->head;
+	if (!ptr) {
+		return strsafe_arena_alloc_cb(ctx, new_size);
+	}
+
+	// the most recent allocation can grow or shrink in place
+	if (block && (char*)ptr == (char*)block + block->last && new_size <= block->size - block->last) {
+		size_t align = STRSAFE_ALIGNOF(max_align_t);
+		block->used = block->last + ((new_size + align - 1) & ~(align - 1));
+		return ptr;
+	}
+	if (new_size <= old_size) {
+		return ptr;
+	}
+
+	void* moved = strsafe_arena_alloc_cb(ctx, new_size);
+	if (moved) {
+		memcpy(moved, ptr, old_size);
+	}
+	return moved;
+}
+
+static inline void strsafe_arena_free_cb(void* ctx, void* ptr, size_t size) {
+	StrSafe_arena* arena = (StrSafe_arena*)ctx;
+	StrSafe_arena_block* block = arena->head;
+	(void)size;
+	// only the most recent allocation can be given back before a reset
+	if (block && (char*)ptr == (char*)block + block->last) {
+		block->used = block->last;
+	}
+}
+
+/**
+ * @brief Initializes an empty arena.
+ * @param arena Arena to initialize.
+ * @param block_size Minimum size of each block, or 0 for `STRSAFE_ARENA_BLOCK_SIZE`.
+ */
+static inline void strsafe_arena_init(StrSafe_arena* arena, size_t block_size) {
+	arena->head = NULL;
+	arena->block_size = block_size ? block_size : STRSAFE_ARENA_BLOCK_SIZE;
+	arena->allocator.alloc = strsafe_arena_alloc_cb;
+	arena->allocator.realloc = strsafe_arena_realloc_cb;
+	arena->allocator.free = strsafe_arena_free_cb;
+	arena->allocator.ctx = arena;
+}
+
+/**
+ * @brief Returns the allocator that serves memory from `arena`.
+ * @param arena Initialized arena.
+ * @return Allocator to pass to `_ex` functions.
+ */
+static inline const StrSafe_allocator* strsafe_arena_allocator(StrSafe_arena* arena) {
+	return &arena->allocator;
+}
+
+/**
+ * @brief Releases every allocation made from the arena at once.
+ *
+ * The most recent block is kept for reuse; all others are freed. Strings and arrays that
+ * were built from the arena become invalid and must not be freed individually.
+ *
+ * @param arena Arena to reset.
+ */
+static inline void strsafe_arena_reset(StrSafe_arena* arena) {
+	StrSafe_arena_block* block = arena->head;
+	if (!block) {
+		return;
+	}
+	StrSafe_arena_block* next = block->next;
+	while (next) {
+		StrSafe_arena_block* victim = next;
+		next = next->next;
+		STRSAFE_FREE(victim);
+	}
+	size_t align = STRSAFE_ALIGNOF(max_align_t);
+	block->next = NULL;
+	block->used = (sizeof(StrSafe_arena_block) + align - 1) & ~(align - 1);
+	block->last = block->used;
+}
+
+/**
+ * @brief Frees all blocks owned by the arena.
+ * @param arena Arena to destroy; it is left empty and may be reused.
+ */
+static inline void strsafe_arena_destroy(StrSafe_arena* arena) {
+	while (arena->head) {
+		StrSafe_arena_block* next = arena->head->next;
+		STRSAFE_FREE(arena->head);
+		arena->head = next;
+	}
+}
+
+#ifdef STRSAFE_SSO
+
+/**
+ * @brief Tells whether a `StrSafe` keeps its contents inline.
+ * @param strsafe The string to inspect.
+ * @return `true` for inline strings, `false` for heap strings.
+ */
+static inline bool strsafe_is_inline(const StrSafe* strsafe) {
+	return ((unsigned char)strsafe->sso[STRSAFE_SSO_CAPACITY] & 0x80) == 0;
+}
+
+/**
+ * @brief Returns a writable pointer to the contents of a `StrSafe`.
+ * @param strsafe The string.
+ * @return Pointer to the first character.
+ */
+static inline char* strsafe_data(StrSafe* strsafe) {
+	if (strsafe_is_inline(strsafe)) return strsafe->sso;
+#ifdef STRSAFE_UTF8_CACHE
+	// handing out write access may change the contents
+	strsafe->cap &= ~STRSAFE_UTF8_FLAG;
+#endif
+	return strsafe->data;
+}
+
+/**
+ * @brief Returns the contents of a `StrSafe` as a C-string.
+ * @param strsafe The string.
+ * @return Pointer to the null-terminated contents.
+ */
+static inline const char* strsafe_cstr(const StrSafe* strsafe) {
+	return strsafe_is_inline(strsafe) ? strsafe->sso : strsafe->data;
+}
+
+/**
+ * @brief Returns the length of a `StrSafe`.
+ * @param strsafe The string.
+ * @return Length excluding the null terminator.
+ */
+static inline size_t strsafe_length(const StrSafe* strsafe) {
+	return strsafe_is_inline(strsafe) ? (unsigned char)strsafe->sso[STRSAFE_SSO_CAPACITY] : strsafe->len;
+}
+
+/**
+ * @brief Returns the capacity of a `StrSafe`.
+ * @param strsafe The string.
+ * @return Capacity including the null terminator.
+ */
+static inline size_t strsafe_capacity(const StrSafe* strsafe) {
+	return strsafe_is_inline(strsafe) ? STRSAFE_SSO_CAPACITY : (strsafe->cap & ~(STRSAFE_HEAP_FLAG | STRSAFE_SHARED_FLAG | STRSAFE_UTF8_FLAG));
+}
+
+/**
+ * @brief Records a new length without touching the contents.
+ * @param strsafe The string.
+ * @param len New length, which must fit the current capacity.
+ */
+static inline void strsafe_set_length(StrSafe* strsafe, size_t len) {
+	if (strsafe_is_inline(strsafe)) {
+		strsafe->sso[STRSAFE_SSO_CAPACITY] = (char)len;
+	}
+	else {
+		strsafe->len = len;
+#ifdef STRSAFE_UTF8_CACHE
+		strsafe->cap &= ~STRSAFE_UTF8_FLAG;
+#endif
+	}
+}
+
+/**
+ * @brief Points a `StrSafe` at a heap buffer it takes ownership of.
+ * @param strsafe The string, whose previous contents are discarded without freeing.
+ * @param data Heap buffer holding the null-terminated contents.
+ * @param len Length of the contents.
+ * @param cap Size of the buffer.
+ */
+static inline void strsafe_set_heap(StrSafe* strsafe, char* data, size_t len, size_t cap) {
+	strsafe->data = data;
+	strsafe->len = len;
+	strsafe->cap = cap | STRSAFE_HEAP_FLAG;
+}
+
+#else
+
+static inline bool strsafe_is_inline(const StrSafe* strsafe) {
+	(void)strsafe;
+	return false;
+}
+
+static inline char* strsafe_data(StrSafe* strsafe) {
+#ifdef STRSAFE_UTF8_CACHE
+	strsafe->cap &= ~STRSAFE_UTF8_FLAG;
+#endif
+	return strsafe->data;
+}
+
+static inline const char* strsafe_cstr(const StrSafe* strsafe) {
+	return strsafe->data;
+}
+
+static inline size_t strsafe_length(const StrSafe* strsafe) {
+	return strsafe->len;
+}
+
+static inline size_t strsafe_capacity(const StrSafe* strsafe) {
+	return strsafe->cap & ~(STRSAFE_SHARED_FLAG | STRSAFE_UTF8_FLAG);
+}
+
+static inline void strsafe_set_length(StrSafe* strsafe, size_t len) {
+	strsafe->len = len;
+#ifdef STRSAFE_UTF8_CACHE
+	strsafe->cap &= ~STRSAFE_UTF8_FLAG;
+#endif
+}
+
+static inline void strsafe_set_heap(StrSafe* strsafe, char* data, size_t len, size_t cap) {
+	strsafe->data = data;
+	strsafe->len = len;
+	strsafe->cap = cap;
+}
+
+#endif // STRSAFE_SSO
+
+/**
+ * @brief Initializes a `StrSafe` string to empty.
+ * @param strsafe Pointer to the `StrSafe` to initialize.
+ */
+static inline void strsafe_init(StrSafe* strsafe) {
+	strsafe->data = NULL;
+	strsafe->len = 0;
+	strsafe->cap = 0;
+}
+
+/**
+ * @brief Initializes a `StrSafe_array` string to empty.
+ * @param new_strsafe_array Pointer to the `StrSafe` to initialize.
+ */
+static inline void strsafe_array_init(StrSafe_array* new_strsafe_array) {
+	new_strsafe_array->arr = NULL;
+	new_strsafe_array->array_size = 0;
+	new_strsafe_array->capacity = 0;
+}
+
+/**
+ * @brief Tells whether a `StrSafe` points at a shared, reference-counted buffer.
+ * @param strsafe The string to inspect.
+ * @return `true` if the buffer came from `strsafe_share`.
+ */
+static inline bool strsafe_is_shared(const StrSafe* strsafe) {
+	return !strsafe_is_inline(strsafe) && (strsafe->cap & STRSAFE_SHARED_FLAG) != 0;
+}
+
+/**
+ * @brief Returns the header of a shared buffer.
+ * @param strsafe A string for which `strsafe_is_shared` is `true`.
+ * @return Pointer to the header in front of the contents.
+ */
+static inline StrSafe_shared* strsafe_shared_header(const StrSafe* strsafe) {
+	// step back through an integer: the optimizer cannot tell the buffer is shared and would
+	// otherwise flag the access as landing before a plain allocation
+	return (StrSafe_shared*)(void*)((uintptr_t)strsafe->data - sizeof(StrSafe_shared));
+}
+
+/**
+ * @brief Returns how many strings point at the buffer of `strsafe`.
+ * @param strsafe The string to inspect.
+ * @return The reference count, or 1 for a buffer that is not shared.
+ */
+static inline size_t strsafe_share_count(const StrSafe* strsafe) {
+	return strsafe_is_shared(strsafe) ? (size_t)STRSAFE_REF_LOAD(&strsafe_shared_header(strsafe)->refs) : 1;
+}
+
+/**
+ * @brief Drops one reference to a shared buffer, freeing it with the last one.
+ * @param strsafe A shared string; its fields are left untouched.
+ */
+static inline void strsafe_shared_release(StrSafe* strsafe) {
+	StrSafe_shared* shared = strsafe_shared_header(strsafe);
+	if (STRSAFE_REF_DEC(&shared->refs) == 0) {
+		strsafe_mem_free(shared->allocator, shared, sizeof(StrSafe_shared) + strsafe_capacity(strsafe));
+	}
+}
+
+/**
+ * @brief Frees memory used by a `StrSafe` string that was allocated from `allocator`.
+ *
+ * A shared buffer is only released when this was its last reference, through the
+ * allocator recorded by `strsafe_share_ex`.
+ *
+ * @param strsafe Pointer to the `StrSafe` to free.
+ * @param allocator Allocator the buffer came from, or `NULL` for the default heap.
+ */
+static inline void strsafe_free_ex(StrSafe* strsafe, const StrSafe_allocator* allocator) {
+	if (strsafe_is_shared(strsafe)) {
+		strsafe_shared_release(strsafe);
+	}
+	else if (!strsafe_is_inline(strsafe)) {
+		strsafe_mem_free(allocator, strsafe->data, strsafe_capacity(strsafe));
+	}
+	strsafe->data = NULL;
+	strsafe->len = 0;
+	strsafe->cap = 0;
+}
+
+/**
+ * @brief Frees memory used by a `StrSafe` string.
+ * @param strsafe Pointer to the `StrSafe` to free.
+ */
+static inline void strsafe_free(StrSafe* strsafe) {
+	strsafe_free_ex(strsafe, NULL);
+}
+
+/**
+ * @brief Replaces the contents of `dst` with `src`, leaving `src` empty.
+ * @param dst Destination string, freed first.
+ * @param src Source string whose buffer is taken over.
+ */
+static inline void strsafe_move(StrSafe* dst, StrSafe* src) {
+	strsafe_free(dst);
+	*dst = *src;
+	strsafe_init(src);
+}
+
+/**
+ * @brief Computes the capacity to allocate when a buffer of `cur_cap` must hold `min_cap` bytes.
+ *
+ * Applies `STRSAFE_GROWTH_POLICY` (or `STRSAFE_GROW_CAPACITY` when defined) and never
+ * returns less than `min_cap`. The result is clamped instead of overflowing `size_t`.
+ *
+ * @param cur_cap Current capacity of the buffer.
+ * @param min_cap Minimum required capacity.
+ * @return The capacity to allocate.
+ */
+static inline size_t strsafe_grow_capacity(size_t cur_cap, size_t min_cap) {
+#ifdef STRSAFE_GROW_CAPACITY
+	size_t new_cap = STRSAFE_GROW_CAPACITY(cur_cap, min_cap);
+	(void)cur_cap;
+#elif STRSAFE_GROWTH_POLICY == STRSAFE_GROWTH_EXACT
+	size_t new_cap = min_cap;
+	(void)cur_cap;
+#else
+	size_t first_cap = STRSAFE_MIN_CAPACITY;
+	size_t new_cap = cur_cap < first_cap ? first_cap : cur_cap;
+	while (new_cap < min_cap) {
+#if STRSAFE_GROWTH_POLICY == STRSAFE_GROWTH_1_5X
+		size_t step = new_cap / 2;
+#else
+		size_t step = new_cap;
+#endif
+		if (step == 0) {
+			step = 1;
+		}
+		if (new_cap > SIZE_MAX - step) {
+			new_cap = min_cap;
+			break;
+		}
+		new_cap += step;
+	}
+#endif
+	return new_cap < min_cap ? min_cap : new_cap;
+}
+
+/**
+ * @brief Reallocates the buffer of a string to exactly `new_cap` bytes using `allocator`.
+ *
+ * Moves inline contents to the heap when `STRSAFE_SSO` is enabled, and copies a shared
+ * buffer into a private one.
+ *
+ * @param src Pointer to the string.
+ * @param new_cap New capacity, at least the current length plus one.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ * @return `true` if successful, `false` if allocation failed.
+ */
+static inline bool strsafe_realloc_ex(StrSafe* src, size_t new_cap, const StrSafe_allocator* allocator) {
+#ifdef STRSAFE_POOL
+	if (!allocator) {
+		new_cap = strsafe_pool_size(new_cap);
+	}
+#endif
+	size_t old_cap = strsafe_capacity(src);
+	size_t len = strsafe_length(src);
+	char* new_data;
+
+	if (strsafe_is_inline(src) || strsafe_is_shared(src)) {
+		new_data = (char*)strsafe_mem_alloc(allocator, new_cap);
+		if (!new_data) {
+			return false;
+		}
+		memcpy(new_data, strsafe_cstr(src), len + 1);
+		old_cap = len + 1;
+		if (strsafe_is_shared(src)) {
+			strsafe_shared_release(src);
+		}
+	}
+	else {
+		new_data = (char*)strsafe_mem_realloc(allocator, src->data, old_cap, new_cap);
+		if (!new_data) {
+			return false;
+		}
+		if (!src->data) {
+			new_data[0] = '\0';
+		}
+	}
+
+#ifdef STRSAFE_ZERO_FILL
+	if (new_cap > old_cap) {
+		memset(new_data + old_cap, '\0', new_cap - old_cap);
+	}
+#else
+	(void)old_cap;
+#endif
+
+	strsafe_set_heap(src, new_data, len, new_cap);
+	return true;
+}
+
+/**
+ * @brief Reallocates the buffer of a string to exactly `new_cap` bytes.
+ *
+ * Moves inline contents to the heap when `STRSAFE_SSO` is enabled.
+ *
+ * @param src Pointer to the string.
+ * @param new_cap New capacity, at least the current length plus one.
+ * @return `true` if successful, `false` if allocation failed.
+ */
+static inline bool strsafe_realloc(StrSafe* src, size_t new_cap) {
+	return strsafe_realloc_ex(src, new_cap, NULL);
+}
+
+/**
+ * @brief Gives a shared string a buffer of its own before it is modified.
+ *
+ * The sole owner of a shared buffer from the same allocator keeps it: the contents move
+ * back over the header and no allocation happens. Otherwise the contents are copied
+ * into a new buffer of the same capacity from `allocator`.
+ *
+ * @param src Pointer to the string.
+ * @param allocator Allocator for the private buffer, or `NULL` for the default heap.
+ * @return `true` if `src` is now private, `false` if allocation failed (`src` is unchanged).
+ */
+static inline bool strsafe_unshare_ex(StrSafe* src, const StrSafe_allocator* allocator) {
+	if (!strsafe_is_shared(src)) {
+		return true;
+	}
+	StrSafe_shared* shared = strsafe_shared_header(src);
+	if (shared->allocator == allocator && STRSAFE_REF_LOAD(&shared->refs) == 1) {
+		char* block = (char*)shared;
+		size_t len = src->len;
+		memmove(block, src->data, len + 1);
+		strsafe_set_heap(src, block, len, sizeof(StrSafe_shared) + strsafe_capacity(src));
+		return true;
+	}
+	return strsafe_realloc_ex(src, strsafe_capacity(src), allocator);
+}
+
+/**
+ * @brief Gives a shared string a buffer of its own before it is modified.
+ * @param src Pointer to the string.
+ * @return `true` if `src` is now private, `false` if allocation failed.
+ */
+static inline bool strsafe_unshare(StrSafe* src) {
+	return strsafe_unshare_ex(src, NULL);
+}
+
+/**
+ * @brief Ensures the string has at least `min_cap` capacity, growing through `allocator`.
+ * @param src Pointer to the string.
+ * @param min_cap Minimum required capacity.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ * @return `true` if successful, `false` if allocation failed.
+ */
+static inline bool strsafe_ensure_capacity_ex(StrSafe* src, size_t min_cap, const StrSafe_allocator* allocator) {
+	STRSAFE_STAT(STRSAFE_STAT_ENSURE_CAPACITY, STRSAFE_EVENT_CALL, 0);
+	if (!strsafe_unshare_ex(src, allocator)) {
+		return false;
+	}
+	if (strsafe_capacity(src) >= min_cap) {
+		return true;
+	}
+
+	size_t new_cap = strsafe_grow_capacity(strsafe_capacity(src), min_cap);
+	STRSAFE_STAT(STRSAFE_STAT_ENSURE_CAPACITY, strsafe_capacity(src) ? STRSAFE_EVENT_REALLOC : STRSAFE_EVENT_ALLOC, new_cap);
+	STRSAFE_STAT(STRSAFE_STAT_ENSURE_CAPACITY, STRSAFE_EVENT_COPY, strsafe_length(src));
+	return strsafe_realloc_ex(src, new_cap, allocator);
+}
+
+/**
+ * @brief Ensures the string has at least `min_cap` capacity.
+ *
+ * Grows according to `strsafe_grow_capacity`, so the resulting capacity may exceed `min_cap`.
+ * New bytes are only zeroed when `STRSAFE_ZERO_FILL` is defined.
+ *
+ * @param strsafe Pointer to the string.
+ * @param min_cap Minimum required capacity.
+ * @return `true` if successful, `false` if allocation failed.
+ */
+static inline bool strsafe_ensure_capacity(StrSafe* src, size_t min_cap) {
+	return strsafe_ensure_capacity_ex(src, min_cap, NULL);
+}
+
+/**
+ * @brief Ensures the string has at least `min_cap` capacity, allocating exactly that much through `allocator`.
+ * @param src Pointer to the string.
+ * @param min_cap Exact capacity to allocate if the current one is smaller.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ * @return `true` if successful, `false` if allocation failed.
+ */
+static inline bool strsafe_reserve_ex(StrSafe* src, size_t min_cap, const StrSafe_allocator* allocator) {
+	STRSAFE_STAT(STRSAFE_STAT_ENSURE_CAPACITY, STRSAFE_EVENT_CALL, 0);
+	if (!strsafe_unshare_ex(src, allocator)) {
+		return false;
+	}
+	if (strsafe_capacity(src) >= min_cap) {
+		return true;
+	}
+	STRSAFE_STAT(STRSAFE_STAT_ENSURE_CAPACITY, strsafe_capacity(src) ? STRSAFE_EVENT_REALLOC : STRSAFE_EVENT_ALLOC, min_cap);
+	STRSAFE_STAT(STRSAFE_STAT_ENSURE_CAPACITY, STRSAFE_EVENT_COPY, strsafe_length(src));
+	return strsafe_realloc_ex(src, min_cap, allocator);
+}
+
+/**
+ * @brief Ensures the string has at least `min_cap` capacity without applying the growth policy.
+ * @param src Pointer to the string.
+ * @param min_cap Exact capacity to allocate if the current one is smaller.
+ * @return `true` if successful, `false` if allocation failed.
+ */
+static inline bool strsafe_reserve(StrSafe* src, size_t min_cap) {
+	return strsafe_reserve_ex(src, min_cap, NULL);
+}
+
+/**
+ * @brief Trims the capacity of a string allocated from `allocator` to fit its current length.
+ * @param src Pointer to the string.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ */
+static inline void strsafe_trim_ex(StrSafe* src, const StrSafe_allocator* allocator) {
+	if (strsafe_is_inline(src) || strsafe_is_shared(src)) {
+		return;
+	}
+#ifdef STRSAFE_SSO
+	if (src->len < STRSAFE_SSO_CAPACITY) {
+		char* heap = src->data;
+		size_t len = src->len;
+		size_t cap = strsafe_capacity(src);
+		memcpy(src->sso, heap, len + 1);
+		src->sso[STRSAFE_SSO_CAPACITY] = (char)len;
+		strsafe_mem_free(allocator, heap, cap);
+		return;
+	}
+#endif
+	if (src->len == 0) {
+		strsafe_mem_free(allocator, src->data, strsafe_capacity(src));
+		src->data = NULL;
+		src->cap = 0;
+		return;
+	}
+	char* trimmed = (char*)strsafe_mem_realloc(allocator, src->data, strsafe_capacity(src), src->len + 1);
+	if (trimmed) {
+		strsafe_set_heap(src, trimmed, src->len, src->len + 1);
+	}
+}
+
+/**
+ * @brief Trims the capacity of the string to fit its current length.
+ *
+ * With `STRSAFE_SSO`, heap strings short enough to fit inline are moved back into the struct.
+ * Shared buffers are left as they are.
+ *
+ * @param strsafe Pointer to the string.
+ */
+static inline void strsafe_trim(StrSafe* src) {
+	strsafe_trim_ex(src, NULL);
+}
+
+/**
+ * @brief Applies `STRSAFE_TRIM_POLICY` after an edit that shortened the string.
+ * @param src Pointer to the string.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ */
+static inline void strsafe_shrunk_ex(StrSafe* src, const StrSafe_allocator* allocator) {
+#if STRSAFE_TRIM_POLICY == STRSAFE_TRIM_ON_SHRINK
+	strsafe_trim_ex(src, allocator);
+#else
+	(void)src;
+	(void)allocator;
+#endif
+}
+
+/**
+ * @brief Moves the heap buffer of a string behind a `StrSafe_shared` header.
+ *
+ * The buffer is grown by the header size from `allocator` and its contents shifted up,
+ * so this costs one `realloc` and no extra allocation. Inline, empty and already shared
+ * strings are left as they are.
+ *
+ * @param src Pointer to the string.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ * @return `true` if successful, `false` if allocation failed (`src` is unchanged).
+ */
+static inline bool strsafe_make_shared_ex(StrSafe* src, const StrSafe_allocator* allocator) {
+	size_t cap = strsafe_capacity(src);
+	if (strsafe_is_inline(src) || strsafe_is_shared(src) || cap == 0) {
+		return true;
+	}
+	size_t len = src->len;
+	char* block = (char*)strsafe_mem_realloc(allocator, src->data, cap, sizeof(StrSafe_shared) + cap);
+	if (!block) {
+		return false;
+	}
+	memmove(block + sizeof(StrSafe_shared), block, len + 1);
+	StrSafe_shared* shared = (StrSafe_shared*)(void*)block;
+	STRSAFE_REF_INIT(&shared->refs, 1);
+	shared->allocator = allocator;
+	strsafe_set_heap(src, block + sizeof(StrSafe_shared), len, cap);
+	src->cap |= STRSAFE_SHARED_FLAG;
+	return true;
+}
+
+/**
+ * @brief Makes `dst` another reference to the contents of `src` without copying them.
+ *
+ * `src` is converted with `strsafe_make_shared_ex` the first time; later shares, and
+ * `strsafe_copy` of either string, only increment the count. Inline strings are copied
+ * by value instead.
+ *
+ * @param dst Destination string; its previous contents are freed.
+ * @param src Source string, which becomes shared.
+ * @param allocator Allocator owning both buffers, or `NULL` for the default heap.
+ * @return `true` if successful, `false` if allocation failed (both strings are unchanged).
+ */
+static inline bool strsafe_share_ex(StrSafe* dst, StrSafe* src, const StrSafe_allocator* allocator) {
+	if (dst == src) {
+		return true;
+	}
+	if (!strsafe_make_shared_ex(src, allocator)) {
+		return false;
+	}
+	strsafe_free_ex(dst, allocator);
+	if (strsafe_is_shared(src)) {
+		STRSAFE_REF_INC(&strsafe_shared_header(src)->refs);
+	}
+	*dst = *src;
+	return true;
+}
+
+/**
+ * @brief Makes `dst` another reference to the contents of `src` without copying them.
+ * @param dst Destination string; its previous contents are freed.
+ * @param src Source string, which becomes shared.
+ * @return `true` if successful, `false` if allocation failed.
+ */
+static inline bool strsafe_share(StrSafe* dst, StrSafe* src) {
+	return strsafe_share_ex(dst, src, NULL);
+}
+
+/**
+ * @brief Copies `len` bytes into an initialized `StrSafe`, growing it through `allocator`.
+ * @param dst Destination string.
+ * @param src Bytes to copy; they may not alias `dst`.
+ * @param len Number of bytes to copy.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ * @return Pointer to `dst`, or `NULL` on allocation failure.
+ */
+static inline StrSafe* strsafe_assign_ex(StrSafe* dst, const char* src, size_t len, const StrSafe_allocator* allocator) {
+	STRSAFE_STAT(STRSAFE_STAT_ASSIGN, STRSAFE_EVENT_CALL, 0);
+	if (len == SIZE_MAX || !strsafe_ensure_capacity_ex(dst, len + 1, allocator)) return NULL;
+	STRSAFE_STAT(STRSAFE_STAT_ASSIGN, STRSAFE_EVENT_COPY, len);
+
+	char* data = strsafe_data(dst);
+	if (len) memcpy(data, src, len);
+	data[len] = '\0';
+	strsafe_set_length(dst, len);
+	return dst;
+}
+
+/**
+ * @brief Copies `len` bytes into an initialized `StrSafe`, growing it as needed.
+ * @param dst Destination string.
+ * @param src Bytes to copy; they may not alias `dst`.
+ * @param len Number of bytes to copy.
+ * @return Pointer to `dst`, or `NULL` on allocation failure.
+ */
+static inline StrSafe* strsafe_assign(StrSafe* dst, const char* src, size_t len) {
+	return strsafe_assign_ex(dst, src, len, NULL);
+}
+
+/**
+ * @brief Initializes a `StrSafe` with an exact-size copy of `len` bytes taken from `allocator`.
+ * @param dst String to initialize.
+ * @param src Bytes to copy.
+ * @param len Number of bytes to copy.
+ * @param allocator Allocator for the buffer, or `NULL` for the default heap.
+ * @return `true` if successful, `false` if allocation failed (`dst` is left empty).
+ */
+static inline bool strsafe_init_from_ex(StrSafe* dst, const char* src, size_t len, const StrSafe_allocator* allocator) {
+	strsafe_init(dst);
+	if (!strsafe_reserve_ex(dst, len + 1, allocator)) return false;
+
+	char* data = strsafe_data(dst);
+	if (len) memcpy(data, src, len);
+	data[len] = '\0';
+	strsafe_set_length(dst, len);
+	return true;
+}
+
+/**
+ * @brief Initializes a `StrSafe` with an exact-size copy of `len` bytes.
+ * @param dst String to initialize.
+ * @param src Bytes to copy.
+ * @param len Number of bytes to copy.
+ * @return `true` if successful, `false` if allocation failed (`dst` is left empty).
+ */
+static inline bool strsafe_init_from(StrSafe* dst, const char* src, size_t len) {
+	return strsafe_init_from_ex(dst, src, len, NULL);
+}
+
+/**
+ * @brief Frees all strings in a `StrSafe_array` built from `allocator` and the array itself.
+ *
+ * Arrays built from an arena do not need this; `strsafe_arena_reset` releases them in bulk.
+ *
+ * @param strsafe_array Pointer to the array.
+ * @param allocator Allocator the array and its strings came from, or `NULL` for the default heap.
+ */
+static inline void strsafe_array_free_ex(StrSafe_array* strsafe_array, const StrSafe_allocator* allocator) {
+	for (int i = 0; i < strsafe_array->array_size; ++i) {
+		strsafe_free_ex(&strsafe_array->arr[i], allocator);
+	}
+	strsafe_mem_free(allocator, strsafe_array->arr, sizeof(StrSafe) * strsafe_array->capacity);
+	strsafe_array->arr = NULL;
+	strsafe_array->array_size = 0;
+	strsafe_array->capacity = 0;
+}
+
+/**
+ * @brief Frees all strings in a `StrSafe_array` and the array itself.
+ * @param strsafe_array Pointer to the array.
+ */
+static inline void strsafe_array_free(StrSafe_array* strsafe_array) {
+	strsafe_array_free_ex(strsafe_array, NULL);
+}
+
+/**
+ * @brief Makes room for at least `capacity` elements in an array built from `allocator`.
+ * @param strsafe_array Pointer to the array.
+ * @param capacity Number of elements to hold.
+ * @param allocator Allocator the array came from, or `NULL` for the default heap.
+ * @return `true` if successful, `false` on allocation failure (the array is unchanged).
+ */
+static inline bool strsafe_array_reserve_ex(StrSafe_array* strsafe_array, int capacity, const StrSafe_allocator* allocator) {
+	if (capacity <= strsafe_array->capacity) return true;
+
+	StrSafe* grown = (StrSafe*)strsafe_mem_realloc(allocator, strsafe_array->arr,
+		sizeof(StrSafe) * strsafe_array->capacity, sizeof(StrSafe) * capacity);
+	if (!grown) return false;
+	strsafe_array->arr = grown;
+	strsafe_array->capacity = capacity;
+	return true;
+}
+
+/**
+ * @brief Makes room for at least `capacity` elements in a `StrSafe_array`.
+ * @param strsafe_array Pointer to the array.
+ * @param capacity Number of elements to hold.
+ * @return `true` if successful, `false` on allocation failure (the array is unchanged).
+ */
+static inline bool strsafe_array_reserve(StrSafe_array* strsafe_array, int capacity) {
+	return strsafe_array_reserve_ex(strsafe_array, capacity, NULL);
+}
+
+/**
+ * @brief Appends a copy of `len` bytes of `src` to an array built from `allocator`.
+ *
+ * The element storage doubles when full, so a sequence of pushes is amortized O(1).
+ *
+ * @param strsafe_array Pointer to the array.
+ * @param src Bytes of the new element.
+ * @param len Number of bytes in `src`.
+ * @param allocator Allocator for the array and its strings, or `NULL` for the default heap.
+ * @return `true` if successful, `false` on allocation failure (the array is unchanged).
+ */
+static inline bool strsafe_array_push_ex(StrSafe_array* strsafe_array, const char* src, size_t len, const StrSafe_allocator* allocator) {
+	if (strsafe_array->array_size == strsafe_array->capacity) {
+		int new_cap = strsafe_array->capacity ? strsafe_array->capacity * 2 : 8;
+		if (!strsafe_array_reserve_ex(strsafe_array, new_cap, allocator)) return false;
+	}
+	if (!strsafe_init_from_ex(&strsafe_array->arr[strsafe_array->array_size], src, len, allocator)) return false;
+	strsafe_array->array_size++;
+	return true;
+}
+
+/**
+ * @brief Appends a copy of `len` bytes of `src` to a `StrSafe_array`.
+ * @param strsafe_array Pointer to the array.
+ * @param src Bytes of the new element.
+ * @param len Number of bytes in `src`.
+ * @return `true` if successful, `false` on allocation failure (the array is unchanged).
+ */
+static inline bool strsafe_array_push(StrSafe_array* strsafe_array, const char* src, size_t len) {
+	return strsafe_array_push_ex(strsafe_array, src, len, NULL);
+}
+
+/**
+ * @brief Portable search kernel: `memchr` for the first byte, `memcmp` for the rest.
+ * @param haystack Bytes to search.
+ * @param haystack_len Number of bytes in `haystack`.
+ * @param needle Bytes to find.
+ * @param needle_len Number of bytes in `needle`; must not be 0.
+ * @return Pointer to the first match, or `NULL` if not found.
+ */
+static inline const char* strsafe_memmem_scalar(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+	if (needle_len > haystack_len) return NULL;
+
+	const char* last = haystack + (haystack_len - needle_len);
+	const char* p = haystack;
+	while (p <= last) {
+		p = (const char*)memchr(p, needle[0], last - p + 1);
+		if (!p) return NULL;
+		if (memcmp(p + 1, needle + 1, needle_len - 1) == 0) return p;
+		++p;
+	}
+	return NULL;
+}
+
+/**
+ * @brief Index of the lowest set bit of a non-zero mask.
+ * @param mask Non-zero mask.
+ * @return Bit index.
+ */
+static inline unsigned strsafe_ctz64(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned)__builtin_ctzll(mask);
+#elif defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return (unsigned)index;
+#else
+	unsigned index = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		++index;
+	}
+	return index;
+#endif
+}
+
+#ifdef STRSAFE_HAVE_SSE2
+/**
+ * @brief SSE2 kernel: filters 16 candidate positions at a time on the needle's first and last byte.
+ * @param haystack Bytes to search.
+ * @param haystack_len Number of bytes in `haystack`.
+ * @param needle Bytes to find.
+ * @param needle_len Number of bytes in `needle`; must be at least 2.
+ * @return Pointer to the first match, or `NULL` if not found.
+ */
+static inline const char* strsafe_memmem_sse2(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+	if (needle_len > haystack_len) return NULL;
+
+	const __m128i first = _mm_set1_epi8(needle[0]);
+	const __m128i last = _mm_set1_epi8(needle[needle_len - 1]);
+	size_t i = 0;
+	for (; i + needle_len + 15 <= haystack_len; i += 16) {
+		__m128i block_first = _mm_loadu_si128((const __m128i*)(haystack + i));
+		__m128i block_last = _mm_loadu_si128((const __m128i*)(haystack + i + needle_len - 1));
+		__m128i eq = _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last));
+		uint64_t mask = (unsigned)_mm_movemask_epi8(eq);
+		while (mask) {
+			size_t pos = i + strsafe_ctz64(mask);
+			if (memcmp(haystack + pos + 1, needle + 1, needle_len - 2) == 0) return haystack + pos;
+			mask &= mask - 1;
+		}
+	}
+	return strsafe_memmem_scalar(haystack + i, haystack_len - i, needle, needle_len);
+}
+#endif
+
+#ifdef STRSAFE_HAVE_AVX2
+/**
+ * @brief AVX2 kernel: filters 32 candidate positions at a time on the needle's first and last byte.
+ * @param haystack Bytes to search.
+ * @param haystack_len Number of bytes in `haystack`.
+ * @param needle Bytes to find.
+ * @param needle_len Number of bytes in `needle`; must be at least 2.
+ * @return Pointer to the first match, or `NULL` if not found.
+ */
+STRSAFE_AVX2_TARGET
+static inline const char* strsafe_memmem_avx2(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+	if (needle_len > haystack_len) return NULL;
+
+	const __m256i first = _mm256_set1_epi8(needle[0]);
+	const __m256i last = _mm256_set1_epi8(needle[needle_len - 1]);
+	size_t i = 0;
+	for (; i + needle_len + 31 <= haystack_len; i += 32) {
+		__m256i block_first = _mm256_loadu_si256((const __m256i*)(haystack + i));
+		__m256i block_last = _mm256_loadu_si256((const __m256i*)(haystack + i + needle_len - 1));
+		__m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last));
+		uint64_t mask = (uint32_t)_mm256_movemask_epi8(eq);
+		while (mask) {
+			size_t pos = i + strsafe_ctz64(mask);
+			if (memcmp(haystack + pos + 1, needle + 1, needle_len - 2) == 0) return haystack + pos;
+			mask &= mask - 1;
+		}
+	}
+	return strsafe_memmem_scalar(haystack + i, haystack_len - i, needle, needle_len);
+}
+
+/**
+ * @brief Tells whether the AVX2 kernel can run on this CPU.
+ * @return `true` if AVX2 is available.
+ */
+static inline bool strsafe_cpu_has_avx2(void) {
+#if !defined(STRSAFE_AVX2_RUNTIME)
+	return true;
+#elif defined(__GNUC__) || defined(__clang__)
+	return __builtin_cpu_supports("avx2");
+#else
+	static int cached = -1;
+	if (cached < 0) {
+		int regs[4];
+		__cpuid(regs, 1);
+		bool os_saves_ymm = (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+		__cpuidex(regs, 7, 0);
+		cached = os_saves_ymm && (regs[1] & (1 << 5));
+	}
+	return cached != 0;
+#endif
+}
+#endif
+
+#ifdef STRSAFE_HAVE_NEON
+/**
+ * @brief NEON kernel: filters 16 candidate positions at a time on the needle's first and last byte.
+ * @param haystack Bytes to search.
+ * @param haystack_len Number of bytes in `haystack`.
+ * @param needle Bytes to find.
+ * @param needle_len Number of bytes in `needle`; must be at least 2.
+ * @return Pointer to the first match, or `NULL` if not found.
+ */
+static inline const char* strsafe_memmem_neon(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+	if (needle_len > haystack_len) return NULL;
+
+	const uint8x16_t first = vdupq_n_u8((uint8_t)needle[0]);
+	const uint8x16_t last = vdupq_n_u8((uint8_t)needle[needle_len - 1]);
+	size_t i = 0;
+	for (; i + needle_len + 15 <= haystack_len; i += 16) {
+		uint8x16_t block_first = vld1q_u8((const uint8_t*)(haystack + i));
+		uint8x16_t block_last = vld1q_u8((const uint8_t*)(haystack + i + needle_len - 1));
+		uint8x16_t eq = vandq_u8(vceqq_u8(first, block_first), vceqq_u8(last, block_last));
+		// narrow to 4 bits per byte so the 16 lanes fit one 64-bit mask
+		uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+		while (mask) {
+			unsigned bit = strsafe_ctz64(mask);
+			size_t pos = i + (bit >> 2);
+			if (memcmp(haystack + pos + 1, needle + 1, needle_len - 2) == 0) return haystack + pos;
+			mask &= ~((uint64_t)0xF << (bit & ~3u));
+		}
+	}
+	return strsafe_memmem_scalar(haystack + i, haystack_len - i, needle, needle_len);
+}
+#endif
+
+/**
+ * @brief Finds `needle` in `haystack` using their lengths rather than null terminators.
+ *
+ * Every search in this header goes through here. Single-byte needles use `memchr`;
+ * longer ones use the widest SIMD kernel the build and CPU support, falling back to
+ * `strsafe_memmem_scalar`.
+ *
+ * @param haystack Bytes to search.
+ * @param haystack_len Number of bytes in `haystack`.
+ * @param needle Bytes to find.
+ * @param needle_len Number of bytes in `needle`.
+ * @return Pointer to the first match, or `NULL` if not found. An empty needle matches at `haystack`.
+ */
+static inline const char* strsafe_memmem(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+	if (needle_len == 0) return haystack;
+	if (needle_len > haystack_len) return NULL;
+	if (needle_len == 1) return (const char*)memchr(haystack, needle[0], haystack_len);
+
+#if defined(STRSAFE_HAVE_AVX2)
+	if (haystack_len >= needle_len + 31 && strsafe_cpu_has_avx2()) {
+		return strsafe_memmem_avx2(haystack, haystack_len, needle, needle_len);
+	}
+#endif
+#if defined(STRSAFE_HAVE_SSE2)
+	return strsafe_memmem_sse2(haystack, haystack_len, needle, needle_len);
+#elif defined(STRSAFE_HAVE_NEON)
+	return strsafe_memmem_neon(haystack, haystack_len, needle, needle_len);
+#else
+	return strsafe_memmem_scalar(haystack, haystack_len, needle, needle_len);
+#endif
+}
+
+/**
+ * @brief Prepares `len` bytes of `bytes` for repeated searching.
+ *
+ * Needles of at least `STRSAFE_NEEDLE_SKIP_MIN` bytes get a Boyer-Moore-Horspool skip
+ * table; by default only scalar builds use it, since the SIMD first/last byte filter is
+ * faster at every length. The AVX2 CPU check is done here once instead of per search.
+ *
+ * @param needle Needle to initialize.
+ * @param bytes Bytes to find; not copied, they must outlive `needle`.
+ * @param len Number of bytes in `bytes`.
+ */
+static inline void strsafe_needle_init(StrSafe_needle* needle, const char* bytes, size_t len) {
+	needle->ptr = bytes;
+	needle->len = len;
+	needle->use_skip = len >= 2 && len >= STRSAFE_NEEDLE_SKIP_MIN;
+#if defined(STRSAFE_HAVE_AVX2)
+	needle->use_avx2 = len >= 2 && strsafe_cpu_has_avx2();
+#else
+	needle->use_avx2 = false;
+#endif
+	if (needle->use_skip) {
+		for (int b = 0; b < 256; ++b) {
+			needle->skip[b] = len;
+		}
+		for (size_t i = 0; i + 1 < len; ++i) {
+			needle->skip[(uint8_t)bytes[i]] = len - 1 - i;
+		}
+	}
+}
+
+/**
+ * @brief Prepares the contents of a `StrSafe` string for repeated searching.
+ * @param needle Needle to initialize.
+ * @param src String to find; it must not be modified or freed while `needle` is used.
+ */
+static inline void strsafe_needle_of(StrSafe_needle* needle, const StrSafe* src) {
+	strsafe_needle_init(needle, strsafe_cstr(src), strsafe_length(src));
+}
+
+/**
+ * @brief Boyer-Moore-Horspool kernel: compares the last byte and shifts by the skip table.
+ * @param haystack Bytes to search.
+ * @param haystack_len Number of bytes in `haystack`.
+ * @param needle Needle with a skip table, at least 2 bytes long.
+ * @return Pointer to the first match, or `NULL` if not found.
+ */
+static inline const char* strsafe_memmem_horspool(const char* haystack, size_t haystack_len, const StrSafe_needle* needle) {
+	size_t last = needle->len - 1;
+	uint8_t last_byte = (uint8_t)needle->ptr[last];
+	size_t i = 0;
+	while (i + last < haystack_len) {
+		uint8_t b = (uint8_t)haystack[i + last];
+		if (b == last_byte && memcmp(haystack + i, needle->ptr, last) == 0) return haystack + i;
+		i += needle->skip[b];
+	}
+	return NULL;
+}
+
+/**
+ * @brief Finds a prepared needle in `haystack_len` bytes of `haystack`.
+ *
+ * Same result as `strsafe_memmem`, without the per-call kernel selection.
+ *
+ * @param haystack Bytes to search.
+ * @param haystack_len Number of bytes in `haystack`.
+ * @param needle Prepared needle.
+ * @return Pointer to the first match, or `NULL` if not found. An empty needle matches at `haystack`.
+ */
+static inline const char* strsafe_needle_search(const char* haystack, size_t haystack_len, const StrSafe_needle* needle) {
+	size_t needle_len = needle->len;
+	if (needle_len == 0) return haystack;
+	if (needle_len > haystack_len) return NULL;
+	if (needle_len == 1) return (const char*)memchr(haystack, needle->ptr[0], haystack_len);
+	if (needle->use_skip) return strsafe_memmem_horspool(haystack, haystack_len, needle);
+
+#if defined(STRSAFE_HAVE_AVX2)
+	if (needle->use_avx2 && haystack_len >= needle_len + 31) {
+		return strsafe_memmem_avx2(haystack, haystack_len, needle->ptr, needle_len);
+	}
+#endif
+#if defined(STRSAFE_HAVE_SSE2)
+	return strsafe_memmem_sse2(haystack, haystack_len, needle->ptr, needle_len);
+#elif defined(STRSAFE_HAVE_NEON)
+	return strsafe_memmem_neon(haystack, haystack_len, needle->ptr, needle_len);
+#else
+	return strsafe_memmem_scalar(haystack, haystack_len, needle->ptr, needle_len);
+#endif
+}
+
+/**
+ * @brief Finds the first occurrence of a prepared needle in a `StrSafe` string.
+ * @param haystack The string to search.
+ * @param needle Prepared needle.
+ * @return Position of the first match, or -1 if not found.
+ */
+static inline ssize_t strsafe_needle_find(const StrSafe* haystack, const StrSafe_needle* needle) {
+	const char* data = strsafe_cstr(haystack);
+	const char* pos = strsafe_needle_search(data, strsafe_length(haystack), needle);
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_FIND, pos ? (size_t)(pos - data) + needle->len : strsafe_length(haystack));
+	return pos ? (ssize_t)(pos - data) : -1;
+}
+
+/**
+ * @brief Finds the first occurrence of a prepared needle starting from a given position.
+ * @param haystack The string to search.
+ * @param needle Prepared needle.
+ * @param pos The position to start searching from.
+ * @return Position of the first match, or -1 if not found.
+ */
+static inline ssize_t strsafe_needle_find_from_pos(const StrSafe* haystack, const StrSafe_needle* needle, size_t pos) {
+	size_t len = strsafe_length(haystack);
+	if (pos >= len) return -1;
+	const char* data = strsafe_cstr(haystack);
+	const char* found = strsafe_needle_search(data + pos, len - pos, needle);
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_FIND, found ? (size_t)(found - data) - pos + needle->len : len - pos);
+	return found ? (ssize_t)(found - data) : -1;
+}
+
+/**
+ * @brief Finds the first occurrence of `needle_len` bytes of `needle` in a `StrSafe` string.
+ *
+ * Searches the full `len` of the haystack, including embedded null bytes.
+ *
+ * @param haystack The string to search.
+ * @param needle The bytes to find.
+ * @param needle_len Number of bytes in `needle`.
+ * @return Position of the first match, or -1 if not found.
+ */
+static inline ssize_t cstr_find_n(const StrSafe* haystack, const char* needle, size_t needle_len) {
+	const char* data = strsafe_cstr(haystack);
+	const char* pos = strsafe_memmem(data, strsafe_length(haystack), needle, needle_len);
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_FIND, pos ? (size_t)(pos - data) + needle_len : strsafe_length(haystack));
+	return pos ? (ssize_t)(pos - data) : -1;
+}
+
+/**
+ * @brief Finds the first occurrence of a substring in a `StrSafe` string.
+ *
+ * @param haystack The string to search.
+ * @param needle The substring to find.
+ * @return Position of the first match, or -1 if not found.
+ */
+static inline ssize_t cstr_find(StrSafe* haystack, const char* needle) {
+	return cstr_find_n(haystack, needle, strlen(needle));
+}
+
+/**
+ * @brief Replaces the first occurrence of a substring with another in a `StrSafe` string.
+ *
+ * This function allocates a new buffer sized exactly for the result and replaces
+ * the first match of `old_str` with `new_str`. Memory is freed before exiting.
+ *
+ * @param dst The target string to modify.
+ * @param old_str The substring to be replaced.
+ * @param new_str The replacement string.
+ * @return Pointer to `dst`, or `NULL` on allocation failure.
+ */
+static inline StrSafe* cstr_replace(StrSafe* dst, const char* old_str, const char* new_str) {
+	ssize_t pos = cstr_find(dst, old_str);
+	if (pos < 0) return dst;
+
+	const char* data = strsafe_cstr(dst);
+	size_t len = strsafe_length(dst);
+	size_t old_len = strlen(old_str);
+	size_t new_len = strlen(new_str);
+	size_t final_len = len - old_len + new_len;
+
+	StrSafe result;
+	strsafe_init(&result);
+	if (!strsafe_reserve(&result, final_len + 1)) return NULL;
+	char* buffer = strsafe_data(&result);
+
+	memcpy(buffer, data, pos);
+	memcpy(buffer + pos, new_str, new_len);
+	memcpy(buffer + pos + new_len, data + pos + old_len, len - pos - old_len);
+	buffer[final_len] = '\0';
+	strsafe_set_length(&result, final_len);
+
+	strsafe_move(dst, &result);
+	return dst;
+}
+
+/**
+ * @brief Counts non-overlapping occurrences of a prepared needle in a `StrSafe` string.
+ * @param haystack The string to search.
+ * @param needle Prepared needle; an empty needle counts as 0.
+ * @return Number of occurrences found.
+ */
+static inline size_t strsafe_needle_count(const StrSafe* haystack, const StrSafe_needle* needle) {
+	if (needle->len == 0) return 0;
+	size_t count = 0;
+	const char* p = strsafe_cstr(haystack);
+	const char* end = p + strsafe_length(haystack);
+	while ((p = strsafe_needle_search(p, end - p, needle))) {
+		++count;
+		p += needle->len;
+	}
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_COUNT, strsafe_length(haystack));
+	return count;
+}
+
+/**
+ * @brief Counts non-overlapping occurrences of `needle_len` bytes of `needle` in a `StrSafe` string.
+ *
+ * @param haystack The string to search.
+ * @param needle The bytes to count; an empty needle counts as 0.
+ * @param needle_len Number of bytes in `needle`.
+ * @return Number of occurrences found.
+ */
+static inline size_t cstr_count_n(const StrSafe* haystack, const char* needle, size_t needle_len) {
+	StrSafe_needle prepared;
+	strsafe_needle_init(&prepared, needle, needle_len);
+	return strsafe_needle_count(haystack, &prepared);
+}
+
+/**
+ * @brief Counts the number of times a substring appears in a `StrSafe` string.
+ *
+ * @param haystack The string to search.
+ * @param needle The substring to count.
+ * @return Number of occurrences found.
+ */
+static inline size_t cstr_count(const StrSafe* haystack, const char* needle) {
+	return cstr_count_n(haystack, needle, strlen(needle));
+}
+
+/**
+ * @brief Replaces every match in `len` bytes of `data` in place, for replacements no longer than the pattern.
+ *
+ * Scans forward once; writes trail the search position, so no second buffer is needed.
+ *
+ * @param data The buffer to rewrite; it is not null-terminated by this function.
+ * @param len Number of bytes in `data`.
+ * @param old_str Prepared needle for the bytes to be replaced; must not be empty.
+ * @param new_str The replacement bytes; must not point into `data`.
+ * @param new_len Number of bytes in `new_str`, at most `old_str->len`.
+ * @return The new length of `data`.
+ */
+static inline size_t strsafe_replace_all_inplace(char* data, size_t len, const StrSafe_needle* old_str, const char* new_str, size_t new_len) {
+	size_t old_len = old_str->len;
+	const char* src = data;
+	const char* end = data + len;
+	char* out = data;
+	const char* match;
+	while ((match = strsafe_needle_search(src, end - src, old_str))) {
+		if (out != src) {
+			memmove(out, src, match - src);
+		}
+		out += match - src;
+		memcpy(out, new_str, new_len);
+		out += new_len;
+		src = match + old_len;
+	}
+	if (out != src) {
+		memmove(out, src, end - src);
+	}
+	return (out - data) + (end - src);
+}
+
+/**
+ * @brief Replaces all occurrences of a prepared needle with `new_len` bytes of `new_str`.
+ *
+ * When the replacement is not longer than the pattern the string is rewritten in place
+ * and keeps its buffer. Otherwise the match offsets found in a single scan are kept
+ * (on the stack for up to `STRSAFE_MATCH_STACK` matches) and reused to build the result
+ * in one exact-size allocation, copying the gaps between matches with `memcpy`.
+ *
+ * @param dst The target string to modify.
+ * @param old_str Prepared needle for the bytes to be replaced; an empty needle leaves `dst` unchanged.
+ * @param new_str The replacement bytes; neither pattern may point into `dst`.
+ * @param new_len Number of bytes in `new_str`.
+ * @return Pointer to `dst`, or `NULL` on allocation failure.
+ */
+static inline StrSafe* strsafe_needle_replace_all(StrSafe* dst, const StrSafe_needle* old_str, const char* new_str, size_t new_len) {
+	size_t old_len = old_str->len;
+	if (old_len == 0) return dst;
+
+	size_t len = strsafe_length(dst);
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_REPLACE, len);
+	if (new_len <= old_len) {
+		if (strsafe_is_shared(dst)) {
+			if (!strsafe_needle_search(strsafe_cstr(dst), len, old_str)) return dst;
+			if (!strsafe_unshare(dst)) return NULL;
+		}
+		char* data = strsafe_data(dst);
+		size_t final_len = strsafe_replace_all_inplace(data, len, old_str, new_str, new_len);
+		STRSAFE_STAT(STRSAFE_STAT_REPLACE, STRSAFE_EVENT_COPY, final_len);
+		if (final_len != len) {
+			data[final_len] = '\0';
+			strsafe_set_length(dst, final_len);
+		}
+		return dst;
+	}
+
+	const char* src = strsafe_cstr(dst);
+	const char* end = src + len;
+	size_t stack_offsets[STRSAFE_MATCH_STACK];
+	size_t* offsets = stack_offsets;
+	size_t offsets_cap = STRSAFE_MATCH_STACK;
+	size_t count = 0;
+	const char* match;
+	const char* p = src;
+	while ((match = strsafe_needle_search(p, end - p, old_str))) {
+		if (count == offsets_cap) {
+			size_t* grown = offsets == stack_offsets ? (size_t*)STRSAFE_MALLOC(sizeof(size_t) * offsets_cap * 2)
+				: (size_t*)STRSAFE_REALLOC(offsets, sizeof(size_t) * offsets_cap * 2);
+			if (!grown) {
+				if (offsets != stack_offsets) STRSAFE_FREE(offsets);
+				return NULL;
+			}
+			if (offsets == stack_offsets) memcpy(grown, stack_offsets, sizeof(stack_offsets));
+			offsets = grown;
+			offsets_cap *= 2;
+		}
+		offsets[count++] = match - src;
+		p = match + old_len;
+	}
+	if (count == 0) return dst;
+
+	size_t final_len = len + count * (new_len - old_len);
+	StrSafe result;
+	strsafe_init(&result);
+	if (!strsafe_reserve(&result, final_len + 1)) {
+		if (offsets != stack_offsets) STRSAFE_FREE(offsets);
+		return NULL;
+	}
+
+	char* out = strsafe_data(&result);
+	size_t copied = 0;
+	for (size_t i = 0; i < count; ++i) {
+		memcpy(out, src + copied, offsets[i] - copied);
+		out += offsets[i] - copied;
+		memcpy(out, new_str, new_len);
+		out += new_len;
+		copied = offsets[i] + old_len;
+	}
+	memcpy(out, src + copied, len - copied);
+	out[len - copied] = '\0';
+	strsafe_set_length(&result, final_len);
+	STRSAFE_STAT(STRSAFE_STAT_REPLACE, STRSAFE_EVENT_COPY, final_len);
+
+	if (offsets != stack_offsets) STRSAFE_FREE(offsets);
+	strsafe_move(dst, &result);
+	return dst;
+}
+
+/**
+ * @brief Replaces all occurrences of `old_len` bytes of `old_str` with `new_len` bytes of `new_str`.
+ *
+ * Prepares `old_str` as a `StrSafe_needle` and runs `strsafe_needle_replace_all`.
+ *
+ * @param dst The target string to modify.
+ * @param old_str The bytes to be replaced; an empty pattern leaves `dst` unchanged.
+ * @param old_len Number of bytes in `old_str`.
+ * @param new_str The replacement bytes; neither pattern may point into `dst`.
+ * @param new_len Number of bytes in `new_str`.
+ * @return Pointer to `dst`, or `NULL` on allocation failure.
+ */
+static inline StrSafe* cstr_replace_all_n(StrSafe* dst, const char* old_str, size_t old_len, const char* new_str, size_t new_len) {
+	StrSafe_needle prepared;
+	strsafe_needle_init(&prepared, old_str, old_len);
+	return strsafe_needle_replace_all(dst, &prepared, new_str, new_len);
+}
+
+/**
+ * @brief Replaces all occurrences of a substring with another in a `StrSafe` string.
+ *
+ * All matches of `old_str` are replaced with `new_str` in a single scan. Replacements
+ * that are not longer than the pattern are done in place; otherwise the result is
+ * built in a single allocation.
+ *
+ * @param dst The target string to modify.
+ * @param old_str The substring to be replaced.
+ * @param new_str The replacement string.
+ * @return Pointer to `dst`, or `NULL` on allocation failure.
+ */
+static inline StrSafe* cstr_replace_all(StrSafe* dst, const char* old_str, const char* new_str) {
+	return cstr_replace_all_n(dst, old_str, strlen(old_str), new_str, strlen(new_str));
+}
+
+/**
+ * @brief Finds the first occurrence of `needle_len` bytes of `needle` starting from a given position.
+ *
+ * @param haystack The string to search.
+ * @param needle The bytes to find.
+ * @param needle_len Number of bytes in `needle`.
+ * @param pos The position to start searching from.
+ * @return Position of the first match, or -1 if not found.
+ */
+static inline ssize_t cstr_find_from_pos_n(const StrSafe* haystack, const char* needle, size_t needle_len, size_t pos) {
+	size_t len = strsafe_length(haystack);
+	if (pos >= len) return -1;
+	const char* data = strsafe_cstr(haystack);
+	const char* found = strsafe_memmem(data + pos, len - pos, needle, needle_len);
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_FIND, found ? (size_t)(found - data) - pos + needle_len : len - pos);
+	return found ? (ssize_t)(found - data) : -1;
+}
+
+/**
+ * @brief Finds the first occurrence of a substring starting from a given position.
+ *
+ * @param haystack The string to search.
+ * @param needle The substring to find.
+ * @param pos The position to start searching from.
+ * @return Position of the first match, or -1 if not found.
+ */
+static inline ssize_t cstr_find_from_pos(StrSafe* haystack, const char* needle, size_t pos) {
+	return cstr_find_from_pos_n(haystack, needle, strlen(needle), pos);
+}
+
+/**
+ * @brief Compares a `StrSafe` string with a C-string for equality.
+ *
+ * @param a The `StrSafe` string.
+ * @param b The C-string.
+ * @return `true` if the strings are equal, `false` otherwise.
+ */
+static inline bool cstr_compare(const StrSafe* a, const char* b) {
+	return strcmp(strsafe_cstr(a), b) == 0;
+}
+
+/**
+ * @brief Removes the first occurrence of a substring from a `StrSafe` string.
+ *
+ * This function shifts the remaining content in place and keeps the capacity unless
+ * `STRSAFE_TRIM_POLICY` says otherwise.
+ *
+ * @param dst The target string to modify.
+ * @param str_to_remove The substring to remove.
+ * @return Pointer to `dst`.
+ */
+static inline StrSafe* cstr_remove(StrSafe* dst, const char* str_to_remove) {
+	ssize_t pos = cstr_find(dst, str_to_remove);
+	if (pos < 0) return dst;
+	if (!strsafe_unshare(dst)) return NULL;
+
+	char* data = strsafe_data(dst);
+	size_t len = strsafe_length(dst);
+	size_t rem_len = strlen(str_to_remove);
+	memmove(data + pos, data + pos + rem_len, len - pos - rem_len + 1);
+	strsafe_set_length(dst, len - rem_len);
+	strsafe_shrunk_ex(dst, NULL);
+	return dst;
+}
+
+/**
+ * @brief Removes all occurrences of a prepared needle from a `StrSafe` string.
+ *
+ * This function performs in-place removal in a single scan, moving the gaps between
+ * matches with `memmove`, and keeps the capacity unless `STRSAFE_TRIM_POLICY` says otherwise.
+ *
+ * @param dst The target string to modify.
+ * @param str_to_remove Prepared needle for the bytes to remove; an empty needle removes nothing.
+ * @return Pointer to `dst`.
+ */
+static inline StrSafe* strsafe_needle_remove_all(StrSafe* dst, const StrSafe_needle* str_to_remove) {
+	if (strsafe_is_shared(dst) && str_to_remove->len > 0) {
+		// copy a shared buffer only when something will actually be removed
+		if (!strsafe_needle_search(strsafe_cstr(dst), strsafe_length(dst), str_to_remove)) return dst;
+		if (!strsafe_unshare(dst)) return NULL;
+	}
+	if (str_to_remove->len > 0) {
+		char* data = strsafe_data(dst);
+		size_t len = strsafe_length(dst);
+		size_t final_len = strsafe_replace_all_inplace(data, len, str_to_remove, "", 0);
+		if (final_len != len) {
+			data[final_len] = '\0';
+			strsafe_set_length(dst, final_len);
+		}
+	}
+	strsafe_shrunk_ex(dst, NULL);
+	return dst;
+}
+
+/**
+ * @brief Removes all occurrences of `rem_len` bytes of `str_to_remove` from a `StrSafe` string.
+ *
+ * This function performs in-place removal in a single scan, moving the gaps between
+ * matches with `memmove`, and keeps the capacity unless `STRSAFE_TRIM_POLICY` says otherwise.
+ *
+ * @param dst The target string to modify.
+ * @param str_to_remove The bytes to remove; an empty pattern removes nothing.
+ * @param rem_len Number of bytes in `str_to_remove`.
+ * @return Pointer to `dst`.
+ */
+static inline StrSafe* cstr_remove_all_n(StrSafe* dst, const char* str_to_remove, size_t rem_len) {
+	StrSafe_needle prepared;
+	strsafe_needle_init(&prepared, str_to_remove, rem_len);
+	return strsafe_needle_remove_all(dst, &prepared);
+}
+
+/**
+ * @brief Removes all occurrences of a substring from a `StrSafe` string.
+ *
+ * This function performs in-place removal and keeps the capacity unless
+ * `STRSAFE_TRIM_POLICY` says otherwise.
+ *
+ * @param dst The target string to modify.
+ * @param str_to_remove The substring to remove.
+ * @return Pointer to `dst`.
+ */
+static inline StrSafe* cstr_remove_all(StrSafe* dst, const char* str_to_remove) {
+	return cstr_remove_all_n(dst, str_to_remove, strlen(str_to_remove));
+}
+
+/**
+ * @brief Appends `suffix_len` bytes of `suffix` to a `StrSafe` string allocated from `allocator`.
+ * @param dst The target string to append to.
+ * @param suffix The bytes to append; must not point into `dst`.
+ * @param suffix_len Number of bytes in `suffix`.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ * @return Pointer to `dst`, or `NULL` on allocation failure.
+ */
+static inline StrSafe* cstr_append_n_ex(StrSafe* dst, const char* suffix, size_t suffix_len, const StrSafe_allocator* allocator) {
+	size_t len = strsafe_length(dst);
+	size_t new_len = len + suffix_len;
+	STRSAFE_STAT(STRSAFE_STAT_APPEND, STRSAFE_EVENT_CALL, 0);
+	if (!strsafe_ensure_capacity_ex(dst, new_len + 1, allocator)) return NULL;
+	STRSAFE_STAT(STRSAFE_STAT_APPEND, STRSAFE_EVENT_COPY, suffix_len);
+
+	char* data = strsafe_data(dst);
+	memcpy(data + len, suffix, suffix_len);
+	data[new_len] = '\0';
+	strsafe_set_length(dst, new_len);
+	return dst;
+}
+
+/**
+ * @brief Appends `suffix_len` bytes of `suffix` to a `StrSafe` string.
+ * @param dst The target string to append to.
+ * @param suffix The bytes to append; must not point into `dst`.
+ * @param suffix_len Number of bytes in `suffix`.
+ * @return Pointer to `dst`, or `NULL` on allocation failure.
+ */
+static inline StrSafe* cstr_append_n(StrSafe* dst, const char* suffix, size_t suffix_len) {
+	return cstr_append_n_ex(dst, suffix, suffix_len, NULL);
+}
+
+/**
+ * @brief Appends a C-string to a `StrSafe` string allocated from `allocator`.
+ * @param dst The target string to append to.
+ * @param suffix The C-string to append.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ * @return Pointer to `dst`, or `NULL` on allocation failure.
+ */
+static inline StrSafe* cstr_append_ex(StrSafe* dst, const char* suffix, const StrSafe_allocator* allocator) {
+	return cstr_append_n_ex(dst, suffix, strlen(suffix), allocator);
+}
+
+/**
+ * @brief Appends a C-string to a `StrSafe` string.
+ *
+ * Ensures capacity and performs a single allocation if needed.
+ *
+ * @param dst The target string to append to.
+ * @param suffix The C-string to append.
+ * @return Pointer to `dst`, or `NULL` on allocation failure.
+ */
+static inline StrSafe* cstr_append(StrSafe* dst, const char* suffix) {
+	return cstr_append_ex(dst, suffix, NULL);
+}
+
+/**
+ * @brief Appends multiple C-strings to a `StrSafe` string.
+ *
+ * Precalculates total length and performs a single allocation.
+ * The list must be terminated with a `NULL` argument.
+ *
+ * @param dst The target string to append to.
+ * @param suffix The first C-string to append.
+ * @param ... Additional C-strings, terminated by `NULL`.
+ * @return Pointer to `dst`, or `NULL` on allocation failure.
+ */
+static inline StrSafe* cstr_appendv(StrSafe* dst, const char* suffix, ...) {
+	va_list args;
+	va_start(args, suffix);
+	size_t total_len = strlen(suffix);
+	const char* s;
+	while ((s = va_arg(args, const char*))) {
+		total_len += strlen(s);
+	}
+	va_end(args);
+
+	size_t len = strsafe_length(dst);
+	if (!strsafe_ensure_capacity(dst, len + total_len + 1)) return NULL;
+	char* data = strsafe_data(dst);
+
+	va_start(args, suffix);
+	memcpy(data + len, suffix, strlen(suffix));
+	len += strlen(suffix);
+	while ((s = va_arg(args, const char*))) {
+		size_t l = strlen(s);
+		memcpy(data + len, s, l);
+		len += l;
+	}
+	data[len] = '\0';
+	strsafe_set_length(dst, len);
+	va_end(args);
+	return dst;
+}
+
+/**
+ * @brief Splits a `StrSafe` string on a prepared needle, allocating from `allocator`.
+ *
+ * With an arena allocator the whole result is released by `strsafe_arena_reset`.
+ * Otherwise free it using `strsafe_array_free_ex` with the same allocator.
+ * An empty delimiter yields a single copy of `src`. The array grows geometrically;
+ * on allocation failure it holds the fields split so far.
+ *
+ * For many fields prefer `strsafe_needle_split_packed`, which needs two allocations
+ * instead of one per field.
+ *
+ * @param src The source string to split.
+ * @param delim Prepared needle for the delimiter.
+ * @param allocator Allocator for the array and its strings, or `NULL` for the default heap.
+ * @return A `StrSafe_array` containing the split substrings.
+ */
+static inline StrSafe_array strsafe_needle_split_ex(const StrSafe* src, const StrSafe_needle* delim, const StrSafe_allocator* allocator) {
+	StrSafe_array result = { NULL, 0, 0 };
+	size_t delim_len = delim->len;
+	const char* start = strsafe_cstr(src);
+	const char* stop = start + strsafe_length(src);
+	const char* end;
+
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_SPLIT, strsafe_length(src));
+	while (delim_len > 0 && (end = strsafe_needle_search(start, stop - start, delim))) {
+		if (!strsafe_array_push_ex(&result, start, end - start, allocator)) return result;
+		STRSAFE_STAT(STRSAFE_STAT_SPLIT, STRSAFE_EVENT_COPY, (size_t)(end - start));
+		start = end + delim_len;
+	}
+	if (strsafe_array_push_ex(&result, start, stop - start, allocator)) {
+		STRSAFE_STAT(STRSAFE_STAT_SPLIT, STRSAFE_EVENT_COPY, (size_t)(stop - start));
+	}
+
+	return result;
+}
+
+/**
+ * @brief Splits a `StrSafe` string on a prepared needle.
+ *
+ * Caller must free the result using `strsafe_array_free`.
+ *
+ * @param src The source string to split.
+ * @param delim Prepared needle for the delimiter.
+ * @return A `StrSafe_array` containing the split substrings.
+ */
+static inline StrSafe_array strsafe_needle_split(const StrSafe* src, const StrSafe_needle* delim) {
+	return strsafe_needle_split_ex(src, delim, NULL);
+}
+
+/**
+ * @brief Splits a `StrSafe` string on `delim_len` bytes of `delim`, allocating from `allocator`.
+ *
+ * With an arena allocator the whole result is released by `strsafe_arena_reset`.
+ * Otherwise free it using `strsafe_array_free_ex` with the same allocator.
+ * An empty delimiter yields a single copy of `src`.
+ *
+ * @param src The source string to split.
+ * @param delim The delimiter bytes.
+ * @param delim_len Number of bytes in `delim`.
+ * @param allocator Allocator for the array and its strings, or `NULL` for the default heap.
+ * @return A `StrSafe_array` containing the split substrings.
+ */
+static inline StrSafe_array cstr_split_n_ex(const StrSafe* src, const char* delim, size_t delim_len, const StrSafe_allocator* allocator) {
+	StrSafe_needle prepared;
+	strsafe_needle_init(&prepared, delim, delim_len);
+	return strsafe_needle_split_ex(src, &prepared, allocator);
+}
+
+/**
+ * @brief Splits a `StrSafe` string using a C-string delimiter, allocating from `allocator`.
+ *
+ * With an arena allocator the whole result is released by `strsafe_arena_reset`.
+ * Otherwise free it using `strsafe_array_free_ex` with the same allocator.
+ *
+ * @param src The source string to split.
+ * @param delim The delimiter string.
+ * @param allocator Allocator for the array and its strings, or `NULL` for the default heap.
+ * @return A `StrSafe_array` containing the split substrings.
+ */
+static inline StrSafe_array cstr_split_ex(StrSafe* src, const char* delim, const StrSafe_allocator* allocator) {
+	return cstr_split_n_ex(src, delim, strlen(delim), allocator);
+}
+
+/**
+ * @brief Splits a `StrSafe` string on `delim_len` bytes of `delim`.
+ * @param src The source string to split.
+ * @param delim The delimiter bytes.
+ * @param delim_len Number of bytes in `delim`.
+ * @return A `StrSafe_array` containing the split substrings.
+ */
+static inline StrSafe_array cstr_split_n(const StrSafe* src, const char* delim, size_t delim_len) {
+	return cstr_split_n_ex(src, delim, delim_len, NULL);
+}
+
+/**
+ * @brief Splits a `StrSafe` string into an array of substrings using a C-string delimiter.
+ *
+ * Allocates a new array and copies each segment into a separate `StrSafe`.
+ * Caller must free the result using `strsafe_array_free`.
+ *
+ * @param src The source string to split.
+ * @param delim The delimiter string.
+ * @return A `StrSafe_array` containing the split substrings.
+ */
+static inline StrSafe_array cstr_split(StrSafe* src, const char* delim) {
+	return cstr_split_ex(src, delim, NULL);
+}
+
+/**
+ * @brief Splits a `StrSafe` string into an array of substrings using a `StrSafe` delimiter.
+ *
+ * Caller must free the result using `strsafe_array_free`.
+ *
+ * @param src The source string to split.
+ * @param delim The delimiter string.
+ * @return A `StrSafe_array` containing the split substrings.
+ */
+static inline StrSafe_array strsafe_split(const StrSafe* src, const StrSafe* delim) {
+	return cstr_split_n_ex(src, strsafe_cstr(delim), strsafe_length(delim), NULL);
+}
+
+/**
+ * @brief Replaces all occurrences of a needle in one string, building growing results in `scratch`.
+ *
+ * Results that fit the old buffer are copied back into it; larger ones trade buffers with
+ * `scratch`, so a loop over many strings allocates only when `scratch` has to grow.
+ * Replacements no longer than the needle work in place as in `strsafe_needle_replace_all`.
+ * Both strings must use the default heap.
+ *
+ * @param dst The string to modify.
+ * @param old_str Prepared needle for the bytes to be replaced; an empty needle leaves `dst` unchanged.
+ * @param new_str The replacement bytes; neither pattern may point into `dst` or `scratch`.
+ * @param new_len Number of bytes in `new_str`.
+ * @param scratch Private work string reused across calls; free it when done.
+ * @return `true` if successful, `false` on allocation failure (`dst` is unchanged).
+ */
+static inline bool strsafe_needle_replace_all_scratch(StrSafe* dst, const StrSafe_needle* old_str, const char* new_str, size_t new_len, StrSafe* scratch) {
+	size_t old_len = old_str->len;
+	if (old_len == 0) return true;
+	if (new_len <= old_len) return strsafe_needle_replace_all(dst, old_str, new_str, new_len) != NULL;
+
+	const char* src = strsafe_cstr(dst);
+	size_t len = strsafe_length(dst);
+	const char* p = src;
+	const char* end = src + len;
+	const char* match = strsafe_needle_search(p, len, old_str);
+	if (!match) return true;
+
+	size_t out_len = 0;
+	while (match) {
+		size_t seg = match - p;
+		if (!strsafe_ensure_capacity(scratch, out_len + seg + new_len + 1)) return false;
+		char* out = strsafe_data(scratch);
+		memcpy(out + out_len, p, seg);
+		memcpy(out + out_len + seg, new_str, new_len);
+		out_len += seg + new_len;
+		// keep the length current so growing `scratch` carries the bytes written so far
+		strsafe_set_length(scratch, out_len);
+		p = match + old_len;
+		match = strsafe_needle_search(p, end - p, old_str);
+	}
+	size_t tail = end - p;
+	if (!strsafe_ensure_capacity(scratch, out_len + tail + 1)) return false;
+	char* out = strsafe_data(scratch);
+	memcpy(out + out_len, p, tail);
+	out_len += tail;
+	out[out_len] = '\0';
+
+	if (!strsafe_is_shared(dst) && strsafe_capacity(dst) > out_len) {
+		memcpy(strsafe_data(dst), out, out_len + 1);
+		strsafe_set_length(dst, out_len);
+		strsafe_set_length(scratch, 0);
+		return true;
+	}
+	strsafe_set_length(scratch, out_len);
+	StrSafe old = *dst;
+	*dst = *scratch;
+	*scratch = old;
+	if (strsafe_is_shared(scratch)) {
+		// a shared buffer cannot become scratch space
+		strsafe_free(scratch);
+	}
+	return true;
+}
+
+/**
+ * @brief Replaces all occurrences of a needle in every string of an array.
+ *
+ * The needle is prepared once and growing results share one scratch buffer.
+ *
+ * @param arr The strings to modify.
+ * @param old_str Prepared needle for the bytes to be replaced.
+ * @param new_str The replacement bytes; must not point into `arr`.
+ * @param new_len Number of bytes in `new_str`.
+ * @return `true` if successful, `false` on allocation failure (strings before the failing one are already rewritten).
+ */
+static inline bool strsafe_array_replace_all(StrSafe_array* arr, const StrSafe_needle* old_str, const char* new_str, size_t new_len) {
+	StrSafe scratch;
+	strsafe_init(&scratch);
+	bool ok = true;
+	for (int i = 0; ok && i < arr->array_size; ++i) {
+		ok = strsafe_needle_replace_all_scratch(&arr->arr[i], old_str, new_str, new_len, &scratch);
+	}
+	strsafe_free(&scratch);
+	return ok;
+}
+
+/**
+ * @brief Replaces all occurrences of a substring in every string of an array.
+ * @param arr The strings to modify.
+ * @param old_str The substring to be replaced.
+ * @param new_str The replacement string.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool cstr_array_replace_all(StrSafe_array* arr, const char* old_str, const char* new_str) {
+	StrSafe_needle prepared;
+	strsafe_needle_init(&prepared, old_str, strlen(old_str));
+	return strsafe_array_replace_all(arr, &prepared, new_str, strlen(new_str));
+}
+
+/**
+ * @brief Finds the first occurrence of a needle in every string of an array.
+ * @param arr The strings to search.
+ * @param needle Prepared needle.
+ * @param positions Receives `array_size` positions, -1 where there is no match; may be `NULL`.
+ * @return Number of strings containing the needle.
+ */
+static inline size_t strsafe_array_find(const StrSafe_array* arr, const StrSafe_needle* needle, ssize_t* positions) {
+	size_t found = 0;
+	for (int i = 0; i < arr->array_size; ++i) {
+		ssize_t pos = strsafe_needle_find(&arr->arr[i], needle);
+		if (positions) positions[i] = pos;
+		found += pos >= 0;
+	}
+	return found;
+}
+
+/**
+ * @brief Finds the first occurrence of a substring in every string of an array.
+ * @param arr The strings to search.
+ * @param needle The substring to find.
+ * @param positions Receives `array_size` positions, -1 where there is no match; may be `NULL`.
+ * @return Number of strings containing the substring.
+ */
+static inline size_t cstr_array_find(const StrSafe_array* arr, const char* needle, ssize_t* positions) {
+	StrSafe_needle prepared;
+	strsafe_needle_init(&prepared, needle, strlen(needle));
+	return strsafe_array_find(arr, &prepared, positions);
+}
+
+/**
+ * @brief Counts the non-overlapping occurrences of a needle in every string of an array.
+ * @param arr The strings to search.
+ * @param needle Prepared needle.
+ * @param counts Receives `array_size` per-string counts; may be `NULL`.
+ * @return Total number of occurrences.
+ */
+static inline size_t strsafe_array_count(const StrSafe_array* arr, const StrSafe_needle* needle, size_t* counts) {
+	size_t total = 0;
+	for (int i = 0; i < arr->array_size; ++i) {
+		size_t count = strsafe_needle_count(&arr->arr[i], needle);
+		if (counts) counts[i] = count;
+		total += count;
+	}
+	return total;
+}
+
+/**
+ * @brief Counts the non-overlapping occurrences of a substring in every string of an array.
+ * @param arr The strings to search.
+ * @param needle The substring to count.
+ * @param counts Receives `array_size` per-string counts; may be `NULL`.
+ * @return Total number of occurrences.
+ */
+static inline size_t cstr_array_count(const StrSafe_array* arr, const char* needle, size_t* counts) {
+	StrSafe_needle prepared;
+	strsafe_needle_init(&prepared, needle, strlen(needle));
+	return strsafe_array_count(arr, &prepared, counts);
+}
+
+/**
+ * @brief Drops the strings of an array built from `allocator` that do, or do not, contain a needle.
+ *
+ * Kept strings move down in their original order; dropped ones are freed with `allocator`.
+ * The array keeps its capacity.
+ *
+ * @param arr The array to filter.
+ * @param needle Prepared needle.
+ * @param keep_matching `true` to keep the strings containing the needle, `false` to keep the others.
+ * @param allocator Allocator the strings came from, or `NULL` for the default heap.
+ * @return The new `array_size`.
+ */
+static inline int strsafe_array_filter_ex(StrSafe_array* arr, const StrSafe_needle* needle, bool keep_matching, const StrSafe_allocator* allocator) {
+	int kept = 0;
+	for (int i = 0; i < arr->array_size; ++i) {
+		bool match = strsafe_needle_find(&arr->arr[i], needle) >= 0;
+		if (match == keep_matching) {
+			arr->arr[kept++] = arr->arr[i];
+		}
+		else {
+			strsafe_free_ex(&arr->arr[i], allocator);
+		}
+	}
+	arr->array_size = kept;
+	return kept;
+}
+
+/**
+ * @brief Drops the strings of an array that do, or do not, contain a needle.
+ *
+ * Kept strings move down in their original order; dropped ones are freed. The array keeps
+ * its capacity. Use `strsafe_array_filter_ex` for arrays built with another allocator.
+ *
+ * @param arr The array to filter.
+ * @param needle Prepared needle.
+ * @param keep_matching `true` to keep the strings containing the needle, `false` to keep the others.
+ * @return The new `array_size`.
+ */
+static inline int strsafe_array_filter(StrSafe_array* arr, const StrSafe_needle* needle, bool keep_matching) {
+	return strsafe_array_filter_ex(arr, needle, keep_matching, NULL);
+}
+
+/**
+ * @brief Drops the strings of an array that do, or do not, contain a substring.
+ * @param arr The array to filter.
+ * @param needle The substring to look for.
+ * @param keep_matching `true` to keep the strings containing it, `false` to keep the others.
+ * @return The new `array_size`.
+ */
+static inline int cstr_array_filter(StrSafe_array* arr, const char* needle, bool keep_matching) {
+	StrSafe_needle prepared;
+	strsafe_needle_init(&prepared, needle, strlen(needle));
+	return strsafe_array_filter(arr, &prepared, keep_matching);
+}
+
+/**
+ * @brief Sets the content of a `StrSafe` allocated from `allocator` from a C-string.
+ * @param dst Destination string.
+ * @param src Source C-string.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ * @return Pointer to `dst`, or `NULL` on failure.
+ */
+static inline StrSafe* strsafe_set_ex(StrSafe* dst, const char* src, const StrSafe_allocator* allocator) {
+	return strsafe_assign_ex(dst, src, strlen(src), allocator);
+}
+
+/**
+ * @brief Sets the content of a `StrSafe` from a C-string.
+ * @param dst Destination string.
+ * @param src Source C-string.
+ * @return Pointer to `dst`, or `NULL` on failure.
+ */
+static inline StrSafe* strsafe_set(StrSafe* dst, const char* src) {
+	return strsafe_set_ex(dst, src, NULL);
+}
+
+/**
+ * @brief Finds the first occurrence of `needle` in `haystack`.
+ * @param haystack The string to search.
+ * @param needle The substring to find.
+ * @return Position of match or -1 if not found.
+ */
+static inline ssize_t strsafe_find(StrSafe* haystack, const StrSafe* needle) {
+	return cstr_find_n(haystack, strsafe_cstr(needle), strsafe_length(needle));
+}
+
+/**
+ * @brief Finds the first occurrence of `needle` in `haystack` starting from `pos`.
+ * @param haystack The string to search.
+ * @param needle The substring to find.
+ * @param pos Starting position.
+ * @return Position of match or -1 if not found.
+ */
+static inline ssize_t strsafe_find_from_pos(StrSafe* haystack, const StrSafe* needle, size_t pos) {
+	return cstr_find_from_pos_n(haystack, strsafe_cstr(needle), strsafe_length(needle), pos);
+}
+
+/**
+ * @brief Compares two `StrSafe` strings for equality.
+ * @param a First string.
+ * @param b Second string.
+ * @return `true` if equal, `false` otherwise.
+ */
+static inline bool strsafe_compare(const StrSafe* a, const StrSafe* b) {
+	if (strsafe_length(a) != strsafe_length(b)) return false;
+	// shared, interned and self comparisons need no byte compare
+	if (strsafe_cstr(a) == strsafe_cstr(b)) return true;
+	return memcmp(strsafe_cstr(a), strsafe_cstr(b), strsafe_length(a)) == 0;
+}
+
+/**
+ * @brief Copies the content of one `StrSafe` into another allocated from `allocator`.
+ *
+ * When `src` is shared the copy takes another reference instead of copying the bytes.
+ * @param dst Destination string.
+ * @param src Source string.
+ * @param allocator Allocator owning the destination buffer, or `NULL` for the default heap.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_copy_ex(StrSafe* dst, const StrSafe* src, const StrSafe_allocator* allocator) {
+	if (strsafe_is_shared(src)) {
+		if (dst != src) {
+			strsafe_free_ex(dst, allocator);
+			STRSAFE_REF_INC(&strsafe_shared_header(src)->refs);
+			*dst = *src;
+		}
+		return true;
+	}
+	return strsafe_assign_ex(dst, strsafe_cstr(src), strsafe_length(src), allocator) != NULL;
+}
+
+/**
+ * @brief Copies the content of one `StrSafe` to another.
+ * @param dst Destination string.
+ * @param src Source string.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_copy(StrSafe* dst, const StrSafe* src) {
+	return strsafe_copy_ex(dst, src, NULL);
+}
+
+/**
+ * @brief Counts how many times `needle` appears in `dst`.
+ * @param haystack The string to search.
+ * @param needle The substring to count.
+ * @return Number of occurrences.
+ */
+static inline size_t strsafe_count(const StrSafe* haystack, const StrSafe* needle) {
+	return cstr_count_n(haystack, strsafe_cstr(needle), strsafe_length(needle));
+}
+
+/**
+ * @brief Inserts a string into another at a given position.
+ * @param dst Destination string.
+ * @param pos Position to insert at.
+ * @param ins String to insert.
+ * @return `true` if successful, `false` otherwise.
+ */
+static inline bool strsafe_insert(StrSafe* dst, size_t pos, const StrSafe* ins) {
+	size_t len = strsafe_length(dst);
+	if (pos > len) return false;
+
+	size_t ins_len = strsafe_length(ins);
+	size_t new_len = len + ins_len;
+	if (!strsafe_ensure_capacity(dst, new_len + 1)) return false;
+
+	char* data = strsafe_data(dst);
+	memmove(data + pos + ins_len, data + pos, len - pos + 1);
+	memcpy(data + pos, strsafe_cstr(ins), ins_len);
+	strsafe_set_length(dst, new_len);
+	return true;
+}
+
+/**
+ * @brief Extracts a substring from a `StrSafe` allocated from `allocator`.
+ *
+ * The substring is moved to the front of the existing buffer, which is kept unless
+ * `STRSAFE_TRIM_POLICY` says otherwise; `allocator` is only used to trim.
+ *
+ * @param sub_string Target string to hold the substring.
+ * @param pos Starting position.
+ * @param len Length of substring.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ * @return Pointer to `sub_string`, or `NULL` if a shared buffer could not be copied.
+ */
+static inline StrSafe* strsafe_substr_ex(StrSafe* sub_string, const size_t pos, const size_t len, const StrSafe_allocator* allocator) {
+	size_t src_len = strsafe_length(sub_string);
+	size_t start = pos < src_len ? pos : src_len;
+	size_t actual_len = (len > src_len - start) ? (src_len - start) : len;
+	if (actual_len == src_len) return sub_string;
+	if (!strsafe_unshare_ex(sub_string, allocator)) return NULL;
+
+	char* data = strsafe_data(sub_string);
+	memmove(data, data + start, actual_len);
+	data[actual_len] = '\0';
+	strsafe_set_length(sub_string, actual_len);
+	strsafe_shrunk_ex(sub_string, allocator);
+	return sub_string;
+}
+
+/**
+ * @brief Extracts a substring from a `StrSafe` in place, without allocating.
+ * @param sub_string Target string to hold the substring.
+ * @param pos Starting position.
+ * @param len Length of substring.
+ * @return Pointer to `sub_string`, or `NULL` if a shared buffer could not be copied.
+ */
+static inline StrSafe* strsafe_substr(StrSafe* sub_string, const size_t pos, const size_t len) {
+	return strsafe_substr_ex(sub_string, pos, len, NULL);
+}
+
+/**
+ * @brief Replaces the first occurrence of a substring with another.
+ * @param dst Target string.
+ * @param old_str Substring to replace.
+ * @param new_str Replacement string.
+ * @return `true` if successful, `false` otherwise.
+ */
+static inline bool strsafe_replace(StrSafe* dst, const StrSafe* old_str, const StrSafe* new_str) {
+	ssize_t pos = strsafe_find(dst, old_str);
+	if (pos < 0) return true;
+
+	const char* data = strsafe_cstr(dst);
+	size_t len = strsafe_length(dst);
+	size_t old_len = strsafe_length(old_str);
+	size_t new_len = strsafe_length(new_str);
+	size_t final_len = len - old_len + new_len;
+
+	StrSafe result;
+	strsafe_init(&result);
+	if (!strsafe_reserve(&result, final_len + 1)) return false;
+	char* buffer = strsafe_data(&result);
+
+	memcpy(buffer, data, pos);
+	memcpy(buffer + pos, strsafe_cstr(new_str), new_len);
+	memcpy(buffer + pos + new_len, data + pos + old_len, len - pos - old_len);
+	buffer[final_len] = '\0';
+	strsafe_set_length(&result, final_len);
+
+	strsafe_move(dst, &result);
+	return true;
+}
+
+/**
+ * @brief Replaces all occurrences of a substring with another.
+ * @param dst Target string.
+ * @param old_str Substring to replace.
+ * @param new_str Replacement string.
+ * @return `true` if successful, `false` otherwise.
+ */
+static inline bool strsafe_replace_all(StrSafe* dst, const StrSafe* old_str, const StrSafe* new_str) {
+	return cstr_replace_all_n(dst, strsafe_cstr(old_str), strsafe_length(old_str), strsafe_cstr(new_str), strsafe_length(new_str)) != NULL;
+}
+
+/**
+ * @brief Removes the first occurrence of a substring.
+ * @param dst Target string.
+ * @param str_to_remove Substring to remove.
+ * @return `true` if successful, `false` otherwise.
+ */
+static inline bool strsafe_remove(StrSafe* dst, const StrSafe* str_to_remove) {
+	ssize_t pos = strsafe_find(dst, str_to_remove);
+	if (pos < 0) return true;
+	if (!strsafe_unshare(dst)) return false;
+
+	char* data = strsafe_data(dst);
+	size_t len = strsafe_length(dst);
+	size_t rem_len = strsafe_length(str_to_remove);
+	memmove(data + pos, data + pos + rem_len, len - pos - rem_len + 1);
+	strsafe_set_length(dst, len - rem_len);
+	strsafe_shrunk_ex(dst, NULL);
+	return true;
+}
+
+/**
+ * @brief Removes all occurrences of a substring.
+ * @param dst Target string.
+ * @param str_to_remove Substring to remove.
+ * @return `true` if successful, `false` otherwise.
+ */
+static inline bool strsafe_remove_all(StrSafe* dst, const StrSafe* str_to_remove) {
+	return cstr_remove_all_n(dst, strsafe_cstr(str_to_remove), strsafe_length(str_to_remove)) != NULL;
+}
+
+/**
+ * @brief Appends one `StrSafe` string to another allocated from `allocator`.
+ * @param dst Destination string.
+ * @param suffix String to append.
+ * @param allocator Allocator owning the destination buffer, or `NULL` for the default heap.
+ * @return `true` if successful, `false` otherwise.
+ */
+static inline bool strsafe_append_ex(StrSafe* dst, const StrSafe* suffix, const StrSafe_allocator* allocator) {
+	size_t len = strsafe_length(dst);
+	size_t suffix_len = strsafe_length(suffix);
+	size_t new_len = len + suffix_len;
+	if (!strsafe_ensure_capacity_ex(dst, new_len + 1, allocator)) return false;
+
+	char* data = strsafe_data(dst);
+	memcpy(data + len, strsafe_cstr(suffix), suffix_len);
+	data[new_len] = '\0';
+	strsafe_set_length(dst, new_len);
+	return true;
+}
+
+/**
+ * @brief Appends one `StrSafe` string to another.
+ * @param dst Destination string.
+ * @param suffix String to append.
+ * @return `true` if successful, `false` otherwise.
+ */
+static inline bool strsafe_append(StrSafe* dst, const StrSafe* suffix) {
+	return strsafe_append_ex(dst, suffix, NULL);
+}
+
+/**
+ * @brief Appends multiple `StrSafe` strings to a destination.
+ * @param dst Destination string.
+ * @param first First string to append.
+ * @param ... Additional strings, terminated by `NULL`.
+ * @return `true` if successful, `false` otherwise.
+ */
+static inline bool strsafe_appendv(StrSafe* dst, const StrSafe* first, ...) {
+	va_list args;
+	va_start(args, first);
+
+	size_t total_len = strsafe_length(first);
+	const StrSafe* s;
+	while ((s = va_arg(args, const StrSafe*))) {
+		total_len += strsafe_length(s);
+	}
+	va_end(args);
+
+	size_t len = strsafe_length(dst);
+	if (!strsafe_ensure_capacity(dst, len + total_len + 1)) return false;
+	char* data = strsafe_data(dst);
+
+	va_start(args, first);
+	memcpy(data + len, strsafe_cstr(first), strsafe_length(first));
+	len += strsafe_length(first);
+
+	while ((s = va_arg(args, const StrSafe*))) {
+		memcpy(data + len, strsafe_cstr(s), strsafe_length(s));
+		len += strsafe_length(s);
+	}
+	data[len] = '\0';
+	strsafe_set_length(dst, len);
+	va_end(args);
+
+	return true;
+}
+
+/**
+ * @brief Appends printf-style formatted output, growing through `allocator`.
  *
- * Allocates a new array and copies each segment into a separate `StrSafe`.
- * Caller must free the result using `strsafe_array_free`.
+ * The output is formatted straight into the spare capacity of `dst`; only when it does not
+ * fit is the buffer grown, once, to the exact size `vsnprintf` reported and formatted again.
  *
- * @param src The source string to split.
- * @param delim The delimiter string.
- * @return A `StrSafe_array` containing the split substrings.
+ * @param dst The target string to append to.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ * @param format printf format string; neither it nor the arguments may point into `dst`.
+ * @param args Format arguments.
+ * @return `true` if successful, `false` on allocation or encoding failure (`dst` keeps its contents).
  */
-static inline StrSafe_array cstr_split(StrSafe* src, const char* delim) {
-	StrSafe_array result = { 0 };
-	size_t delim_len = strlen(delim);
-	char* start = src->data;
-	char* end;
-
-	while ((end = strstr(start, delim))) {
-		size_t seg_len = end - start;
-		result.arr = realloc(result.arr, sizeof(StrSafe) * (result.array_size + 1));
-		StrSafe* seg = &result.arr[result.array_size++];
-		seg->data = malloc(seg_len + 1);
-		memcpy(seg->data, start, seg_len);
-		seg->data[seg_len] = '\0';
-		seg->len = seg_len;
-		seg->cap = seg_len + 1;
-		start = end + delim_len;
+static inline bool strsafe_vappendf_ex(StrSafe* dst, const StrSafe_allocator* allocator, const char* format, va_list args) {
+	size_t len = strsafe_length(dst);
+	size_t spare = strsafe_capacity(dst) > len ? strsafe_capacity(dst) - len : 0;
+	if (spare < 2 || strsafe_is_shared(dst)) {
+		// nowhere to format into yet: take room for a typical field in the same growth
+		if (!strsafe_ensure_capacity_ex(dst, len + STRSAFE_APPENDF_MIN, allocator)) return false;
+		spare = strsafe_capacity(dst) - len;
+	}
+
+	va_list retry;
+	va_copy(retry, args);
+	int n = vsnprintf(strsafe_data(dst) + len, spare, format, args);
+	if (n >= 0 && (size_t)n >= spare) {
+		if (strsafe_ensure_capacity_ex(dst, len + (size_t)n + 1, allocator)) {
+			n = vsnprintf(strsafe_data(dst) + len, (size_t)n + 1, format, retry);
+		}
+		else {
+			n = -1;
+		}
+	}
+	va_end(retry);
+
+	if (n < 0) {
+		strsafe_data(dst)[len] = '\0';
+		return false;
+	}
+	strsafe_set_length(dst, len + (size_t)n);
+	return true;
+}
+
+/**
+ * @brief Appends printf-style formatted output from a `va_list`.
+ * @param dst The target string to append to.
+ * @param format printf format string; neither it nor the arguments may point into `dst`.
+ * @param args Format arguments.
+ * @return `true` if successful, `false` on allocation or encoding failure.
+ */
+static inline bool strsafe_vappendf(StrSafe* dst, const char* format, va_list args) {
+	return strsafe_vappendf_ex(dst, NULL, format, args);
+}
+
+/**
+ * @brief Appends printf-style formatted output.
+ *
+ * Formats directly into `dst` instead of a temporary buffer, so it costs one copy and at
+ * most one allocation.
+ *
+ * @param dst The target string to append to.
+ * @param format printf format string; neither it nor the arguments may point into `dst`.
+ * @param ... Format arguments.
+ * @return `true` if successful, `false` on allocation or encoding failure.
+ */
+STRSAFE_PRINTF_FORMAT(2, 3)
+static inline bool strsafe_appendf(StrSafe* dst, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	bool ok = strsafe_vappendf(dst, format, args);
+	va_end(args);
+	return ok;
+}
+
+/** @brief "00" through "99", two characters per value. */
+static const char strsafe_digit_pairs[201] =
+	"00010203040506070809101112131415161718192021222324"
+	"25262728293031323334353637383940414243444546474849"
+	"50515253545556575859606162636465666768697071727374"
+	"75767778798081828384858687888990919293949596979899";
+
+/**
+ * @brief Number of decimal digits of an unsigned value.
+ * @param value The value.
+ * @return Digit count, at least 1.
+ */
+static inline size_t strsafe_u64_digits(uint64_t value) {
+	size_t digits = 1;
+	for (;;) {
+		if (value < 10) return digits;
+		if (value < 100) return digits + 1;
+		if (value < 1000) return digits + 2;
+		if (value < 10000) return digits + 3;
+		value /= 10000;
+		digits += 4;
+	}
+}
+
+/**
+ * @brief Writes the decimal digits of a value backwards, two at a time, ending just before `end`.
+ * @param end One past the last digit.
+ * @param value The value.
+ */
+static inline void strsafe_write_u64(char* end, uint64_t value) {
+	while (value >= 100) {
+		size_t pair = (size_t)(value % 100) * 2;
+		value /= 100;
+		end -= 2;
+		end[0] = strsafe_digit_pairs[pair];
+		end[1] = strsafe_digit_pairs[pair + 1];
+	}
+	if (value >= 10) {
+		end -= 2;
+		end[0] = strsafe_digit_pairs[value * 2];
+		end[1] = strsafe_digit_pairs[value * 2 + 1];
+	}
+	else {
+		*--end = (char)('0' + value);
+	}
+}
+
+/**
+ * @brief Appends a decimal number with an optional sign, bypassing printf.
+ * @param dst The target string to append to.
+ * @param negative Write a leading '-'.
+ * @param magnitude The absolute value.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_append_decimal(StrSafe* dst, bool negative, uint64_t magnitude) {
+	size_t len = strsafe_length(dst);
+	size_t digits = strsafe_u64_digits(magnitude);
+	size_t new_len = len + negative + digits;
+	if (!strsafe_ensure_capacity(dst, new_len + 1)) return false;
+
+	char* data = strsafe_data(dst);
+	if (negative) data[len] = '-';
+	strsafe_write_u64(data + new_len, magnitude);
+	data[new_len] = '\0';
+	strsafe_set_length(dst, new_len);
+	return true;
+}
+
+/**
+ * @brief Appends an unsigned integer in decimal, as `"%" PRIu64` would.
+ * @param dst The target string to append to.
+ * @param value The value.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_append_u64(StrSafe* dst, uint64_t value) {
+	return strsafe_append_decimal(dst, false, value);
+}
+
+/**
+ * @brief Appends a signed integer in decimal, as `"%" PRId64` would.
+ * @param dst The target string to append to.
+ * @param value The value.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_append_int(StrSafe* dst, int64_t value) {
+	uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+	return strsafe_append_decimal(dst, value < 0, magnitude);
+}
+
+/**
+ * @brief Appends a floating-point value with `precision` decimals, as `"%.*f"` would.
+ *
+ * Finite values whose scaled magnitude fits 53 bits are converted with integer arithmetic;
+ * the rest, and values too close to a rounding tie to decide safely, go through `snprintf`,
+ * so the output always matches printf.
+ *
+ * @param dst The target string to append to.
+ * @param value The value.
+ * @param precision Number of digits after the decimal point; values above 9 use printf.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_append_double(StrSafe* dst, double value, int precision) {
+	static const double pow10[10] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+	if (precision >= 0 && precision <= 9 && value == value) {
+		bool negative = value < 0 || (value == 0 && 1 / value < 0);
+		double scaled = (negative ? -value : value) * pow10[precision];
+		if (scaled < 9007199254740992.0) {
+			uint64_t whole = (uint64_t)scaled;
+			double frac = scaled - (double)whole;
+			// the product is off by at most half an ulp, so only near-ties need printf
+			double slack = scaled * (1.0 / 4503599627370496.0) + 1e-300;
+			if (frac < 0.5 - slack || frac > 0.5 + slack) {
+				if (frac > 0.5) whole++;
+				uint64_t divisor = (uint64_t)pow10[precision];
+				uint64_t int_part = whole / divisor;
+				uint64_t frac_part = whole % divisor;
+
+				size_t len = strsafe_length(dst);
+				size_t int_digits = strsafe_u64_digits(int_part);
+				size_t new_len = len + negative + int_digits + (precision ? (size_t)precision + 1 : 0);
+				if (!strsafe_ensure_capacity(dst, new_len + 1)) return false;
+
+				char* data = strsafe_data(dst);
+				if (negative) data[len] = '-';
+				strsafe_write_u64(data + len + negative + int_digits, int_part);
+				if (precision) {
+					char* point = data + len + negative + int_digits;
+					*point = '.';
+					memset(point + 1, '0', (size_t)precision);
+					if (frac_part) strsafe_write_u64(data + new_len, frac_part);
+				}
+				data[new_len] = '\0';
+				strsafe_set_length(dst, new_len);
+				return true;
+			}
+		}
+	}
+	return strsafe_appendf(dst, "%.*f", precision, value);
+}
+
+/**
+ * @brief Splits a string in two at `pos`, allocating the result from `allocator`.
+ * @param src Source string.
+ * @param pos Split position, clamped to the length of `src`.
+ * @param allocator Allocator for the array and its strings, or `NULL` for the default heap.
+ * @return Array of the two halves.
+ */
+static inline StrSafe_array strsafe_split_at_ex(const StrSafe* src, size_t pos, const StrSafe_allocator* allocator) {
+	StrSafe_array result = { NULL, 0, 0 };
+	size_t src_len = strsafe_length(src);
+	const char* data = strsafe_cstr(src);
+
+	// clamp pos into [0..src->len]
+	if (pos > src_len) {
+		pos = src_len;
+	}
+
+	// allocate space for two segments
+	result.arr = (StrSafe*)strsafe_mem_alloc(allocator, sizeof(StrSafe) * 2);
+	if (!result.arr) {
+		return result;  // array_size stays 0 on alloc failure
+	}
+	result.capacity = 2;
+
+	// first segment = src->data[0 .. pos-1]
+	StrSafe* seg0 = &result.arr[result.array_size++];
+	strsafe_init_from_ex(seg0, data, pos, allocator);
+
+	// second segment = src->data[pos .. end]
+	StrSafe* seg1 = &result.arr[result.array_size++];
+	strsafe_init_from_ex(seg1, data + pos, src_len - pos, allocator);
+
+	return result;
+}
+
+/**
+ * @brief Splits a string into an array using a delimiter.
+ * @param src Source string.
+ * @param delim Delimiter string.
+ * @return Array of substrings.
+ */
+static inline StrSafe_array strsafe_split_at(const StrSafe* src, size_t pos) {
+	return strsafe_split_at_ex(src, pos, NULL);
+}
+
+/**
+ * @brief Makes a view over `len` bytes starting at `ptr`.
+ * @param ptr First character.
+ * @param len Number of characters.
+ * @return The view.
+ */
+static inline StrSafe_view strsafe_view_make(const char* ptr, size_t len) {
+	StrSafe_view view = { ptr, len };
+	return view;
+}
+
+/**
+ * @brief Makes a view over the contents of a `StrSafe`.
+ *
+ * The view is invalidated by any operation that reallocates or frees `src`.
+ *
+ * @param src Source string.
+ * @return The view.
+ */
+static inline StrSafe_view strsafe_view_of(const StrSafe* src) {
+	return strsafe_view_make(strsafe_cstr(src), strsafe_length(src));
+}
+
+/**
+ * @brief Makes a view over a C-string.
+ * @param src Null-terminated source.
+ * @return The view.
+ */
+static inline StrSafe_view strsafe_view_from_cstr(const char* src) {
+	return strsafe_view_make(src, strlen(src));
+}
+
+/**
+ * @brief Returns the part of `view` starting at `pos` and spanning at most `len` characters.
+ * @param view Source view.
+ * @param pos Starting position; positions past the end give an empty view.
+ * @param len Maximum length.
+ * @return The sub-view, pointing into the same buffer.
+ */
+static inline StrSafe_view strsafe_view_substr(StrSafe_view view, size_t pos, size_t len) {
+	if (pos >= view.len) return strsafe_view_make(view.ptr + view.len, 0);
+	size_t actual_len = (len > view.len - pos) ? (view.len - pos) : len;
+	return strsafe_view_make(view.ptr + pos, actual_len);
+}
+
+/**
+ * @brief Returns a view of part of a `StrSafe` without copying.
+ * @param src Source string.
+ * @param pos Starting position.
+ * @param len Maximum length.
+ * @return The sub-view.
+ */
+static inline StrSafe_view strsafe_substr_view(const StrSafe* src, size_t pos, size_t len) {
+	return strsafe_view_substr(strsafe_view_of(src), pos, len);
+}
+
+/**
+ * @brief Finds the first occurrence of `needle` in `haystack` starting from `pos`.
+ * @param haystack The view to search.
+ * @param needle The view to find.
+ * @param pos Starting position.
+ * @return Position of match or -1 if not found.
+ */
+static inline ssize_t strsafe_view_find_from_pos(StrSafe_view haystack, StrSafe_view needle, size_t pos) {
+	if (pos > haystack.len) return -1;
+	const char* found = strsafe_memmem(haystack.ptr + pos, haystack.len - pos, needle.ptr, needle.len);
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_FIND, found ? (size_t)(found - haystack.ptr) - pos + needle.len : haystack.len - pos);
+	return found ? (ssize_t)(found - haystack.ptr) : -1;
+}
+
+/**
+ * @brief Finds the first occurrence of `needle` in `haystack`.
+ * @param haystack The view to search.
+ * @param needle The view to find.
+ * @return Position of match or -1 if not found.
+ */
+static inline ssize_t strsafe_view_find(StrSafe_view haystack, StrSafe_view needle) {
+	return strsafe_view_find_from_pos(haystack, needle, 0);
+}
+
+/**
+ * @brief Counts non-overlapping occurrences of `needle` in `haystack`.
+ * @param haystack The view to search.
+ * @param needle The view to count; an empty needle counts as 0.
+ * @return Number of occurrences.
+ */
+static inline size_t strsafe_view_count(StrSafe_view haystack, StrSafe_view needle) {
+	if (needle.len == 0) return 0;
+	StrSafe_needle prepared;
+	strsafe_needle_init(&prepared, needle.ptr, needle.len);
+	size_t count = 0;
+	const char* p = haystack.ptr;
+	const char* end = haystack.ptr + haystack.len;
+	while ((p = strsafe_needle_search(p, end - p, &prepared))) {
+		++count;
+		p += needle.len;
+	}
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_COUNT, haystack.len);
+	return count;
+}
+
+/**
+ * @brief Compares two views for equality.
+ * @param a First view.
+ * @param b Second view.
+ * @return `true` if equal, `false` otherwise.
+ */
+static inline bool strsafe_view_compare(StrSafe_view a, StrSafe_view b) {
+	if (a.len != b.len) return false;
+	return a.len == 0 || memcmp(a.ptr, b.ptr, a.len) == 0;
+}
+
+/**
+ * @brief Compares a `StrSafe` with a view for equality.
+ * @param a The `StrSafe` string.
+ * @param b The view.
+ * @return `true` if equal, `false` otherwise.
+ */
+static inline bool strsafe_compare_view(const StrSafe* a, StrSafe_view b) {
+	return strsafe_view_compare(strsafe_view_of(a), b);
+}
+
+/**
+ * @brief Finds the first occurrence of a view in a `StrSafe`.
+ * @param haystack The string to search.
+ * @param needle The view to find.
+ * @return Position of match or -1 if not found.
+ */
+static inline ssize_t strsafe_find_view(const StrSafe* haystack, StrSafe_view needle) {
+	return strsafe_view_find(strsafe_view_of(haystack), needle);
+}
+
+/**
+ * @brief Counts how many times a view appears in a `StrSafe`.
+ * @param haystack The string to search.
+ * @param needle The view to count.
+ * @return Number of occurrences.
+ */
+static inline size_t strsafe_count_view(const StrSafe* haystack, StrSafe_view needle) {
+	return strsafe_view_count(strsafe_view_of(haystack), needle);
+}
+
+/**
+ * @brief Computes the full 64x64->128-bit product of `*a` and `*b`, low half into `*a`, high into `*b`.
+ * @param a First factor; receives the low 64 bits.
+ * @param b Second factor; receives the high 64 bits.
+ */
+static inline void strsafe_hash_mum(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+	__extension__ typedef unsigned __int128 strsafe_u128;
+	strsafe_u128 r = (strsafe_u128)*a * *b;
+	*a = (uint64_t)r;
+	*b = (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	*a = _umul128(*a, *b, b);
+#else
+	uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32);
+	uint64_t carry = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+	carry += lo < t;
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+/** @brief Multiplies two words and folds the 128-bit product to 64 bits. */
+static inline uint64_t strsafe_hash_mix(uint64_t a, uint64_t b) {
+	strsafe_hash_mum(&a, &b);
+	return a ^ b;
+}
+
+/** @brief Loads 8 bytes in native byte order. */
+static inline uint64_t strsafe_hash_read8(const unsigned char* p) {
+	uint64_t v;
+	memcpy(&v, p, 8);
+	return v;
+}
+
+/** @brief Loads 4 bytes in native byte order. */
+static inline uint64_t strsafe_hash_read4(const unsigned char* p) {
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+/**
+ * @brief Hashes `len` bytes with a seed.
+ *
+ * Follows the wyhash construction: three independent 128-bit multiply lanes over 48-byte
+ * rounds, overlapping loads for the tail, and no per-byte loop. Results depend on the
+ * byte order of the target, so do not persist them across platforms.
+ *
+ * @param bytes Bytes to hash.
+ * @param len Number of bytes.
+ * @param seed Seed; different seeds give independent hash functions.
+ * @return 64-bit hash.
+ */
+static inline uint64_t strsafe_hash_n(const char* bytes, size_t len, uint64_t seed) {
+	static const uint64_t secret[4] = {
+		0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+	};
+	const unsigned char* p = (const unsigned char*)bytes;
+	uint64_t a, b;
+	seed ^= strsafe_hash_mix(seed ^ secret[0], secret[1]);
+
+	if (len <= 16) {
+		if (len >= 4) {
+			size_t mid = (len >> 3) << 2;
+			a = (strsafe_hash_read4(p) << 32) | strsafe_hash_read4(p + mid);
+			b = (strsafe_hash_read4(p + len - 4) << 32) | strsafe_hash_read4(p + len - 4 - mid);
+		}
+		else if (len > 0) {
+			a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+			b = 0;
+		}
+		else {
+			a = b = 0;
+		}
+	}
+	else {
+		size_t i = len;
+		if (i >= 48) {
+			uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = strsafe_hash_mix(strsafe_hash_read8(p) ^ secret[1], strsafe_hash_read8(p + 8) ^ seed);
+				see1 = strsafe_hash_mix(strsafe_hash_read8(p + 16) ^ secret[2], strsafe_hash_read8(p + 24) ^ see1);
+				see2 = strsafe_hash_mix(strsafe_hash_read8(p + 32) ^ secret[3], strsafe_hash_read8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i >= 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = strsafe_hash_mix(strsafe_hash_read8(p) ^ secret[1], strsafe_hash_read8(p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+		}
+		a = strsafe_hash_read8(p + i - 16);
+		b = strsafe_hash_read8(p + i - 8);
 	}
 
-	size_t rem_len = strlen(start);
-	result.arr = realloc(result.arr, sizeof(StrSafe) * (result.array_size + 1));
-	StrSafe* last = &result.arr[result.array_size++];
-	last->data = malloc(rem_len + 1);
-	memcpy(last->data, start, rem_len + 1);
-	last->len = rem_len;
-	last->cap = rem_len + 1;
+	a ^= secret[1];
+	b ^= seed;
+	strsafe_hash_mum(&a, &b);
+	return strsafe_hash_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
 
-	return result;
+/**
+ * @brief Hashes the contents of a `StrSafe`.
+ * @param src The string.
+ * @return 64-bit hash, equal for strings with equal contents.
+ */
+static inline uint64_t strsafe_hash(const StrSafe* src) {
+	return strsafe_hash_n(strsafe_cstr(src), strsafe_length(src), 0);
 }
 
 /**
- * @brief Sets the content of a `StrSafe` from a C-string.
- * @param dst Destination string.
- * @param src Source C-string.
- * @return Pointer to `dst`, or `NULL` on failure.
+ * @brief Hashes the contents of a `StrSafe` with a seed.
+ * @param src The string.
+ * @param seed Seed for the hash.
+ * @return 64-bit hash.
  */
-static inline StrSafe* strsafe_set(StrSafe* dst, const char* src) {
-	size_t src_len = strlen(src);
-	if (!strsafe_ensure_capacity(dst, src_len + 1)) return NULL;
+static inline uint64_t strsafe_hash_seeded(const StrSafe* src, uint64_t seed) {
+	return strsafe_hash_n(strsafe_cstr(src), strsafe_length(src), seed);
+}
 
-	memcpy(dst->data, src, src_len + 1);
-	dst->len = src_len;
-	return dst;
+/**
+ * @brief Hashes the bytes of a view; equal to `strsafe_hash` of a string with the same bytes.
+ * @param view The bytes.
+ * @return 64-bit hash.
+ */
+static inline uint64_t strsafe_view_hash(StrSafe_view view) {
+	return strsafe_hash_n(view.ptr, view.len, 0);
 }
 
 /**
- * @brief Finds the first occurrence of `needle` in `haystack`.
- * @param haystack The string to search.
- * @param needle The substring to find.
- * @return Position of match or -1 if not found.
+ * @brief Hashes the bytes of a view with a seed.
+ * @param view The bytes.
+ * @param seed Seed for the hash.
+ * @return 64-bit hash.
  */
-static inline ssize_t strsafe_find(StrSafe* haystack, const StrSafe* needle) {
-	char* pos = strstr(haystack->data, needle->data);
-	return pos ? (ssize_t)(pos - haystack->data) : -1;
+static inline uint64_t strsafe_view_hash_seeded(StrSafe_view view, uint64_t seed) {
+	return strsafe_hash_n(view.ptr, view.len, seed);
 }
 
 /**
- * @brief Finds the first occurrence of `needle` in `haystack` starting from `pos`.
- * @param haystack The string to search.
- * @param needle The substring to find.
- * @param pos Starting position.
- * @return Position of match or -1 if not found.
+ * @brief Hashes a null-terminated string; equal to `strsafe_hash` of a string with the same bytes.
+ * @param src The string.
+ * @return 64-bit hash.
  */
-static inline ssize_t strsafe_find_from_pos(StrSafe* haystack, const StrSafe* needle, size_t pos) {
-	if (pos >= haystack->len) return -1;
-	char* start = haystack->data + pos;
-	char* found = strstr(start, needle->data);
-	return found ? (ssize_t)(found - haystack->data) : -1;
+static inline uint64_t cstr_hash(const char* src) {
+	return strsafe_hash_n(src, strlen(src), 0);
 }
 
 /**
- * @brief Compares two `StrSafe` strings for equality.
+ * @brief Takes over `src` and caches its hash.
+ * @param dst Receives the string; must not hold a string already.
+ * @param src String moved into `dst`; left empty.
+ */
+static inline void strsafe_hashed_from(StrSafe_hashed* dst, StrSafe* src) {
+	dst->str = *src;
+	strsafe_init(src);
+	dst->hash = strsafe_hash(&dst->str);
+}
+
+/**
+ * @brief Recomputes the cached hash after `str` was modified.
+ * @param hashed The string.
+ */
+static inline void strsafe_hashed_rehash(StrSafe_hashed* hashed) {
+	hashed->hash = strsafe_hash(&hashed->str);
+}
+
+/**
+ * @brief Compares two hashed strings, rejecting on the cached hashes before comparing bytes.
  * @param a First string.
  * @param b Second string.
  * @return `true` if equal, `false` otherwise.
  */
-static inline bool strsafe_compare(const StrSafe* a, const StrSafe* b) {
-	if (a->len != b->len) return false;
-	return memcmp(a->data, b->data, a->len) == 0;
+static inline bool strsafe_hashed_compare(const StrSafe_hashed* a, const StrSafe_hashed* b) {
+	return a->hash == b->hash && strsafe_compare(&a->str, &b->str);
 }
 
 /**
- * @brief Copies the content of one `StrSafe` to another.
- * @param dst Destination string.
- * @param src Source string.
- * @return `true` if successful, `false` on allocation failure.
+ * @brief Frees the string of a `StrSafe_hashed`.
+ * @param hashed The string.
  */
-static inline bool strsafe_copy(StrSafe* dst, const StrSafe* src) {
-	if (!strsafe_ensure_capacity(dst, src->len + 1)) return false;
-	memcpy(dst->data, src->data, src->len + 1);
-	dst->len = src->len;
-	return true;
+static inline void strsafe_hashed_free(StrSafe_hashed* hashed) {
+	strsafe_free(&hashed->str);
+	hashed->hash = strsafe_hash(&hashed->str);
 }
 
 /**
- * @brief Counts how many times `needle` appears in `dst`.
- * @param haystack The string to search.
- * @param needle The substring to count.
- * @return Number of occurrences.
+ * @brief Copies the contents of a view into a `StrSafe`.
+ * @param dst Destination string; `view` may not point into it.
+ * @param view Source view.
+ * @return Pointer to `dst`, or `NULL` on allocation failure.
  */
-static inline size_t strsafe_count(const StrSafe* haystack, const StrSafe* needle) {
-	size_t count = 0;
-	const char* p = haystack->data;
-	while ((p = strstr(p, needle->data))) {
-		++count;
-		p += needle->len;
-	}
-	return count;
+static inline StrSafe* strsafe_set_view(StrSafe* dst, StrSafe_view view) {
+	return strsafe_assign(dst, view.ptr, view.len);
 }
 
 /**
- * @brief Inserts a string into another at a given position.
- * @param dst Destination string.
- * @param pos Position to insert at.
- * @param ins String to insert.
- * @return `true` if successful, `false` otherwise.
+ * @brief Initializes a `StrSafe_view_array` to empty.
+ * @param views Pointer to the array.
  */
-static inline bool strsafe_insert(StrSafe* dst, size_t pos, const StrSafe* ins) {
-	if (pos > dst->len) return false;
+static inline void strsafe_view_array_init(StrSafe_view_array* views) {
+	views->views = NULL;
+	views->count = 0;
+	views->cap = 0;
+}
 
-	size_t new_len = dst->len + ins->len;
-	if (!strsafe_ensure_capacity(dst, new_len + 1)) return false;
+/**
+ * @brief Frees the storage of a `StrSafe_view_array`; the viewed buffers are untouched.
+ * @param views Pointer to the array.
+ */
+static inline void strsafe_view_array_free(StrSafe_view_array* views) {
+	STRSAFE_FREE(views->views);
+	strsafe_view_array_init(views);
+}
 
-	memmove(dst->data + pos + ins->len, dst->data + pos, dst->len - pos + 1);
-	memcpy(dst->data + pos, ins->data, ins->len);
-	dst->len = new_len;
+/**
+ * @brief Appends a view, growing the storage geometrically.
+ * @param views Pointer to the array.
+ * @param view View to append.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_view_array_push(StrSafe_view_array* views, StrSafe_view view) {
+	if (views->count == views->cap) {
+		size_t new_cap = views->cap ? views->cap * 2 : 16;
+		StrSafe_view* grown = (StrSafe_view*)STRSAFE_REALLOC(views->views, sizeof(StrSafe_view) * new_cap);
+		if (!grown) return false;
+		views->views = grown;
+		views->cap = new_cap;
+	}
+	views->views[views->count++] = view;
 	return true;
 }
 
 /**
- * @brief Extracts a substring from a `StrSafe`.
- * @param sub_string Target string to hold the substring.
- * @param pos Starting position.
- * @param len Length of substring.
- * @return Pointer to `sub_string`, or `NULL` on failure.
+ * @brief Splits a view on a prepared needle into views of the same buffer.
+ *
+ * `out` is cleared first and its storage reused, so splitting many records with one
+ * array performs no allocation once it has grown. An empty delimiter yields `src` whole.
+ *
+ * @param src The view to split.
+ * @param delim Prepared needle for the delimiter.
+ * @param out Array receiving the fields.
+ * @return `true` if successful, `false` on allocation failure.
  */
-static inline StrSafe* strsafe_substr(StrSafe* sub_string, const size_t pos, const size_t len) {
-	if (pos >= sub_string->len) {
-		strsafe_free(sub_string);
-		strsafe_init(sub_string);
-		return sub_string;
+static inline bool strsafe_needle_split_view(StrSafe_view src, const StrSafe_needle* delim, StrSafe_view_array* out) {
+	out->count = 0;
+	const char* start = src.ptr;
+	const char* end = src.ptr + src.len;
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_SPLIT, src.len);
+	if (delim->len > 0) {
+		const char* found;
+		while ((found = strsafe_needle_search(start, end - start, delim))) {
+			if (!strsafe_view_array_push(out, strsafe_view_make(start, found - start))) return false;
+			start = found + delim->len;
+		}
 	}
-
-	size_t actual_len = (pos + len > sub_string->len) ? (sub_string->len - pos) : len;
-	char* buffer = malloc(actual_len + 1);
-	if (!buffer) return NULL;
-
-	memcpy(buffer, sub_string->data + pos, actual_len);
-	buffer[actual_len] = '\0';
-
-	strsafe_free(sub_string);
-	sub_string->data = buffer;
-	sub_string->len = actual_len;
-	sub_string->cap = actual_len + 1;
-	return sub_string;
+	return strsafe_view_array_push(out, strsafe_view_make(start, end - start));
 }
 
 /**
- * @brief Replaces the first occurrence of a substring with another.
- * @param dst Target string.
- * @param old_str Substring to replace.
- * @param new_str Replacement string.
- * @return `true` if successful, `false` otherwise.
+ * @brief Splits a view on `delim` into views of the same buffer.
+ *
+ * `out` is cleared first and its storage reused, so splitting many records with one
+ * array performs no allocation once it has grown. An empty delimiter yields `src` whole.
+ *
+ * @param src The view to split.
+ * @param delim The delimiter.
+ * @param out Array receiving the fields.
+ * @return `true` if successful, `false` on allocation failure.
  */
-static inline bool strsafe_replace(StrSafe* dst, const StrSafe* old_str, const StrSafe* new_str) {
-	ssize_t pos = cstr_find(dst, old_str->data);
-	if (pos < 0) return true;
+static inline bool strsafe_view_split(StrSafe_view src, StrSafe_view delim, StrSafe_view_array* out) {
+	StrSafe_needle prepared;
+	strsafe_needle_init(&prepared, delim.ptr, delim.len);
+	return strsafe_needle_split_view(src, &prepared, out);
+}
 
-	size_t final_len = dst->len - old_str->len + new_str->len;
-	char* buffer = malloc(final_len + 1);
-	if (!buffer) return false;
+/**
+ * @brief Splits a `StrSafe` on a C-string delimiter into views of its buffer.
+ * @param src The string to split.
+ * @param delim The delimiter string.
+ * @param out Array receiving the fields; cleared and reused.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool cstr_split_view(const StrSafe* src, const char* delim, StrSafe_view_array* out) {
+	return strsafe_view_split(strsafe_view_of(src), strsafe_view_from_cstr(delim), out);
+}
 
-	memcpy(buffer, dst->data, pos);
-	memcpy(buffer + pos, new_str->data, new_str->len);
-	memcpy(buffer + pos + new_str->len, dst->data + pos + old_str->len, dst->len - pos - old_str->len);
-	buffer[final_len] = '\0';
+/**
+ * @brief Splits a `StrSafe` on a `StrSafe` delimiter into views of its buffer.
+ * @param src The string to split.
+ * @param delim The delimiter string.
+ * @param out Array receiving the fields; cleared and reused.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_split_view(const StrSafe* src, const StrSafe* delim, StrSafe_view_array* out) {
+	return strsafe_view_split(strsafe_view_of(src), strsafe_view_of(delim), out);
+}
 
-	free(dst->data);
-	dst->data = buffer;
-	dst->len = final_len;
-	dst->cap = final_len + 1;
+/**
+ * @brief Gives `dst` a private buffer of at least `min_cap` bytes whose contents may be discarded.
+ *
+ * Unlike `strsafe_reserve_ex` the old contents are not carried over, so a string about to
+ * be overwritten is never copied; on failure `dst` is unchanged.
+ *
+ * @param dst The string to be overwritten.
+ * @param min_cap Capacity needed.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_reserve_discard_ex(StrSafe* dst, size_t min_cap, const StrSafe_allocator* allocator) {
+	if (!strsafe_is_shared(dst) && strsafe_capacity(dst) >= min_cap) return true;
+	StrSafe fresh;
+	strsafe_init(&fresh);
+	if (!strsafe_reserve_ex(&fresh, min_cap, allocator)) return false;
+	strsafe_free_ex(dst, allocator);
+	*dst = fresh;
 	return true;
 }
 
 /**
- * @brief Replaces all occurrences of a substring with another.
- * @param dst Target string.
- * @param old_str Substring to replace.
- * @param new_str Replacement string.
- * @return `true` if successful, `false` otherwise.
+ * @brief Length of the elements of an array joined with a delimiter.
+ * @param arr The strings to join.
+ * @param delim_len Number of bytes in the delimiter.
+ * @return Joined length without the null terminator, or `SIZE_MAX` if it overflows.
  */
-static inline bool strsafe_replace_all(StrSafe* dst, const StrSafe* old_str, const StrSafe* new_str) {
-	size_t count = strsafe_count(dst, old_str);
-	if (count == 0) return true;
+static inline size_t strsafe_array_join_length(const StrSafe_array* arr, size_t delim_len) {
+	if (arr->array_size <= 0) return 0;
+	size_t total = 0;
+	for (int i = 0; i < arr->array_size; ++i) {
+		size_t len = strsafe_length(&arr->arr[i]);
+		if (len > SIZE_MAX - total) return SIZE_MAX;
+		total += len;
+	}
+	size_t gaps = (size_t)arr->array_size - 1;
+	if (delim_len && gaps > (SIZE_MAX - total) / delim_len) return SIZE_MAX;
+	return total + gaps * delim_len;
+}
 
-	size_t final_len = dst->len + count * (new_str->len - old_str->len);
-	char* buffer = malloc(final_len + 1);
-	if (!buffer) return false;
+/**
+ * @brief Length of views joined with a delimiter.
+ * @param views The views to join.
+ * @param count Number of views.
+ * @param delim_len Number of bytes in the delimiter.
+ * @return Joined length without the null terminator, or `SIZE_MAX` if it overflows.
+ */
+static inline size_t strsafe_view_join_length(const StrSafe_view* views, size_t count, size_t delim_len) {
+	if (count == 0) return 0;
+	size_t total = 0;
+	for (size_t i = 0; i < count; ++i) {
+		if (views[i].len > SIZE_MAX - total) return SIZE_MAX;
+		total += views[i].len;
+	}
+	if (delim_len && count - 1 > (SIZE_MAX - total) / delim_len) return SIZE_MAX;
+	return total + (count - 1) * delim_len;
+}
 
-	char* src = dst->data;
-	char* out = buffer;
-	while (*src) {
-		if (strncmp(src, old_str->data, old_str->len) == 0) {
-			memcpy(out, new_str->data, new_str->len);
-			out += new_str->len;
-			src += old_str->len;
+/**
+ * @brief Writes the elements of an array joined with a delimiter; the caller sized `out`.
+ * @param out Destination with room for `strsafe_array_join_length` bytes.
+ * @param arr The strings to join; must be non-empty.
+ * @param delim Delimiter bytes.
+ * @param delim_len Number of bytes in `delim`.
+ * @return One past the last byte written.
+ */
+static inline char* strsafe_array_join_write(char* out, const StrSafe_array* arr, const char* delim, size_t delim_len) {
+	size_t len = strsafe_length(&arr->arr[0]);
+	memcpy(out, strsafe_cstr(&arr->arr[0]), len);
+	out += len;
+	if (delim_len == 1) {
+		// the common single-byte separator is a store rather than a call
+		char sep = delim[0];
+		for (int i = 1; i < arr->array_size; ++i) {
+			*out++ = sep;
+			len = strsafe_length(&arr->arr[i]);
+			memcpy(out, strsafe_cstr(&arr->arr[i]), len);
+			out += len;
 		}
-		else {
-			*out++ = *src++;
+		return out;
+	}
+	for (int i = 1; i < arr->array_size; ++i) {
+		memcpy(out, delim, delim_len);
+		out += delim_len;
+		len = strsafe_length(&arr->arr[i]);
+		memcpy(out, strsafe_cstr(&arr->arr[i]), len);
+		out += len;
+	}
+	return out;
+}
+
+/**
+ * @brief Writes views joined with a delimiter; the caller sized `out`.
+ * @param out Destination with room for `strsafe_view_join_length` bytes.
+ * @param views The views to join; `count` must be non-zero.
+ * @param count Number of views.
+ * @param delim Delimiter bytes.
+ * @param delim_len Number of bytes in `delim`.
+ * @return One past the last byte written.
+ */
+static inline char* strsafe_view_join_write(char* out, const StrSafe_view* views, size_t count, const char* delim, size_t delim_len) {
+	memcpy(out, views[0].ptr, views[0].len);
+	out += views[0].len;
+	if (delim_len == 1) {
+		char sep = delim[0];
+		for (size_t i = 1; i < count; ++i) {
+			*out++ = sep;
+			memcpy(out, views[i].ptr, views[i].len);
+			out += views[i].len;
 		}
+		return out;
+	}
+	for (size_t i = 1; i < count; ++i) {
+		memcpy(out, delim, delim_len);
+		out += delim_len;
+		memcpy(out, views[i].ptr, views[i].len);
+		out += views[i].len;
 	}
-	*out = '\0';
+	return out;
+}
 
-	free(dst->data);
-	dst->data = buffer;
-	dst->len = final_len;
-	dst->cap = final_len + 1;
+/**
+ * @brief Joins the elements of an array with a delimiter into `dst`, allocating from `allocator`.
+ *
+ * The inverse of `cstr_split`: the exact length is computed first, so `dst` is allocated at
+ * most once, to exactly that size, and the elements are copied in a single pass. The previous contents of `dst` are
+ * replaced; an empty array yields an empty string.
+ *
+ * @param dst Receives the joined string; must not be an element of `arr`.
+ * @param arr The strings to join.
+ * @param delim Delimiter bytes placed between elements; must not point into `dst`.
+ * @param delim_len Number of bytes in `delim`.
+ * @param allocator Allocator owning the buffer of `dst`, or `NULL` for the default heap.
+ * @return `true` if successful, `false` on allocation failure (`dst` is unchanged).
+ */
+static inline bool strsafe_array_join_n_ex(StrSafe* dst, const StrSafe_array* arr, const char* delim, size_t delim_len, const StrSafe_allocator* allocator) {
+	size_t total = strsafe_array_join_length(arr, delim_len);
+	if (total == SIZE_MAX || !strsafe_reserve_discard_ex(dst, total + 1, allocator)) return false;
+	char* data = strsafe_data(dst);
+	if (arr->array_size > 0) strsafe_array_join_write(data, arr, delim, delim_len);
+	data[total] = '\0';
+	strsafe_set_length(dst, total);
 	return true;
 }
 
 /**
- * @brief Removes the first occurrence of a substring.
- * @param dst Target string.
- * @param str_to_remove Substring to remove.
- * @return `true` if successful, `false` otherwise.
+ * @brief Joins the elements of an array with `delim_len` bytes of `delim` into `dst`.
+ * @param dst Receives the joined string; its previous contents are replaced.
+ * @param arr The strings to join.
+ * @param delim Delimiter bytes placed between elements.
+ * @param delim_len Number of bytes in `delim`.
+ * @return `true` if successful, `false` on allocation failure.
  */
-static inline bool strsafe_remove(StrSafe* dst, const StrSafe* str_to_remove) {
-	ssize_t pos = cstr_find(dst, str_to_remove->data);
-	if (pos < 0) return true;
+static inline bool strsafe_array_join_n(StrSafe* dst, const StrSafe_array* arr, const char* delim, size_t delim_len) {
+	return strsafe_array_join_n_ex(dst, arr, delim, delim_len, NULL);
+}
 
-	memmove(dst->data + pos, dst->data + pos + str_to_remove->len, dst->len - pos - str_to_remove->len + 1);
-	dst->len -= str_to_remove->len;
-	strsafe_trim(dst);
-	return true;
+/**
+ * @brief Joins the elements of an array with a `StrSafe` delimiter into `dst`.
+ * @param dst Receives the joined string; its previous contents are replaced.
+ * @param arr The strings to join.
+ * @param delim Delimiter placed between elements.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_array_join(StrSafe* dst, const StrSafe_array* arr, const StrSafe* delim) {
+	return strsafe_array_join_n(dst, arr, strsafe_cstr(delim), strsafe_length(delim));
 }
 
 /**
- * @brief Removes all occurrences of a substring.
- * @param dst Target string.
- * @param str_to_remove Substring to remove.
- * @return `true` if successful, `false` otherwise.
+ * @brief Joins the elements of an array with a C-string delimiter into `dst`.
+ * @param dst Receives the joined string; its previous contents are replaced.
+ * @param arr The strings to join.
+ * @param delim Delimiter placed between elements.
+ * @return `true` if successful, `false` on allocation failure.
  */
-static inline bool strsafe_remove_all(StrSafe* dst, const StrSafe* str_to_remove) {
-	char* src = dst->data;
-	char* out = dst->data;
-	while (*src) {
-		if (strncmp(src, str_to_remove->data, str_to_remove->len) == 0) {
-			src += str_to_remove->len;
-		}
-		else {
-			*out++ = *src++;
-		}
-	}
-	*out = '\0';
-	dst->len = out - dst->data;
-	strsafe_trim(dst);
+static inline bool cstr_array_join(StrSafe* dst, const StrSafe_array* arr, const char* delim) {
+	return strsafe_array_join_n(dst, arr, delim, strlen(delim));
+}
+
+/**
+ * @brief Joins views with a delimiter into `dst`, growing it at most once.
+ * @param dst Receives the joined string; its previous contents are replaced.
+ * @param views The views to join; none may point into `dst`.
+ * @param count Number of views.
+ * @param delim Delimiter placed between views.
+ * @return `true` if successful, `false` on allocation failure (`dst` is unchanged).
+ */
+static inline bool strsafe_view_join(StrSafe* dst, const StrSafe_view* views, size_t count, StrSafe_view delim) {
+	size_t total = strsafe_view_join_length(views, count, delim.len);
+	if (total == SIZE_MAX || !strsafe_reserve_discard_ex(dst, total + 1, NULL)) return false;
+	char* data = strsafe_data(dst);
+	if (count > 0) strsafe_view_join_write(data, views, count, delim.ptr, delim.len);
+	data[total] = '\0';
+	strsafe_set_length(dst, total);
 	return true;
 }
 
 /**
- * @brief Appends one `StrSafe` string to another.
- * @param dst Destination string.
- * @param suffix String to append.
- * @return `true` if successful, `false` otherwise.
+ * @brief Joins the views of a `StrSafe_view_array` with a delimiter into `dst`.
+ *
+ * Together with `strsafe_split_view` this rewrites the fields of a record without copying
+ * them into strings of their own.
+ *
+ * @param dst Receives the joined string; its previous contents are replaced.
+ * @param views The fields to join; none may point into `dst`.
+ * @param delim Delimiter placed between fields.
+ * @return `true` if successful, `false` on allocation failure.
  */
-static inline bool strsafe_append(StrSafe* dst, const StrSafe* suffix) {
-	size_t new_len = dst->len + suffix->len;
-	if (!strsafe_ensure_capacity(dst, new_len + 1)) return false;
+static inline bool strsafe_view_array_join(StrSafe* dst, const StrSafe_view_array* views, StrSafe_view delim) {
+	return strsafe_view_join(dst, views->views, views->count, delim);
+}
 
-	memcpy(dst->data + dst->len, suffix->data, suffix->len);
-	dst->len = new_len;
-	dst->data[new_len] = '\0';
-	return true;
+/**
+ * @brief Joins views with a delimiter into a caller-provided buffer without allocating.
+ *
+ * Nothing is written unless the result and its null terminator fit, so a caller can size
+ * the buffer from the return value and call again.
+ *
+ * @param buf Destination buffer.
+ * @param buf_size Size of `buf` in bytes.
+ * @param views The views to join.
+ * @param count Number of views.
+ * @param delim Delimiter placed between views.
+ * @return Joined length without the null terminator; it was written only if less than `buf_size`.
+ */
+static inline size_t strsafe_view_join_to(char* buf, size_t buf_size, const StrSafe_view* views, size_t count, StrSafe_view delim) {
+	size_t total = strsafe_view_join_length(views, count, delim.len);
+	if (total >= buf_size) return total;
+	if (count > 0) strsafe_view_join_write(buf, views, count, delim.ptr, delim.len);
+	buf[total] = '\0';
+	return total;
 }
 
 /**
- * @brief Appends multiple `StrSafe` strings to a destination.
- * @param dst Destination string.
- * @param first First string to append.
- * @param ... Additional strings, terminated by `NULL`.
- * @return `true` if successful, `false` otherwise.
+ * @brief Joins the elements of an array with a delimiter into a caller-provided buffer.
+ *
+ * Nothing is written unless the result and its null terminator fit.
+ *
+ * @param buf Destination buffer.
+ * @param buf_size Size of `buf` in bytes.
+ * @param arr The strings to join.
+ * @param delim Delimiter placed between elements.
+ * @return Joined length without the null terminator; it was written only if less than `buf_size`.
  */
-static inline bool strsafe_appendv(StrSafe* dst, const StrSafe* first, ...) {
-	va_list args;
-	va_start(args, first);
+static inline size_t strsafe_array_join_to(char* buf, size_t buf_size, const StrSafe_array* arr, StrSafe_view delim) {
+	size_t total = strsafe_array_join_length(arr, delim.len);
+	if (total >= buf_size) return total;
+	if (arr->array_size > 0) strsafe_array_join_write(buf, arr, delim.ptr, delim.len);
+	buf[total] = '\0';
+	return total;
+}
 
-	size_t total_len = first->len;
-	const StrSafe* s;
-	while ((s = va_arg(args, const StrSafe*))) {
-		total_len += s->len;
-	}
-	va_end(args);
+/**
+ * @brief Initializes a `StrSafe_packed_array` to empty.
+ * @param packed Array to initialize.
+ */
+static inline void strsafe_packed_array_init(StrSafe_packed_array* packed) {
+	memset(packed, 0, sizeof(*packed));
+}
 
-	if (!strsafe_ensure_capacity(dst, dst->len + total_len + 1)) return false;
+/**
+ * @brief Frees the storage of a `StrSafe_packed_array`.
+ * @param packed Array to free; it is left empty.
+ */
+static inline void strsafe_packed_array_free(StrSafe_packed_array* packed) {
+	STRSAFE_FREE(packed->blob);
+	STRSAFE_FREE(packed->offsets);
+	strsafe_packed_array_init(packed);
+}
 
-	va_start(args, first);
-	memcpy(dst->data + dst->len, first->data, first->len);
-	dst->len += first->len;
+/**
+ * @brief Removes all elements but keeps the storage for reuse.
+ * @param packed Array to clear.
+ */
+static inline void strsafe_packed_array_clear(StrSafe_packed_array* packed) {
+	packed->blob_len = 0;
+	packed->count = 0;
+}
 
-	while ((s = va_arg(args, const StrSafe*))) {
-		memcpy(dst->data + dst->len, s->data, s->len);
-		dst->len += s->len;
+/**
+ * @brief Resizes the buffers of a packed array to at least the given sizes.
+ * @param packed Array to grow.
+ * @param offsets_cap Entries needed in `offsets`.
+ * @param blob_cap Bytes needed in `blob`.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_packed_array_grow(StrSafe_packed_array* packed, size_t offsets_cap, size_t blob_cap) {
+	if (offsets_cap > packed->offsets_cap) {
+		size_t* grown = (size_t*)STRSAFE_REALLOC(packed->offsets, sizeof(size_t) * offsets_cap);
+		if (!grown) return false;
+		if (packed->offsets_cap == 0) grown[0] = 0;
+		packed->offsets = grown;
+		packed->offsets_cap = offsets_cap;
+	}
+	if (blob_cap > packed->blob_cap) {
+		char* grown = (char*)STRSAFE_REALLOC(packed->blob, blob_cap);
+		if (!grown) return false;
+		packed->blob = grown;
+		packed->blob_cap = blob_cap;
 	}
-	dst->data[dst->len] = '\0';
-	va_end(args);
-
 	return true;
 }
 
 /**
- * @brief Splits a string into an array using a delimiter.
- * @param src Source string.
- * @param delim Delimiter string.
- * @return Array of substrings.
+ * @brief Makes room for `count` elements holding `bytes` bytes in total.
+ * @param packed Array to reserve in.
+ * @param count Number of elements to hold.
+ * @param bytes Total length of those elements, not counting null terminators.
+ * @return `true` if successful, `false` on allocation failure.
  */
-static inline StrSafe_array strsafe_split_at(const StrSafe* src, size_t pos) {
-	StrSafe_array result = { NULL, 0 };
+static inline bool strsafe_packed_array_reserve(StrSafe_packed_array* packed, size_t count, size_t bytes) {
+	return strsafe_packed_array_grow(packed, count + 1, bytes + count);
+}
 
-	// clamp pos into [0..src->len]
-	if (pos > src->len) {
-		pos = src->len;
+/**
+ * @brief Appends a copy of `len` bytes of `src`; both buffers double when full.
+ * @param packed Array to append to.
+ * @param src Bytes of the new element.
+ * @param len Number of bytes in `src`.
+ * @return `true` if successful, `false` on allocation failure (the array is unchanged).
+ */
+static inline bool strsafe_packed_array_push(StrSafe_packed_array* packed, const char* src, size_t len) {
+	size_t offsets_need = packed->count + 2;
+	size_t blob_need = packed->blob_len + len + 1;
+	if (offsets_need > packed->offsets_cap || blob_need > packed->blob_cap) {
+		size_t offsets_cap = packed->offsets_cap ? packed->offsets_cap : 16;
+		size_t blob_cap = packed->blob_cap ? packed->blob_cap : 64;
+		while (offsets_cap < offsets_need) offsets_cap *= 2;
+		while (blob_cap < blob_need) blob_cap *= 2;
+		if (!strsafe_packed_array_grow(packed, offsets_cap, blob_cap)) return false;
 	}
 
-	// allocate space for two segments
-	result.arr = malloc(sizeof(StrSafe) * 2);
-	if (!result.arr) {
-		return result;  // array_size stays 0 on alloc failure
-	}
+	memcpy(packed->blob + packed->blob_len, src, len);
+	packed->blob[packed->blob_len + len] = '\0';
+	packed->blob_len = blob_need;
+	packed->offsets[++packed->count] = blob_need;
+	return true;
+}
 
-	// first segment = src->data[0 .. pos-1]
-	StrSafe* seg0 = &result.arr[result.array_size++];
-	seg0->len = pos;
-	seg0->cap = pos + 1;
-	seg0->data = malloc(seg0->cap);
-	if (seg0->data) {
-		memcpy(seg0->data, src->data, pos);
-		seg0->data[pos] = '\0';
+/**
+ * @brief Returns element `index` of a packed array as a view of its storage.
+ * @param packed The array.
+ * @param index Element index, below `packed->count`.
+ * @return View of the element; invalidated when the array grows or is freed.
+ */
+static inline StrSafe_view strsafe_packed_array_get(const StrSafe_packed_array* packed, size_t index) {
+	size_t start = packed->offsets[index];
+	return strsafe_view_make(packed->blob + start, packed->offsets[index + 1] - start - 1);
+}
+
+/**
+ * @brief Returns element `index` of a packed array as a null-terminated string.
+ * @param packed The array.
+ * @param index Element index, below `packed->count`.
+ * @return Pointer into the array storage; invalidated when the array grows or is freed.
+ */
+static inline const char* strsafe_packed_array_cstr(const StrSafe_packed_array* packed, size_t index) {
+	return packed->blob + packed->offsets[index];
+}
+
+/**
+ * @brief Splits a view on a prepared needle into a packed array.
+ *
+ * Fields are counted first so `out` is sized exactly: splitting into an empty array
+ * costs two allocations however many fields there are, and none once `out` is large
+ * enough. `out` is cleared first. An empty delimiter yields `src` whole.
+ *
+ * @param src The view to split.
+ * @param delim Prepared needle for the delimiter.
+ * @param out Array receiving copies of the fields.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_needle_split_packed(StrSafe_view src, const StrSafe_needle* delim, StrSafe_packed_array* out) {
+	strsafe_packed_array_clear(out);
+	const char* start = src.ptr;
+	const char* end = src.ptr + src.len;
+	const char* found;
+
+	size_t fields = 1;
+	if (delim->len > 0) {
+		for (const char* p = start; (found = strsafe_needle_search(p, end - p, delim)); p = found + delim->len) {
+			++fields;
+		}
 	}
+	if (!strsafe_packed_array_reserve(out, fields, src.len - (fields - 1) * delim->len)) return false;
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_SPLIT, src.len * 2);
+	STRSAFE_STAT(STRSAFE_STAT_SPLIT, STRSAFE_EVENT_COPY, src.len - (fields - 1) * delim->len);
 
-	// second segment = src->data[pos .. end]
-	size_t rem_len = src->len - pos;
-	StrSafe* seg1 = &result.arr[result.array_size++];
-	seg1->len = rem_len;
-	seg1->cap = rem_len + 1;
-	seg1->data = malloc(seg1->cap);
-	if (seg1->data) {
-		memcpy(seg1->data, src->data + pos, rem_len);
-		seg1->data[rem_len] = '\0';
+	if (delim->len > 0) {
+		while ((found = strsafe_needle_search(start, end - start, delim))) {
+			strsafe_packed_array_push(out, start, found - start);
+			start = found + delim->len;
+		}
 	}
+	return strsafe_packed_array_push(out, start, end - start);
+}
 
-	return result;
+/**
+ * @brief Splits a `StrSafe` on a C-string delimiter into a packed array.
+ * @param src The string to split.
+ * @param delim The delimiter string.
+ * @param out Array receiving copies of the fields; cleared and reused.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool cstr_split_packed(const StrSafe* src, const char* delim, StrSafe_packed_array* out) {
+	StrSafe_needle prepared;
+	strsafe_needle_init(&prepared, delim, strlen(delim));
+	return strsafe_needle_split_packed(strsafe_view_of(src), &prepared, out);
+}
+
+/**
+ * @brief Splits a `StrSafe` on a `StrSafe` delimiter into a packed array.
+ * @param src The string to split.
+ * @param delim The delimiter string.
+ * @param out Array receiving copies of the fields; cleared and reused.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_split_packed(const StrSafe* src, const StrSafe* delim, StrSafe_packed_array* out) {
+	StrSafe_needle prepared;
+	strsafe_needle_of(&prepared, delim);
+	return strsafe_needle_split_packed(strsafe_view_of(src), &prepared, out);
 }
 
 #endif // SAFE_STR_H
@@ -0,0 +1,332 @@
+
+/**
+ * @file StrSafe.hpp
+ * @brief Optional C++17 wrapper: an owning `StrSafe` with move semantics and `std::string_view` interop.
+ *
+ * `strsafe::String` holds exactly one `StrSafe` and frees it in its destructor. Moving a
+ * `String` takes over the struct, so the buffer changes hands without `strsafe_copy`, and
+ * the moved-from object is left empty. Copies go through `strsafe_copy`, so copying a shared
+ * string only bumps its reference count.
+ *
+ * Text goes in and comes out as `std::string_view`, and `view()` points at the string's own
+ * bytes. `get()` hands the underlying `StrSafe` to C functions. `adopt` and `release`
+ * move ownership across the C/C++ boundary without copying, so a C function can build a
+ * string that C++ code then owns, and the other way round. `strsafe::Array` does the same
+ * for `StrSafe_array` and iterates its elements as `std::string_view`.
+ *
+ * Allocation failures that the C functions report as `false` or `NULL` throw
+ * `std::bad_alloc` here. Searches return `npos` instead of -1.
+ *
+ */
+
+#ifndef SAFE_STR_HPP
+#define SAFE_STR_HPP
+
+#if (defined(_MSVC_LANG) ? _MSVC_LANG : __cplusplus) < 201703L
+#error "StrSafe.hpp requires C++17"
+#endif
+
+#include "StrSafe.h"
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <string>
+#include <string_view>
+
+namespace strsafe {
+
+/** @brief Views the bytes of a `StrSafe` without copying them. */
+inline std::string_view to_string_view(const StrSafe& src) noexcept {
+	return std::string_view(strsafe_cstr(&src), strsafe_length(&src));
+}
+
+/** @brief Converts a C view to a `std::string_view` over the same bytes. */
+inline std::string_view to_string_view(StrSafe_view src) noexcept {
+	return std::string_view(src.ptr, src.len);
+}
+
+/** @brief Converts a `std::string_view` to a C view over the same bytes. */
+inline StrSafe_view to_view(std::string_view src) noexcept {
+	return strsafe_view_make(src.data(), src.size());
+}
+
+/**
+ * @class String
+ * @brief Owning, movable handle of one `StrSafe`.
+ */
+class String {
+public:
+	static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+	String() noexcept {
+		strsafe_init(&str_);
+	}
+
+	String(std::string_view text) {
+		strsafe_init(&str_);
+		if (!strsafe_assign(&str_, text.data(), text.size())) throw std::bad_alloc();
+	}
+
+	String(const char* text) : String(std::string_view(text)) {}
+
+	String(const String& other) {
+		strsafe_init(&str_);
+		if (!strsafe_copy(&str_, &other.str_)) throw std::bad_alloc();
+	}
+
+	String(String&& other) noexcept : str_(other.str_) {
+		strsafe_init(&other.str_);
+	}
+
+	~String() {
+		strsafe_free(&str_);
+	}
+
+	String& operator=(const String& other) {
+		if (this != &other && !strsafe_copy(&str_, &other.str_)) throw std::bad_alloc();
+		return *this;
+	}
+
+	String& operator=(String&& other) noexcept {
+		if (this != &other) strsafe_move(&str_, &other.str_);
+		return *this;
+	}
+
+	String& operator=(std::string_view text) {
+		if (aliases(text)) return *this = String(text);
+		if (!strsafe_assign(&str_, text.data(), text.size())) throw std::bad_alloc();
+		return *this;
+	}
+
+	/**
+	 * @brief Takes ownership of a string built by C code.
+	 * @param src String to take over; it is left empty and may be reused or freed.
+	 */
+	static String adopt(StrSafe* src) noexcept {
+		String result;
+		result.str_ = *src;
+		strsafe_init(src);
+		return result;
+	}
+
+	/**
+	 * @brief Gives up ownership of the underlying string and leaves this one empty.
+	 * @return The string; free it with `strsafe_free`.
+	 */
+	StrSafe release() noexcept {
+		StrSafe result = str_;
+		strsafe_init(&str_);
+		return result;
+	}
+
+	/** @brief The underlying string, for passing to C functions. */
+	StrSafe* get() noexcept { return &str_; }
+	const StrSafe* get() const noexcept { return &str_; }
+
+	std::string_view view() const noexcept { return to_string_view(str_); }
+	operator std::string_view() const noexcept { return view(); }
+	std::string str() const { return std::string(view()); }
+
+	/** @brief The contents, never null: an empty string that owns no buffer yields `""`. */
+	const char* c_str() const noexcept {
+		const char* bytes = strsafe_cstr(&str_);
+		return bytes ? bytes : "";
+	}
+	const char* data() const noexcept { return c_str(); }
+	std::size_t size() const noexcept { return strsafe_length(&str_); }
+	std::size_t length() const noexcept { return strsafe_length(&str_); }
+	std::size_t capacity() const noexcept { return strsafe_capacity(&str_); }
+	bool empty() const noexcept { return strsafe_length(&str_) == 0; }
+	bool shared() const noexcept { return strsafe_is_shared(&str_); }
+
+	const char* begin() const noexcept { return data(); }
+	const char* end() const noexcept { return data() + size(); }
+	char operator[](std::size_t pos) const noexcept { return data()[pos]; }
+
+	/** @brief Makes room for `count` bytes plus the terminator. */
+	void reserve(std::size_t count) {
+		if (!strsafe_reserve(&str_, count + 1)) throw std::bad_alloc();
+	}
+
+	/** @brief Empties the string, keeping its buffer unless it is shared. */
+	void clear() noexcept {
+		if (strsafe_is_shared(&str_)) {
+			strsafe_free(&str_);
+			strsafe_init(&str_);
+		}
+		else if (strsafe_length(&str_) > 0) {
+			strsafe_data(&str_)[0] = '\0';
+			strsafe_set_length(&str_, 0);
+		}
+	}
+
+	String& append(std::string_view text) {
+		if (aliases(text)) return append(String(text));
+		if (!cstr_append_n(&str_, text.data(), text.size())) throw std::bad_alloc();
+		return *this;
+	}
+
+	String& operator+=(std::string_view text) { return append(text); }
+
+	/** @brief Position of the first `needle` at or after `pos`, or `npos`. */
+	std::size_t find(std::string_view needle, std::size_t pos = 0) const noexcept {
+		ssize_t found = pos == 0 ? cstr_find_n(&str_, needle.data(), needle.size())
+			: cstr_find_from_pos_n(&str_, needle.data(), needle.size(), pos);
+		return found < 0 ? npos : static_cast<std::size_t>(found);
+	}
+
+	bool contains(std::string_view needle) const noexcept { return find(needle) != npos; }
+
+	/** @brief Number of non-overlapping occurrences of `needle`; 0 for an empty needle. */
+	std::size_t count(std::string_view needle) const noexcept {
+		return cstr_count_n(&str_, needle.data(), needle.size());
+	}
+
+	/** @brief Replaces every `old_text` with `new_text`; neither may point into this string. */
+	String& replace_all(std::string_view old_text, std::string_view new_text) {
+		if (!cstr_replace_all_n(&str_, old_text.data(), old_text.size(), new_text.data(), new_text.size())) throw std::bad_alloc();
+		return *this;
+	}
+
+	/** @brief Turns the buffer into a reference-counted one, so further copies share it. */
+	void share() {
+		if (!strsafe_make_shared_ex(&str_, NULL)) throw std::bad_alloc();
+	}
+
+	friend bool operator==(const String& a, const String& b) noexcept { return strsafe_compare(&a.str_, &b.str_); }
+	friend bool operator!=(const String& a, const String& b) noexcept { return !(a == b); }
+	friend bool operator==(const String& a, std::string_view b) noexcept { return a.view() == b; }
+	friend bool operator!=(const String& a, std::string_view b) noexcept { return a.view() != b; }
+	friend bool operator==(const String& a, const char* b) noexcept { return a.view() == b; }
+	friend bool operator!=(const String& a, const char* b) noexcept { return a.view() != b; }
+
+private:
+	bool aliases(std::string_view text) const noexcept {
+		std::less<const char*> before;
+		const char* bytes = strsafe_cstr(&str_);
+		return !text.empty() && !before(text.data(), bytes) && before(text.data(), bytes + strsafe_capacity(&str_));
+	}
+
+	StrSafe str_;
+};
+
+/**
+ * @class Array
+ * @brief Owning, movable handle of one `StrSafe_array`, iterated as `std::string_view`.
+ */
+class Array {
+public:
+	/** @brief Random-access iterator yielding each element as a `std::string_view`. */
+	class iterator {
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = std::string_view;
+
+		iterator() noexcept = default;
+		explicit iterator(const StrSafe* at) noexcept : at_(at) {}
+
+		std::string_view operator*() const noexcept { return to_string_view(*at_); }
+		std::string_view operator[](difference_type n) const noexcept { return to_string_view(at_[n]); }
+		iterator& operator++() noexcept { ++at_; return *this; }
+		iterator operator++(int) noexcept { iterator old = *this; ++at_; return old; }
+		iterator& operator--() noexcept { --at_; return *this; }
+		iterator operator--(int) noexcept { iterator old = *this; --at_; return old; }
+		iterator& operator+=(difference_type n) noexcept { at_ += n; return *this; }
+		iterator& operator-=(difference_type n) noexcept { at_ -= n; return *this; }
+		friend iterator operator+(iterator it, difference_type n) noexcept { return it += n; }
+		friend iterator operator+(difference_type n, iterator it) noexcept { return it += n; }
+		friend iterator operator-(iterator it, difference_type n) noexcept { return it -= n; }
+		friend difference_type operator-(iterator a, iterator b) noexcept { return a.at_ - b.at_; }
+		friend bool operator==(iterator a, iterator b) noexcept { return a.at_ == b.at_; }
+		friend bool operator!=(iterator a, iterator b) noexcept { return a.at_ != b.at_; }
+		friend bool operator<(iterator a, iterator b) noexcept { return a.at_ < b.at_; }
+		friend bool operator>(iterator a, iterator b) noexcept { return a.at_ > b.at_; }
+		friend bool operator<=(iterator a, iterator b) noexcept { return a.at_ <= b.at_; }
+		friend bool operator>=(iterator a, iterator b) noexcept { return a.at_ >= b.at_; }
+
+	private:
+		const StrSafe* at_ = nullptr;
+	};
+
+	Array() noexcept {
+		strsafe_array_init(&arr_);
+	}
+
+	Array(const Array&) = delete;
+	Array& operator=(const Array&) = delete;
+
+	Array(Array&& other) noexcept : arr_(other.arr_) {
+		strsafe_array_init(&other.arr_);
+	}
+
+	Array& operator=(Array&& other) noexcept {
+		if (this != &other) {
+			strsafe_array_free(&arr_);
+			arr_ = other.arr_;
+			strsafe_array_init(&other.arr_);
+		}
+		return *this;
+	}
+
+	~Array() {
+		strsafe_array_free(&arr_);
+	}
+
+	/**
+	 * @brief Takes ownership of an array built by C code, such as the result of `cstr_split`.
+	 * @param src Array to take over; it is left empty.
+	 */
+	static Array adopt(StrSafe_array* src) noexcept {
+		Array result;
+		result.arr_ = *src;
+		strsafe_array_init(src);
+		return result;
+	}
+
+	/**
+	 * @brief Gives up ownership of the underlying array and leaves this one empty.
+	 * @return The array; free it with `strsafe_array_free`.
+	 */
+	StrSafe_array release() noexcept {
+		StrSafe_array result = arr_;
+		strsafe_array_init(&arr_);
+		return result;
+	}
+
+	StrSafe_array* get() noexcept { return &arr_; }
+	const StrSafe_array* get() const noexcept { return &arr_; }
+
+	std::size_t size() const noexcept { return static_cast<std::size_t>(arr_.array_size); }
+	bool empty() const noexcept { return arr_.array_size == 0; }
+	iterator begin() const noexcept { return iterator(arr_.arr); }
+	iterator end() const noexcept { return iterator(arr_.arr + arr_.array_size); }
+	std::string_view operator[](std::size_t i) const noexcept { return to_string_view(arr_.arr[i]); }
+
+	/** @brief Appends a copy of `text`. */
+	void push_back(std::string_view text) {
+		if (!strsafe_array_push(&arr_, text.data(), text.size())) throw std::bad_alloc();
+	}
+
+private:
+	StrSafe_array arr_;
+};
+
+/**
+ * @brief Splits `src` on `delim` into an array of copies.
+ *
+ * An empty delimiter yields a single copy of `src`, as in `cstr_split_n`.
+ */
+inline Array split(const String& src, std::string_view delim) {
+	StrSafe_array parts = cstr_split_n(src.get(), delim.data(), delim.size());
+	if (!parts.arr) throw std::bad_alloc();
+	return Array::adopt(&parts);
+}
+
+} // namespace strsafe
+
+#endif // SAFE_STR_HPP
@@ -0,0 +1,649 @@
+
+/**
+ * @file StrSafe_ascii.h
+ * @brief ASCII case folding, whitespace stripping and byte-class scans.
+ *
+ * Everything here works on explicit lengths, never on null terminators, and only treats
+ * the ASCII letters `A`-`Z`/`a`-`z` as having case; other bytes, UTF-8 included, pass
+ * through unchanged.
+ *
+ * `strsafe_to_lower`/`strsafe_to_upper` convert in place, `strsafe_strip` removes leading
+ * and trailing whitespace in place (unlike `strsafe_trim`, which only gives back capacity),
+ * and the `_icase` functions compare and search ignoring case. A `StrSafe_byteset` prepares
+ * a set of bytes once for `strsafe_find_first_of` and `strsafe_find_first_not_of`.
+ *
+ * The kernels follow the search kernels of `StrSafe.h`: AVX2 when the CPU has it, SSE2 or
+ * NEON otherwise, 16 or 32 bytes per step, with scalar code for the tail. Byte sets are
+ * classified with two nibble lookups on AVX2 and AArch64; SSE2 compares sets of up to
+ * `STRSAFE_BYTESET_SMALL` bytes directly and larger ones go through the scalar bitmap.
+ *
+ */
+
+#ifndef SAFE_STR_ASCII_H
+#define SAFE_STR_ASCII_H
+
+#include "StrSafe.h"
+
+#if defined(STRSAFE_HAVE_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#define STRSAFE_HAVE_NEON_TBL 1
+#endif
+
+/** @brief Largest byte set that SSE2 and 32-bit NEON match by direct comparison. */
+#define STRSAFE_BYTESET_SMALL 4
+
+/**
+ * @struct StrSafe_byteset
+ * @brief A set of bytes prepared for membership scans.
+ */
+typedef struct {
+	uint8_t bits[32];                        /**< Bitmap: byte `c` is a member if bit `c & 7` of `bits[c >> 3]` is set. */
+	uint8_t nibbles[2][16];                  /**< For high nibbles 0-7 and 8-15, bit `hi & 7` of entry `lo` marks byte `hi << 4 | lo`. */
+	unsigned char small[STRSAFE_BYTESET_SMALL]; /**< The members, when there are at most `STRSAFE_BYTESET_SMALL`. */
+	size_t count;                            /**< Number of distinct members. */
+} StrSafe_byteset;
+
+/**
+ * @brief Prepares a byte set from `len` bytes of `bytes`; duplicates are ignored.
+ * @param set Set to initialize.
+ * @param bytes Member bytes.
+ * @param len Number of bytes in `bytes`.
+ */
+static inline void strsafe_byteset_init(StrSafe_byteset* set, const char* bytes, size_t len) {
+	memset(set, 0, sizeof(*set));
+	for (size_t i = 0; i < len; ++i) {
+		unsigned char c = (unsigned char)bytes[i];
+		if (set->bits[c >> 3] & (1u << (c & 7))) continue;
+		set->bits[c >> 3] |= (uint8_t)(1u << (c & 7));
+		set->nibbles[c >> 7][c & 15] |= (uint8_t)(1u << ((c >> 4) & 7));
+		if (set->count < STRSAFE_BYTESET_SMALL) set->small[set->count] = c;
+		set->count++;
+	}
+}
+
+/**
+ * @brief Prepares a byte set from the bytes of a C-string.
+ * @param set Set to initialize.
+ * @param bytes Null-terminated member bytes.
+ */
+static inline void cstr_byteset_init(StrSafe_byteset* set, const char* bytes) {
+	strsafe_byteset_init(set, bytes, strlen(bytes));
+}
+
+/**
+ * @brief Tells whether a byte is in a set.
+ * @param set The set.
+ * @param c The byte.
+ * @return `true` if `c` is a member.
+ */
+static inline bool strsafe_byteset_has(const StrSafe_byteset* set, unsigned char c) {
+	return (set->bits[c >> 3] >> (c & 7)) & 1;
+}
+
+/**
+ * @brief Maps an ASCII uppercase letter to lowercase and leaves other bytes alone.
+ * @param c The byte.
+ * @return The folded byte.
+ */
+static inline unsigned char strsafe_ascii_lower(unsigned char c) {
+	return (unsigned char)(c + (((unsigned char)(c - 'A') < 26) << 5));
+}
+
+#ifdef STRSAFE_HAVE_SSE2
+/**
+ * @brief Flips the case bit of the bytes in `[lo, lo + 26)`.
+ * @param x Block of 16 bytes.
+ * @param bias `0x80 - lo` in every lane, moving the range to the bottom of the signed range.
+ * @return The converted block.
+ */
+static inline __m128i strsafe_ascii_flip_sse2(__m128i x, __m128i bias) {
+	__m128i in_range = _mm_cmplt_epi8(_mm_add_epi8(x, bias), _mm_set1_epi8((char)(-128 + 26)));
+	return _mm_xor_si128(x, _mm_and_si128(in_range, _mm_set1_epi8(0x20)));
+}
+#endif
+
+#ifdef STRSAFE_HAVE_AVX2
+/** @brief AVX2 version of `strsafe_ascii_flip_sse2`. */
+STRSAFE_AVX2_TARGET
+static inline __m256i strsafe_ascii_flip_avx2(__m256i x, __m256i bias) {
+	__m256i in_range = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(-128 + 26)), _mm256_add_epi8(x, bias));
+	return _mm256_xor_si256(x, _mm256_and_si256(in_range, _mm256_set1_epi8(0x20)));
+}
+
+/** @brief AVX2 loop of `strsafe_ascii_flip_n`; returns the number of bytes done. */
+STRSAFE_AVX2_TARGET
+static inline size_t strsafe_ascii_flip_n_avx2(char* bytes, size_t len, unsigned char lo) {
+	const __m256i bias = _mm256_set1_epi8((char)(0x80 - lo));
+	size_t i = 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i x = _mm256_loadu_si256((const __m256i*)(bytes + i));
+		_mm256_storeu_si256((__m256i*)(bytes + i), strsafe_ascii_flip_avx2(x, bias));
+	}
+	return i;
+}
+#endif
+
+#ifdef STRSAFE_HAVE_NEON
+/** @brief NEON version of `strsafe_ascii_flip_sse2`; `lo` is the first byte of the range in every lane. */
+static inline uint8x16_t strsafe_ascii_flip_neon(uint8x16_t x, uint8x16_t lo) {
+	uint8x16_t in_range = vcltq_u8(vsubq_u8(x, lo), vdupq_n_u8(26));
+	return veorq_u8(x, vandq_u8(in_range, vdupq_n_u8(0x20)));
+}
+#endif
+
+/**
+ * @brief Flips the case of every byte in `[lo, lo + 26)`: `'A'` lowers, `'a'` raises.
+ * @param bytes Bytes to convert in place.
+ * @param len Number of bytes.
+ * @param lo First letter of the range to convert.
+ */
+static inline void strsafe_ascii_flip_n(char* bytes, size_t len, unsigned char lo) {
+	size_t i = 0;
+#if defined(STRSAFE_HAVE_AVX2)
+	if (len >= 32 && strsafe_cpu_has_avx2()) i = strsafe_ascii_flip_n_avx2(bytes, len, lo);
+#endif
+#if defined(STRSAFE_HAVE_SSE2)
+	const __m128i bias = _mm_set1_epi8((char)(0x80 - lo));
+	for (; i + 16 <= len; i += 16) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(bytes + i));
+		_mm_storeu_si128((__m128i*)(bytes + i), strsafe_ascii_flip_sse2(x, bias));
+	}
+#elif defined(STRSAFE_HAVE_NEON)
+	const uint8x16_t first = vdupq_n_u8(lo);
+	for (; i + 16 <= len; i += 16) {
+		uint8x16_t x = vld1q_u8((const uint8_t*)(bytes + i));
+		vst1q_u8((uint8_t*)(bytes + i), strsafe_ascii_flip_neon(x, first));
+	}
+#endif
+	for (; i < len; ++i) {
+		if ((unsigned char)(bytes[i] - lo) < 26) bytes[i] ^= 0x20;
+	}
+}
+
+/**
+ * @brief Converts ASCII letters to lowercase in a buffer.
+ * @param bytes Bytes to convert in place.
+ * @param len Number of bytes.
+ */
+static inline void strsafe_to_lower_n(char* bytes, size_t len) {
+	strsafe_ascii_flip_n(bytes, len, 'A');
+}
+
+/**
+ * @brief Converts ASCII letters to uppercase in a buffer.
+ * @param bytes Bytes to convert in place.
+ * @param len Number of bytes.
+ */
+static inline void strsafe_to_upper_n(char* bytes, size_t len) {
+	strsafe_ascii_flip_n(bytes, len, 'a');
+}
+
+/**
+ * @brief Converts the ASCII letters of a string to lowercase in place.
+ * @param dst The string to convert.
+ * @return `true` if successful, `false` if a shared buffer could not be copied.
+ */
+static inline bool strsafe_to_lower(StrSafe* dst) {
+	if (!strsafe_unshare(dst)) return false;
+	strsafe_to_lower_n(strsafe_data(dst), strsafe_length(dst));
+	return true;
+}
+
+/**
+ * @brief Converts the ASCII letters of a string to uppercase in place.
+ * @param dst The string to convert.
+ * @return `true` if successful, `false` if a shared buffer could not be copied.
+ */
+static inline bool strsafe_to_upper(StrSafe* dst) {
+	if (!strsafe_unshare(dst)) return false;
+	strsafe_to_upper_n(strsafe_data(dst), strsafe_length(dst));
+	return true;
+}
+
+#ifdef STRSAFE_HAVE_AVX2
+/** @brief AVX2 loop of `strsafe_ascii_equal_icase_n`; returns the bytes known equal, stopping early on a difference. */
+STRSAFE_AVX2_TARGET
+static inline size_t strsafe_ascii_equal_icase_n_avx2(const char* a, const char* b, size_t len) {
+	const __m256i bias = _mm256_set1_epi8((char)(0x80 - 'A'));
+	size_t i = 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i x = strsafe_ascii_flip_avx2(_mm256_loadu_si256((const __m256i*)(a + i)), bias);
+		__m256i y = strsafe_ascii_flip_avx2(_mm256_loadu_si256((const __m256i*)(b + i)), bias);
+		if ((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)) != 0xFFFFFFFFu) return i;
+	}
+	return i;
+}
+#endif
+
+/**
+ * @brief Compares two buffers of the same length ignoring ASCII case.
+ * @param a First buffer.
+ * @param b Second buffer.
+ * @param len Number of bytes to compare.
+ * @return `true` if equal ignoring case.
+ */
+static inline bool strsafe_ascii_equal_icase_n(const char* a, const char* b, size_t len) {
+	size_t i = 0;
+#if defined(STRSAFE_HAVE_AVX2)
+	if (len >= 32 && strsafe_cpu_has_avx2()) i = strsafe_ascii_equal_icase_n_avx2(a, b, len);
+#endif
+#if defined(STRSAFE_HAVE_SSE2)
+	const __m128i bias = _mm_set1_epi8((char)(0x80 - 'A'));
+	for (; i + 16 <= len; i += 16) {
+		__m128i x = strsafe_ascii_flip_sse2(_mm_loadu_si128((const __m128i*)(a + i)), bias);
+		__m128i y = strsafe_ascii_flip_sse2(_mm_loadu_si128((const __m128i*)(b + i)), bias);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) return false;
+	}
+#elif defined(STRSAFE_HAVE_NEON)
+	const uint8x16_t upper = vdupq_n_u8('A');
+	for (; i + 16 <= len; i += 16) {
+		uint8x16_t x = strsafe_ascii_flip_neon(vld1q_u8((const uint8_t*)(a + i)), upper);
+		uint8x16_t y = strsafe_ascii_flip_neon(vld1q_u8((const uint8_t*)(b + i)), upper);
+		uint8x16_t eq = vceqq_u8(x, y);
+		if (vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0) != UINT64_MAX) return false;
+	}
+#endif
+	for (; i < len; ++i) {
+		if (strsafe_ascii_lower((unsigned char)a[i]) != strsafe_ascii_lower((unsigned char)b[i])) return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Compares two views for equality ignoring ASCII case.
+ * @param a First view.
+ * @param b Second view.
+ * @return `true` if equal ignoring case, `false` otherwise.
+ */
+static inline bool strsafe_view_compare_icase(StrSafe_view a, StrSafe_view b) {
+	return a.len == b.len && strsafe_ascii_equal_icase_n(a.ptr, b.ptr, a.len);
+}
+
+/**
+ * @brief Compares two `StrSafe` strings for equality ignoring ASCII case.
+ * @param a First string.
+ * @param b Second string.
+ * @return `true` if equal ignoring case, `false` otherwise.
+ */
+static inline bool strsafe_compare_icase(const StrSafe* a, const StrSafe* b) {
+	return strsafe_view_compare_icase(strsafe_view_of(a), strsafe_view_of(b));
+}
+
+/**
+ * @brief Compares a `StrSafe` string with a C-string ignoring ASCII case.
+ * @param a The `StrSafe` string.
+ * @param b The C-string.
+ * @return `true` if equal ignoring case, `false` otherwise.
+ */
+static inline bool cstr_compare_icase(const StrSafe* a, const char* b) {
+	return strsafe_view_compare_icase(strsafe_view_of(a), strsafe_view_from_cstr(b));
+}
+
+/**
+ * @brief Portable case-insensitive search: folds the first byte and verifies candidates.
+ * @param haystack Bytes to search.
+ * @param haystack_len Number of bytes in `haystack`.
+ * @param needle Bytes to find.
+ * @param needle_len Number of bytes in `needle`; must not be 0.
+ * @return Pointer to the first match, or `NULL` if not found.
+ */
+static inline const char* strsafe_memmem_icase_scalar(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+	if (needle_len > haystack_len) return NULL;
+	unsigned char first = strsafe_ascii_lower((unsigned char)needle[0]);
+	for (size_t i = 0; i + needle_len <= haystack_len; ++i) {
+		if (strsafe_ascii_lower((unsigned char)haystack[i]) == first
+			&& strsafe_ascii_equal_icase_n(haystack + i + 1, needle + 1, needle_len - 1)) {
+			return haystack + i;
+		}
+	}
+	return NULL;
+}
+
+#ifdef STRSAFE_HAVE_AVX2
+/**
+ * @brief AVX2 case-insensitive kernel: filters 32 positions at a time on the folded first and last byte.
+ * @return Pointer to the first match, or `NULL` if not found.
+ */
+STRSAFE_AVX2_TARGET
+static inline const char* strsafe_memmem_icase_avx2(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+	const __m256i bias = _mm256_set1_epi8((char)(0x80 - 'A'));
+	const __m256i first = _mm256_set1_epi8((char)strsafe_ascii_lower((unsigned char)needle[0]));
+	const __m256i last = _mm256_set1_epi8((char)strsafe_ascii_lower((unsigned char)needle[needle_len - 1]));
+	size_t i = 0;
+	for (; i + needle_len + 31 <= haystack_len; i += 32) {
+		__m256i block_first = strsafe_ascii_flip_avx2(_mm256_loadu_si256((const __m256i*)(haystack + i)), bias);
+		__m256i block_last = strsafe_ascii_flip_avx2(_mm256_loadu_si256((const __m256i*)(haystack + i + needle_len - 1)), bias);
+		__m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last));
+		uint64_t mask = (uint32_t)_mm256_movemask_epi8(eq);
+		while (mask) {
+			size_t pos = i + strsafe_ctz64(mask);
+			if (needle_len <= 2 || strsafe_ascii_equal_icase_n(haystack + pos + 1, needle + 1, needle_len - 2)) return haystack + pos;
+			mask &= mask - 1;
+		}
+	}
+	return strsafe_memmem_icase_scalar(haystack + i, haystack_len - i, needle, needle_len);
+}
+#endif
+
+/**
+ * @brief Finds `needle` in `haystack` ignoring ASCII case, using lengths rather than terminators.
+ *
+ * The SIMD kernels fold each block and filter candidates on the needle's first and last
+ * byte, as `strsafe_memmem` does.
+ *
+ * @param haystack Bytes to search.
+ * @param haystack_len Number of bytes in `haystack`.
+ * @param needle Bytes to find.
+ * @param needle_len Number of bytes in `needle`.
+ * @return Pointer to the first match, or `NULL` if not found. An empty needle matches at `haystack`.
+ */
+static inline const char* strsafe_memmem_icase(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+	if (needle_len == 0) return haystack;
+	if (needle_len > haystack_len) return NULL;
+	size_t i = 0;
+#if defined(STRSAFE_HAVE_AVX2)
+	if (haystack_len >= needle_len + 31 && strsafe_cpu_has_avx2()) {
+		return strsafe_memmem_icase_avx2(haystack, haystack_len, needle, needle_len);
+	}
+#endif
+#if defined(STRSAFE_HAVE_SSE2)
+	const __m128i bias = _mm_set1_epi8((char)(0x80 - 'A'));
+	const __m128i first = _mm_set1_epi8((char)strsafe_ascii_lower((unsigned char)needle[0]));
+	const __m128i last = _mm_set1_epi8((char)strsafe_ascii_lower((unsigned char)needle[needle_len - 1]));
+	for (; i + needle_len + 15 <= haystack_len; i += 16) {
+		__m128i block_first = strsafe_ascii_flip_sse2(_mm_loadu_si128((const __m128i*)(haystack + i)), bias);
+		__m128i block_last = strsafe_ascii_flip_sse2(_mm_loadu_si128((const __m128i*)(haystack + i + needle_len - 1)), bias);
+		__m128i eq = _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last));
+		uint64_t mask = (unsigned)_mm_movemask_epi8(eq);
+		while (mask) {
+			size_t pos = i + strsafe_ctz64(mask);
+			if (needle_len <= 2 || strsafe_ascii_equal_icase_n(haystack + pos + 1, needle + 1, needle_len - 2)) return haystack + pos;
+			mask &= mask - 1;
+		}
+	}
+#elif defined(STRSAFE_HAVE_NEON)
+	const uint8x16_t upper = vdupq_n_u8('A');
+	const uint8x16_t first = vdupq_n_u8(strsafe_ascii_lower((unsigned char)needle[0]));
+	const uint8x16_t last = vdupq_n_u8(strsafe_ascii_lower((unsigned char)needle[needle_len - 1]));
+	for (; i + needle_len + 15 <= haystack_len; i += 16) {
+		uint8x16_t block_first = strsafe_ascii_flip_neon(vld1q_u8((const uint8_t*)(haystack + i)), upper);
+		uint8x16_t block_last = strsafe_ascii_flip_neon(vld1q_u8((const uint8_t*)(haystack + i + needle_len - 1)), upper);
+		uint8x16_t eq = vandq_u8(vceqq_u8(first, block_first), vceqq_u8(last, block_last));
+		uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+		while (mask) {
+			unsigned bit = strsafe_ctz64(mask);
+			size_t pos = i + (bit >> 2);
+			if (needle_len <= 2 || strsafe_ascii_equal_icase_n(haystack + pos + 1, needle + 1, needle_len - 2)) return haystack + pos;
+			mask &= ~((uint64_t)0xF << (bit & ~3u));
+		}
+	}
+#endif
+	return strsafe_memmem_icase_scalar(haystack + i, haystack_len - i, needle, needle_len);
+}
+
+/**
+ * @brief Finds the first occurrence of `needle` in `haystack` ignoring ASCII case.
+ * @param haystack The view to search.
+ * @param needle The view to find.
+ * @return Position of match or -1 if not found.
+ */
+static inline ssize_t strsafe_view_find_icase(StrSafe_view haystack, StrSafe_view needle) {
+	const char* found = strsafe_memmem_icase(haystack.ptr, haystack.len, needle.ptr, needle.len);
+	return found ? (ssize_t)(found - haystack.ptr) : -1;
+}
+
+/**
+ * @brief Finds the first occurrence of a `StrSafe` in another ignoring ASCII case.
+ * @param haystack The string to search.
+ * @param needle The string to find.
+ * @return Position of match or -1 if not found.
+ */
+static inline ssize_t strsafe_find_icase(const StrSafe* haystack, const StrSafe* needle) {
+	return strsafe_view_find_icase(strsafe_view_of(haystack), strsafe_view_of(needle));
+}
+
+/**
+ * @brief Finds the first occurrence of a C-string in a `StrSafe` ignoring ASCII case.
+ * @param haystack The string to search.
+ * @param needle The C-string to find.
+ * @return Position of match or -1 if not found.
+ */
+static inline ssize_t cstr_find_icase(const StrSafe* haystack, const char* needle) {
+	return strsafe_view_find_icase(strsafe_view_of(haystack), strsafe_view_from_cstr(needle));
+}
+
+/**
+ * @brief Portable byte-set scan over the bitmap.
+ * @param bytes Bytes to scan.
+ * @param len Number of bytes.
+ * @param set The set.
+ * @param member `true` to stop at the first member, `false` at the first non-member.
+ * @return Index of the first such byte, or `len` if there is none.
+ */
+static inline size_t strsafe_byteset_scan_scalar(const char* bytes, size_t len, const StrSafe_byteset* set, bool member) {
+	for (size_t i = 0; i < len; ++i) {
+		if (strsafe_byteset_has(set, (unsigned char)bytes[i]) == member) return i;
+	}
+	return len;
+}
+
+#ifdef STRSAFE_HAVE_AVX2
+/**
+ * @brief AVX2 byte-set scan: classifies 32 bytes at a time with two nibble lookups.
+ *
+ * The low nibble picks a row of `nibbles` (the table for high nibbles 8-15 when the top
+ * bit is set), the high nibble picks the bit within it.
+ *
+ * @return Index of the first byte whose membership equals `member`, or `len` if there is none.
+ */
+STRSAFE_AVX2_TARGET
+static inline size_t strsafe_byteset_scan_avx2(const char* bytes, size_t len, const StrSafe_byteset* set, bool member) {
+	const __m256i rows_low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set->nibbles[0]));
+	const __m256i rows_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set->nibbles[1]));
+	const __m256i bit_of = _mm256_setr_epi8(
+		1, 2, 4, 8, 16, 32, 64, (char)128, 1, 2, 4, 8, 16, 32, 64, (char)128,
+		1, 2, 4, 8, 16, 32, 64, (char)128, 1, 2, 4, 8, 16, 32, 64, (char)128);
+	const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+	uint32_t flip = member ? 0 : 0xFFFFFFFFu;
+	size_t i = 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i x = _mm256_loadu_si256((const __m256i*)(bytes + i));
+		__m256i lo = _mm256_and_si256(x, low_nibble);
+		__m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_nibble);
+		__m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(rows_low, lo), _mm256_shuffle_epi8(rows_high, lo), x);
+		__m256i bit = _mm256_shuffle_epi8(bit_of, hi);
+		__m256i hit = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit);
+		uint32_t mask = (uint32_t)_mm256_movemask_epi8(hit) ^ flip;
+		if (mask) return i + strsafe_ctz64(mask);
+	}
+	return i + strsafe_byteset_scan_scalar(bytes + i, len - i, set, member);
+}
+#endif
+
+/**
+ * @brief Finds the first byte that is (or is not) in a set.
+ * @param bytes Bytes to scan.
+ * @param len Number of bytes.
+ * @param set The set.
+ * @param member `true` to stop at the first member, `false` at the first non-member.
+ * @return Index of the first such byte, or `len` if there is none.
+ */
+static inline size_t strsafe_byteset_scan(const char* bytes, size_t len, const StrSafe_byteset* set, bool member) {
+	size_t i = 0;
+#if defined(STRSAFE_HAVE_AVX2)
+	if (len >= 32 && strsafe_cpu_has_avx2()) return strsafe_byteset_scan_avx2(bytes, len, set, member);
+#endif
+#if defined(STRSAFE_HAVE_SSE2)
+	if (set->count <= STRSAFE_BYTESET_SMALL) {
+		__m128i members[STRSAFE_BYTESET_SMALL];
+		for (size_t k = 0; k < set->count; ++k) members[k] = _mm_set1_epi8((char)set->small[k]);
+		unsigned flip = member ? 0 : 0xFFFFu;
+		for (; i + 16 <= len; i += 16) {
+			__m128i x = _mm_loadu_si128((const __m128i*)(bytes + i));
+			__m128i hit = _mm_setzero_si128();
+			for (size_t k = 0; k < set->count; ++k) hit = _mm_or_si128(hit, _mm_cmpeq_epi8(x, members[k]));
+			unsigned mask = (unsigned)_mm_movemask_epi8(hit) ^ flip;
+			if (mask) return i + strsafe_ctz64(mask);
+		}
+	}
+#elif defined(STRSAFE_HAVE_NEON_TBL)
+	const uint8x16_t rows_low = vld1q_u8(set->nibbles[0]);
+	const uint8x16_t rows_high = vld1q_u8(set->nibbles[1]);
+	static const uint8_t bit_table[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	const uint8x16_t bit_of = vld1q_u8(bit_table);
+	const uint8x16_t low_nibble = vdupq_n_u8(0x0F);
+	uint64_t flip = member ? 0 : UINT64_MAX;
+	for (; i + 16 <= len; i += 16) {
+		uint8x16_t x = vld1q_u8((const uint8_t*)(bytes + i));
+		uint8x16_t lo = vandq_u8(x, low_nibble);
+		uint8x16_t row = vbslq_u8(vcgeq_u8(x, vdupq_n_u8(0x80)), vqtbl1q_u8(rows_high, lo), vqtbl1q_u8(rows_low, lo));
+		uint8x16_t hit = vtstq_u8(row, vqtbl1q_u8(bit_of, vshrq_n_u8(x, 4)));
+		uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0) ^ flip;
+		if (mask) return i + (strsafe_ctz64(mask) >> 2);
+	}
+#elif defined(STRSAFE_HAVE_NEON)
+	if (set->count <= STRSAFE_BYTESET_SMALL) {
+		uint64_t flip = member ? 0 : UINT64_MAX;
+		for (; i + 16 <= len; i += 16) {
+			uint8x16_t x = vld1q_u8((const uint8_t*)(bytes + i));
+			uint8x16_t hit = vdupq_n_u8(0);
+			for (size_t k = 0; k < set->count; ++k) hit = vorrq_u8(hit, vceqq_u8(x, vdupq_n_u8(set->small[k])));
+			uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0) ^ flip;
+			if (mask) return i + (strsafe_ctz64(mask) >> 2);
+		}
+	}
+#endif
+	return i + strsafe_byteset_scan_scalar(bytes + i, len - i, set, member);
+}
+
+/**
+ * @brief Finds the first byte of a view that is in a set.
+ * @param view The view to scan.
+ * @param set Prepared set.
+ * @return Position of the byte or -1 if there is none.
+ */
+static inline ssize_t strsafe_view_find_first_of(StrSafe_view view, const StrSafe_byteset* set) {
+	size_t pos = strsafe_byteset_scan(view.ptr, view.len, set, true);
+	return pos < view.len ? (ssize_t)pos : -1;
+}
+
+/**
+ * @brief Finds the first byte of a view that is not in a set.
+ * @param view The view to scan.
+ * @param set Prepared set.
+ * @return Position of the byte or -1 if there is none.
+ */
+static inline ssize_t strsafe_view_find_first_not_of(StrSafe_view view, const StrSafe_byteset* set) {
+	size_t pos = strsafe_byteset_scan(view.ptr, view.len, set, false);
+	return pos < view.len ? (ssize_t)pos : -1;
+}
+
+/**
+ * @brief Finds the first byte of a string that is in a set.
+ * @param src The string to scan.
+ * @param set Prepared set.
+ * @return Position of the byte or -1 if there is none.
+ */
+static inline ssize_t strsafe_find_first_of(const StrSafe* src, const StrSafe_byteset* set) {
+	return strsafe_view_find_first_of(strsafe_view_of(src), set);
+}
+
+/**
+ * @brief Finds the first byte of a string that is not in a set.
+ * @param src The string to scan.
+ * @param set Prepared set.
+ * @return Position of the byte or -1 if there is none.
+ */
+static inline ssize_t strsafe_find_first_not_of(const StrSafe* src, const StrSafe_byteset* set) {
+	return strsafe_view_find_first_not_of(strsafe_view_of(src), set);
+}
+
+/**
+ * @brief Finds the first byte of a string that is one of the bytes of a C-string.
+ *
+ * Prepares the set on every call; keep a `StrSafe_byteset` for repeated scans.
+ *
+ * @param src The string to scan.
+ * @param chars The member bytes.
+ * @return Position of the byte or -1 if there is none.
+ */
+static inline ssize_t cstr_find_first_of(const StrSafe* src, const char* chars) {
+	StrSafe_byteset set;
+	cstr_byteset_init(&set, chars);
+	return strsafe_find_first_of(src, &set);
+}
+
+/**
+ * @brief Finds the first byte of a string that is none of the bytes of a C-string.
+ * @param src The string to scan.
+ * @param chars The bytes to skip.
+ * @return Position of the byte or -1 if there is none.
+ */
+static inline ssize_t cstr_find_first_not_of(const StrSafe* src, const char* chars) {
+	StrSafe_byteset set;
+	cstr_byteset_init(&set, chars);
+	return strsafe_find_first_not_of(src, &set);
+}
+
+/**
+ * @brief Removes the leading and trailing bytes of a view that are in a set.
+ * @param view The view to strip.
+ * @param set Bytes to remove.
+ * @return The stripped view of the same bytes.
+ */
+static inline StrSafe_view strsafe_view_strip_set(StrSafe_view view, const StrSafe_byteset* set) {
+	size_t begin = strsafe_byteset_scan(view.ptr, view.len, set, false);
+	size_t end = view.len;
+	while (end > begin && strsafe_byteset_has(set, (unsigned char)view.ptr[end - 1])) --end;
+	return strsafe_view_make(view.ptr + begin, end - begin);
+}
+
+/**
+ * @brief Tells whether a byte is ASCII whitespace: space, `\t`, `\n`, `\v`, `\f` or `\r`.
+ * @param c The byte.
+ * @return `true` for whitespace.
+ */
+static inline bool strsafe_ascii_is_space(unsigned char c) {
+	return c == ' ' || (unsigned char)(c - '\t') < 5;
+}
+
+/**
+ * @brief Removes leading and trailing ASCII whitespace from a view.
+ * @param view The view to strip.
+ * @return The stripped view of the same bytes.
+ */
+static inline StrSafe_view strsafe_view_strip(StrSafe_view view) {
+	size_t begin = 0;
+	size_t end = view.len;
+	while (begin < end && strsafe_ascii_is_space((unsigned char)view.ptr[begin])) ++begin;
+	while (end > begin && strsafe_ascii_is_space((unsigned char)view.ptr[end - 1])) --end;
+	return strsafe_view_make(view.ptr + begin, end - begin);
+}
+
+/**
+ * @brief Removes leading and trailing ASCII whitespace from a string in place.
+ *
+ * Not to be confused with `strsafe_trim`, which only releases unused capacity. The buffer
+ * is kept as after `strsafe_substr`.
+ *
+ * @param dst The string to strip.
+ * @return `true` if successful, `false` if a shared buffer could not be copied.
+ */
+static inline bool strsafe_strip(StrSafe* dst) {
+	StrSafe_view all = strsafe_view_of(dst);
+	StrSafe_view kept = strsafe_view_strip(all);
+	return strsafe_substr(dst, (size_t)(kept.ptr - all.ptr), kept.len) != NULL;
+}
+
+/**
+ * @brief Removes the leading and trailing bytes of a string that are in a set, in place.
+ * @param dst The string to strip.
+ * @param set Bytes to remove.
+ * @return `true` if successful, `false` if a shared buffer could not be copied.
+ */
+static inline bool strsafe_strip_set(StrSafe* dst, const StrSafe_byteset* set) {
+	StrSafe_view all = strsafe_view_of(dst);
+	StrSafe_view kept = strsafe_view_strip_set(all, set);
+	return strsafe_substr(dst, (size_t)(kept.ptr - all.ptr), kept.len) != NULL;
+}
+
+#endif // SAFE_STR_ASCII_H
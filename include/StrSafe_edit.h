@@ -0,0 +1,314 @@
+
+/**
+ * @file StrSafe_edit.h
+ * @brief Batches of positional edits applied to a string in one pass.
+ *
+ * A `StrSafe_edit_batch` collects edits as (offset, delete length, inserted bytes) against
+ * the original text; offsets never shift as earlier edits are added. Applying the batch
+ * sorts the edits and rebuilds the string in a single pass instead of moving the tail
+ * once per edit as repeated `strsafe_insert`/`strsafe_remove` calls would.
+ *
+ * Deleted ranges may not overlap. Inserts at the same offset keep the order they were
+ * added in, and come before the replacement bytes of an edit that deletes from there.
+ * When no prefix of the sorted edits makes the text longer (redaction with same-length
+ * or shorter replacements, plain removals) the string is rewritten in place without
+ * allocating; otherwise the result is built in one exact-size allocation.
+ *
+ */
+
+#ifndef SAFE_STR_EDIT_H
+#define SAFE_STR_EDIT_H
+
+#include "StrSafe.h"
+
+/**
+ * @struct StrSafe_edit
+ * @brief One edit of a batch.
+ */
+typedef struct {
+	size_t offset;        /**< Position in the original text. */
+	size_t delete_len;    /**< Bytes removed from `offset`. */
+	size_t insert_pos;    /**< Start of the inserted bytes in the batch buffer. */
+	size_t insert_len;    /**< Number of bytes inserted at `offset`. */
+	size_t seq;           /**< Order in which the edit was added. */
+} StrSafe_edit;
+
+/**
+ * @struct StrSafe_edit_batch
+ * @brief Edits waiting to be applied, with copies of their inserted bytes.
+ */
+typedef struct {
+	StrSafe_edit* edits;   /**< The edits, sorted on apply. */
+	size_t count;          /**< Number of edits. */
+	size_t cap;            /**< Allocated edits. */
+	char* bytes;           /**< Inserted bytes of all edits, back to back. */
+	size_t bytes_len;      /**< Bytes used in `bytes`. */
+	size_t bytes_cap;      /**< Allocated bytes. */
+	bool sorted;           /**< `edits` are known to be in apply order. */
+} StrSafe_edit_batch;
+
+/**
+ * @brief Initializes an empty batch.
+ * @param batch Batch to initialize.
+ */
+static inline void strsafe_edit_batch_init(StrSafe_edit_batch* batch) {
+	memset(batch, 0, sizeof(*batch));
+	batch->sorted = true;
+}
+
+/**
+ * @brief Frees the memory owned by a batch.
+ * @param batch Batch to free; it is left empty and may be reused.
+ */
+static inline void strsafe_edit_batch_free(StrSafe_edit_batch* batch) {
+	STRSAFE_FREE(batch->edits);
+	STRSAFE_FREE(batch->bytes);
+	strsafe_edit_batch_init(batch);
+}
+
+/**
+ * @brief Removes every edit but keeps the storage for the next batch.
+ * @param batch Batch to clear.
+ */
+static inline void strsafe_edit_batch_clear(StrSafe_edit_batch* batch) {
+	batch->count = 0;
+	batch->bytes_len = 0;
+	batch->sorted = true;
+}
+
+/**
+ * @brief Orders two edits by offset, inserts before deletes at the same offset, then by addition.
+ */
+static inline int strsafe_edit_compare(const void* a, const void* b) {
+	const StrSafe_edit* x = a;
+	const StrSafe_edit* y = b;
+	if (x->offset != y->offset) return x->offset < y->offset ? -1 : 1;
+	if ((x->delete_len == 0) != (y->delete_len == 0)) return x->delete_len == 0 ? -1 : 1;
+	return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+/**
+ * @brief Adds an edit that deletes `delete_len` bytes at `offset` and inserts `insert_len` bytes there.
+ *
+ * Offsets refer to the text the batch will be applied to, regardless of edits added
+ * before. The inserted bytes are copied.
+ *
+ * @param batch The batch.
+ * @param offset Position of the edit.
+ * @param delete_len Bytes to remove, 0 for a pure insert.
+ * @param insert Bytes to insert; may be `NULL` when `insert_len` is 0.
+ * @param insert_len Number of bytes in `insert`.
+ * @return `true` if added, `false` on allocation failure (the batch is unchanged).
+ */
+static inline bool strsafe_edit_batch_add(StrSafe_edit_batch* batch, size_t offset, size_t delete_len, const char* insert, size_t insert_len) {
+	if (batch->count == batch->cap) {
+		size_t new_cap = batch->cap ? batch->cap * 2 : 16;
+		StrSafe_edit* grown = STRSAFE_REALLOC(batch->edits, sizeof(StrSafe_edit) * new_cap);
+		if (!grown) return false;
+		batch->edits = grown;
+		batch->cap = new_cap;
+	}
+	if (insert_len > batch->bytes_cap - batch->bytes_len) {
+		if (insert_len > SIZE_MAX / 2 - batch->bytes_len) return false;
+		size_t new_cap = batch->bytes_cap ? batch->bytes_cap : 64;
+		while (new_cap - batch->bytes_len < insert_len) new_cap *= 2;
+		char* grown = STRSAFE_REALLOC(batch->bytes, new_cap);
+		if (!grown) return false;
+		batch->bytes = grown;
+		batch->bytes_cap = new_cap;
+	}
+
+	StrSafe_edit* edit = &batch->edits[batch->count];
+	edit->offset = offset;
+	edit->delete_len = delete_len;
+	edit->insert_pos = batch->bytes_len;
+	edit->insert_len = insert_len;
+	edit->seq = batch->count;
+	if (insert_len) memcpy(batch->bytes + batch->bytes_len, insert, insert_len);
+	batch->bytes_len += insert_len;
+	if (batch->count > 0 && strsafe_edit_compare(edit - 1, edit) > 0) batch->sorted = false;
+	batch->count++;
+	return true;
+}
+
+/**
+ * @brief Adds an insert of `len` bytes at `offset`.
+ * @param batch The batch.
+ * @param offset Position in the original text.
+ * @param insert Bytes to insert.
+ * @param len Number of bytes in `insert`.
+ * @return `true` if added, `false` on allocation failure.
+ */
+static inline bool strsafe_edit_batch_insert(StrSafe_edit_batch* batch, size_t offset, const char* insert, size_t len) {
+	return strsafe_edit_batch_add(batch, offset, 0, insert, len);
+}
+
+/**
+ * @brief Adds a removal of `len` bytes at `offset`.
+ * @param batch The batch.
+ * @param offset Position in the original text.
+ * @param len Number of bytes to remove.
+ * @return `true` if added, `false` on allocation failure.
+ */
+static inline bool strsafe_edit_batch_remove(StrSafe_edit_batch* batch, size_t offset, size_t len) {
+	return strsafe_edit_batch_add(batch, offset, len, NULL, 0);
+}
+
+/**
+ * @brief Adds a replacement of `len` bytes at `offset` by `insert_len` bytes of `insert`.
+ * @param batch The batch.
+ * @param offset Position in the original text.
+ * @param len Number of bytes replaced.
+ * @param insert Replacement bytes.
+ * @param insert_len Number of bytes in `insert`.
+ * @return `true` if added, `false` on allocation failure.
+ */
+static inline bool strsafe_edit_batch_replace(StrSafe_edit_batch* batch, size_t offset, size_t len, const char* insert, size_t insert_len) {
+	return strsafe_edit_batch_add(batch, offset, len, insert, insert_len);
+}
+
+/**
+ * @brief Sorts the edits and checks them against a text of `len` bytes.
+ *
+ * @param batch The batch.
+ * @param len Length of the text the batch is applied to.
+ * @param final_len Receives the length of the result.
+ * @param grows Receives whether some prefix of the edits makes the text longer, which
+ *              rules out rewriting it in place.
+ * @return `false` if an edit lies outside the text, deleted ranges overlap or the result
+ *         length overflows.
+ */
+static inline bool strsafe_edit_batch_prepare(StrSafe_edit_batch* batch, size_t len, size_t* final_len, bool* grows) {
+	if (!batch->sorted) {
+		qsort(batch->edits, batch->count, sizeof(StrSafe_edit), strsafe_edit_compare);
+		batch->sorted = true;
+	}
+
+	size_t cursor = 0;
+	size_t removed = 0;
+	size_t inserted = 0;
+	*grows = false;
+	for (size_t i = 0; i < batch->count; ++i) {
+		const StrSafe_edit* edit = &batch->edits[i];
+		if (edit->offset < cursor || edit->offset > len || edit->delete_len > len - edit->offset) return false;
+		cursor = edit->offset + edit->delete_len;
+		removed += edit->delete_len;
+		if (edit->insert_len > SIZE_MAX - len - inserted) return false;
+		inserted += edit->insert_len;
+		if (inserted > removed) *grows = true;
+	}
+	*final_len = len - removed + inserted;
+	return true;
+}
+
+/**
+ * @brief Writes the edited text of `src` to `out`, which must hold the whole result.
+ * @param batch A batch checked by `strsafe_edit_batch_prepare`.
+ * @param src The original text.
+ * @param len Number of bytes in `src`.
+ * @param out Destination; may be the buffer of `src` when the edits do not grow it.
+ * @return Pointer just past the last byte written.
+ */
+static inline char* strsafe_edit_batch_write(const StrSafe_edit_batch* batch, const char* src, size_t len, char* out) {
+	size_t copied = 0;
+	for (size_t i = 0; i < batch->count; ++i) {
+		const StrSafe_edit* edit = &batch->edits[i];
+		size_t keep = edit->offset - copied;
+		if (keep && out != src + copied) memmove(out, src + copied, keep);
+		out += keep;
+		if (edit->insert_len) memcpy(out, batch->bytes + edit->insert_pos, edit->insert_len);
+		out += edit->insert_len;
+		copied = edit->offset + edit->delete_len;
+	}
+	if (len > copied && out != src + copied) memmove(out, src + copied, len - copied);
+	return out + (len - copied);
+}
+
+/**
+ * @brief Builds the edited copy of `src` into `dst`, allocating from `allocator`.
+ *
+ * `src` is not modified, so this suits read-only input such as a mapped file.
+ *
+ * @param dst Destination string, replaced by the result; must not overlap `src`.
+ * @param src The original text.
+ * @param batch The edits; sorted by this call.
+ * @param allocator Allocator for `dst`, or `NULL` for the default heap.
+ * @return `true` if successful, `false` on invalid edits or allocation failure (`dst` is unchanged).
+ */
+static inline bool strsafe_edit_batch_build_ex(StrSafe* dst, StrSafe_view src, StrSafe_edit_batch* batch, const StrSafe_allocator* allocator) {
+	size_t final_len;
+	bool grows;
+	if (!strsafe_edit_batch_prepare(batch, src.len, &final_len, &grows)) return false;
+	if (final_len == SIZE_MAX || !strsafe_reserve_discard_ex(dst, final_len + 1, allocator)) return false;
+
+	char* data = strsafe_data(dst);
+	strsafe_edit_batch_write(batch, src.ptr, src.len, data);
+	data[final_len] = '\0';
+	strsafe_set_length(dst, final_len);
+	return true;
+}
+
+/**
+ * @brief Builds the edited copy of `src` into `dst`.
+ * @param dst Destination string, replaced by the result; must not overlap `src`.
+ * @param src The original text.
+ * @param batch The edits; sorted by this call.
+ * @return `true` if successful, `false` on invalid edits or allocation failure (`dst` is unchanged).
+ */
+static inline bool strsafe_edit_batch_build(StrSafe* dst, StrSafe_view src, StrSafe_edit_batch* batch) {
+	return strsafe_edit_batch_build_ex(dst, src, batch, NULL);
+}
+
+/**
+ * @brief Applies every edit of `batch` to `dst`, allocating from `allocator`.
+ *
+ * Edits that never make the text longer than it was are applied in place; otherwise the
+ * result is built in one new buffer that replaces the old one. The batch is kept and
+ * may be applied again or cleared.
+ *
+ * @param dst The string to edit.
+ * @param batch The edits; sorted by this call.
+ * @param allocator Allocator owning the buffer, or `NULL` for the default heap.
+ * @return `true` if successful, `false` on invalid edits or allocation failure (`dst` is unchanged).
+ */
+static inline bool strsafe_edit_batch_apply_ex(StrSafe* dst, StrSafe_edit_batch* batch, const StrSafe_allocator* allocator) {
+	size_t len = strsafe_length(dst);
+	size_t final_len;
+	bool grows;
+	if (!strsafe_edit_batch_prepare(batch, len, &final_len, &grows)) return false;
+	if (batch->count == 0) return true;
+
+	if (!grows) {
+		if (len == 0) return true;
+		if (!strsafe_unshare_ex(dst, allocator)) return false;
+		char* data = strsafe_data(dst);
+		strsafe_edit_batch_write(batch, data, len, data);
+		data[final_len] = '\0';
+		strsafe_set_length(dst, final_len);
+		if (final_len < len) strsafe_shrunk_ex(dst, allocator);
+		return true;
+	}
+
+	StrSafe result;
+	strsafe_init(&result);
+	if (!strsafe_reserve_ex(&result, final_len + 1, allocator)) return false;
+	char* out = strsafe_data(&result);
+	strsafe_edit_batch_write(batch, strsafe_cstr(dst), len, out);
+	out[final_len] = '\0';
+	strsafe_set_length(&result, final_len);
+	strsafe_free_ex(dst, allocator);
+	*dst = result;
+	return true;
+}
+
+/**
+ * @brief Applies every edit of `batch` to `dst` in one pass.
+ * @param dst The string to edit.
+ * @param batch The edits; sorted by this call.
+ * @return `true` if successful, `false` on invalid edits or allocation failure (`dst` is unchanged).
+ */
+static inline bool strsafe_edit_batch_apply(StrSafe* dst, StrSafe_edit_batch* batch) {
+	return strsafe_edit_batch_apply_ex(dst, batch, NULL);
+}
+
+#endif // SAFE_STR_EDIT_H
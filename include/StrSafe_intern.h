@@ -0,0 +1,334 @@
+
+/**
+ * @file StrSafe_intern.h
+ * @brief Thread-safe interning of strings into canonical, shared `StrSafe` handles.
+ *
+ * `strsafe_intern_n` maps a byte sequence to the one `StrSafe` a `StrSafe_intern_table`
+ * keeps for it, storing each distinct key once. Two handles from the same table are equal
+ * exactly when their pointers are, so comparing interned keys costs a pointer compare
+ * instead of a `memcmp`. Each entry caches its hash, read back with `strsafe_intern_hash`.
+ *
+ * The table is split into `STRSAFE_INTERN_SHARDS` shards picked by hash, each an open
+ * addressing table behind its own reader-writer lock, so lookups of existing keys from many
+ * threads only take shared locks and inserts contend just within one shard. Entries are
+ * carved from a per-shard `StrSafe_arena` and stay valid until `strsafe_intern_free`.
+ *
+ */
+
+#ifndef SAFE_STR_INTERN_H
+#define SAFE_STR_INTERN_H
+
+#include "StrSafe.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+typedef SRWLOCK strsafe_rwlock;
+#else
+#include <pthread.h>
+typedef pthread_rwlock_t strsafe_rwlock;
+#endif
+
+#ifndef STRSAFE_INTERN_SHARDS
+#define STRSAFE_INTERN_SHARDS 64   /**< Independent shards in a table; a power of two. */
+#endif
+
+/**
+ * @struct StrSafe_interned
+ * @brief One interned key: the canonical handle and its cached hash.
+ *
+ * The bytes follow the struct in the same arena block.
+ */
+typedef struct {
+	StrSafe str;     /**< Canonical handle returned to callers; never modified. */
+	uint64_t hash;   /**< Hash of the bytes. */
+} StrSafe_interned;
+
+/**
+ * @struct StrSafe_intern_shard
+ * @brief Part of a `StrSafe_intern_table` holding the keys whose hash selects it.
+ */
+typedef struct {
+	strsafe_rwlock lock;             /**< Shared for lookups, exclusive for inserts. */
+	StrSafe_interned** slots;        /**< Open addressing table; `NULL` marks an empty slot. */
+	size_t slot_count;               /**< Number of slots, a power of two or zero. */
+	size_t count;                    /**< Number of entries. */
+	StrSafe_arena arena;             /**< Storage of the entries. */
+} StrSafe_intern_shard;
+
+/**
+ * @struct StrSafe_intern_table
+ * @brief Concurrent set of interned strings.
+ *
+ * The shards embed arenas that point back at themselves, so an initialized table must
+ * not be moved.
+ */
+typedef struct {
+	StrSafe_intern_shard shards[STRSAFE_INTERN_SHARDS];   /**< Shards selected by the top bits of the hash. */
+} StrSafe_intern_table;
+
+/** @brief Creates a reader-writer lock; returns `false` on failure. */
+static inline bool strsafe_rwlock_init(strsafe_rwlock* lock) {
+#ifdef _WIN32
+	InitializeSRWLock(lock);
+	return true;
+#else
+	return pthread_rwlock_init(lock, NULL) == 0;
+#endif
+}
+
+/** @brief Destroys a lock created by `strsafe_rwlock_init`. */
+static inline void strsafe_rwlock_destroy(strsafe_rwlock* lock) {
+#ifdef _WIN32
+	(void)lock;
+#else
+	pthread_rwlock_destroy(lock);
+#endif
+}
+
+/** @brief Takes a lock in shared mode. */
+static inline void strsafe_rwlock_read(strsafe_rwlock* lock) {
+#ifdef _WIN32
+	AcquireSRWLockShared(lock);
+#else
+	pthread_rwlock_rdlock(lock);
+#endif
+}
+
+/** @brief Releases a lock held in shared mode. */
+static inline void strsafe_rwlock_read_unlock(strsafe_rwlock* lock) {
+#ifdef _WIN32
+	ReleaseSRWLockShared(lock);
+#else
+	pthread_rwlock_unlock(lock);
+#endif
+}
+
+/** @brief Takes a lock in exclusive mode. */
+static inline void strsafe_rwlock_write(strsafe_rwlock* lock) {
+#ifdef _WIN32
+	AcquireSRWLockExclusive(lock);
+#else
+	pthread_rwlock_wrlock(lock);
+#endif
+}
+
+/** @brief Releases a lock held in exclusive mode. */
+static inline void strsafe_rwlock_write_unlock(strsafe_rwlock* lock) {
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(lock);
+#else
+	pthread_rwlock_unlock(lock);
+#endif
+}
+
+/**
+ * @brief Initializes an empty intern table.
+ * @param table Table to initialize.
+ * @return `true` if successful, `false` if a lock could not be created.
+ */
+static inline bool strsafe_intern_init(StrSafe_intern_table* table) {
+	for (size_t i = 0; i < STRSAFE_INTERN_SHARDS; ++i) {
+		StrSafe_intern_shard* shard = &table->shards[i];
+		if (!strsafe_rwlock_init(&shard->lock)) {
+			while (i-- > 0) {
+				strsafe_rwlock_destroy(&table->shards[i].lock);
+			}
+			return false;
+		}
+		shard->slots = NULL;
+		shard->slot_count = 0;
+		shard->count = 0;
+		strsafe_arena_init(&shard->arena, 0);
+	}
+	return true;
+}
+
+/**
+ * @brief Frees an intern table; every handle it returned becomes invalid.
+ * @param table Table to free; no other thread may be using it.
+ */
+static inline void strsafe_intern_free(StrSafe_intern_table* table) {
+	for (size_t i = 0; i < STRSAFE_INTERN_SHARDS; ++i) {
+		StrSafe_intern_shard* shard = &table->shards[i];
+		STRSAFE_FREE(shard->slots);
+		shard->slots = NULL;
+		shard->slot_count = 0;
+		shard->count = 0;
+		strsafe_arena_destroy(&shard->arena);
+		strsafe_rwlock_destroy(&shard->lock);
+	}
+}
+
+/**
+ * @brief Looks a key up in a shard; the caller holds its lock.
+ * @return The entry, or `NULL` if the key is not interned.
+ */
+static inline StrSafe_interned* strsafe_intern_probe(const StrSafe_intern_shard* shard, const char* bytes, size_t len, uint64_t hash) {
+	if (shard->slot_count == 0) return NULL;
+	size_t mask = shard->slot_count - 1;
+	for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+		StrSafe_interned* entry = shard->slots[i];
+		if (!entry) return NULL;
+		if (entry->hash == hash && strsafe_length(&entry->str) == len
+			&& memcmp(strsafe_cstr(&entry->str), bytes, len) == 0) {
+			return entry;
+		}
+	}
+}
+
+/**
+ * @brief Doubles the slots of a shard and rehashes its entries; the caller holds its write lock.
+ * @return `true` if successful, `false` on allocation failure (the shard is unchanged).
+ */
+static inline bool strsafe_intern_grow(StrSafe_intern_shard* shard) {
+	size_t slot_count = shard->slot_count ? shard->slot_count * 2 : 16;
+	StrSafe_interned** slots = STRSAFE_MALLOC(sizeof(StrSafe_interned*) * slot_count);
+	if (!slots) return false;
+	memset(slots, 0, sizeof(StrSafe_interned*) * slot_count);
+
+	size_t mask = slot_count - 1;
+	for (size_t j = 0; j < shard->slot_count; ++j) {
+		StrSafe_interned* entry = shard->slots[j];
+		if (!entry) continue;
+		size_t i = (size_t)entry->hash & mask;
+		while (slots[i]) {
+			i = (i + 1) & mask;
+		}
+		slots[i] = entry;
+	}
+	STRSAFE_FREE(shard->slots);
+	shard->slots = slots;
+	shard->slot_count = slot_count;
+	return true;
+}
+
+/**
+ * @brief Returns the canonical handle for `len` bytes of `bytes`, interning them if new.
+ *
+ * Safe to call from many threads at once. The handle is owned by the table: read it with
+ * `strsafe_cstr`/`strsafe_length` or copy it, but never modify or free it.
+ *
+ * @param table The table.
+ * @param bytes Key bytes; copied on first insertion.
+ * @param len Number of bytes.
+ * @return The handle, equal by pointer for equal keys, or `NULL` on allocation failure.
+ */
+static inline const StrSafe* strsafe_intern_n(StrSafe_intern_table* table, const char* bytes, size_t len) {
+	uint64_t hash = strsafe_hash_n(bytes, len, 0);
+	StrSafe_intern_shard* shard = &table->shards[(hash >> 32) & (STRSAFE_INTERN_SHARDS - 1)];
+
+	strsafe_rwlock_read(&shard->lock);
+	StrSafe_interned* entry = strsafe_intern_probe(shard, bytes, len, hash);
+	strsafe_rwlock_read_unlock(&shard->lock);
+	if (entry) return &entry->str;
+
+	strsafe_rwlock_write(&shard->lock);
+	// another thread may have inserted the key between the two locks
+	entry = strsafe_intern_probe(shard, bytes, len, hash);
+	if (entry) {
+		strsafe_rwlock_write_unlock(&shard->lock);
+		return &entry->str;
+	}
+	// keep the load factor at or below 3/4
+	if ((shard->count + 1) * 4 > shard->slot_count * 3 && !strsafe_intern_grow(shard)) {
+		strsafe_rwlock_write_unlock(&shard->lock);
+		return NULL;
+	}
+	entry = strsafe_mem_alloc(strsafe_arena_allocator(&shard->arena), sizeof(StrSafe_interned) + len + 1);
+	if (!entry) {
+		strsafe_rwlock_write_unlock(&shard->lock);
+		return NULL;
+	}
+	char* data = (char*)(entry + 1);
+	memcpy(data, bytes, len);
+	data[len] = '\0';
+	strsafe_init(&entry->str);
+	strsafe_set_heap(&entry->str, data, len, len + 1);
+	entry->hash = hash;
+
+	size_t mask = shard->slot_count - 1;
+	size_t i = (size_t)hash & mask;
+	while (shard->slots[i]) {
+		i = (i + 1) & mask;
+	}
+	shard->slots[i] = entry;
+	shard->count++;
+	strsafe_rwlock_write_unlock(&shard->lock);
+	return &entry->str;
+}
+
+/**
+ * @brief Returns the canonical handle for a null-terminated string, interning it if new.
+ * @param table The table.
+ * @param src The string.
+ * @return The handle, or `NULL` on allocation failure.
+ */
+static inline const StrSafe* cstr_intern(StrSafe_intern_table* table, const char* src) {
+	return strsafe_intern_n(table, src, strlen(src));
+}
+
+/**
+ * @brief Returns the canonical handle for the contents of a `StrSafe`, interning them if new.
+ * @param table The table.
+ * @param src The string.
+ * @return The handle, or `NULL` on allocation failure.
+ */
+static inline const StrSafe* strsafe_intern(StrSafe_intern_table* table, const StrSafe* src) {
+	return strsafe_intern_n(table, strsafe_cstr(src), strsafe_length(src));
+}
+
+/**
+ * @brief Returns the canonical handle for the bytes of a view, interning them if new.
+ * @param table The table.
+ * @param view The bytes.
+ * @return The handle, or `NULL` on allocation failure.
+ */
+static inline const StrSafe* strsafe_intern_view(StrSafe_intern_table* table, StrSafe_view view) {
+	return strsafe_intern_n(table, view.ptr, view.len);
+}
+
+/**
+ * @brief Looks up the handle for `len` bytes of `bytes` without interning them.
+ * @param table The table.
+ * @param bytes Key bytes.
+ * @param len Number of bytes.
+ * @return The handle, or `NULL` if the key has not been interned.
+ */
+static inline const StrSafe* strsafe_intern_lookup(StrSafe_intern_table* table, const char* bytes, size_t len) {
+	uint64_t hash = strsafe_hash_n(bytes, len, 0);
+	StrSafe_intern_shard* shard = &table->shards[(hash >> 32) & (STRSAFE_INTERN_SHARDS - 1)];
+	strsafe_rwlock_read(&shard->lock);
+	StrSafe_interned* entry = strsafe_intern_probe(shard, bytes, len, hash);
+	strsafe_rwlock_read_unlock(&shard->lock);
+	return entry ? &entry->str : NULL;
+}
+
+/**
+ * @brief Returns the hash cached for an interned handle.
+ * @param handle A handle returned by this header's functions.
+ * @return The hash computed when the key was interned, equal to `strsafe_hash(handle)`.
+ */
+static inline uint64_t strsafe_intern_hash(const StrSafe* handle) {
+	return ((const StrSafe_interned*)(const void*)handle)->hash;
+}
+
+/**
+ * @brief Counts the distinct keys in a table.
+ * @param table The table.
+ * @return Number of interned keys.
+ */
+static inline size_t strsafe_intern_count(StrSafe_intern_table* table) {
+	size_t total = 0;
+	for (size_t i = 0; i < STRSAFE_INTERN_SHARDS; ++i) {
+		StrSafe_intern_shard* shard = &table->shards[i];
+		strsafe_rwlock_read(&shard->lock);
+		total += shard->count;
+		strsafe_rwlock_read_unlock(&shard->lock);
+	}
+	return total;
+}
+
+#endif // SAFE_STR_INTERN_H
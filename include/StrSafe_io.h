@@ -0,0 +1,372 @@
+
+/**
+ * @file StrSafe_io.h
+ * @brief File I/O for `StrSafe`: memory-mapped read-only views, sized reads and gather writes.
+ *
+ * `strsafe_map_file` maps a file with `mmap` on POSIX systems and `MapViewOfFile` on
+ * Windows and exposes it as a `StrSafe_view`, so large files can be searched and split
+ * with the view and needle APIs without being copied or scanned by `strlen`. Pages are
+ * loaded by the OS on first access, so mapping costs the same for any file size.
+ *
+ * A mapped view is not null-terminated; use the length-based functions on it.
+ *
+ * `strsafe_write_views` and its array variants write many strings with one `writev` call
+ * per `STRSAFE_IOV_MAX` pieces instead of concatenating them first, resuming after partial
+ * writes. On Windows file descriptors are written piece by piece with `_write`; define
+ * `STRSAFE_IO_WINSOCK` for `strsafe_send_views`, the `WSASend` equivalent for sockets.
+ *
+ */
+
+#ifndef SAFE_STR_IO_H
+#define SAFE_STR_IO_H
+
+#include "StrSafe.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifdef STRSAFE_IO_WINSOCK
+#include <winsock2.h>
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#ifndef STRSAFE_IOV_MAX
+#if defined(IOV_MAX) && IOV_MAX < 1024
+#define STRSAFE_IOV_MAX IOV_MAX
+#else
+#define STRSAFE_IOV_MAX 1024   /**< Pieces handed to one gather call; bounded by the system's `IOV_MAX`. */
+#endif
+#endif
+
+/**
+ * @struct StrSafe_mapped_file
+ * @brief A file mapped read-only into memory.
+ */
+typedef struct {
+	const char* data;   /**< First byte of the mapping; a static empty string for empty files. */
+	size_t len;         /**< File size in bytes. */
+#ifdef _WIN32
+	HANDLE file;        /**< Handle of the open file. */
+	HANDLE mapping;     /**< Handle of the file mapping object. */
+#endif
+} StrSafe_mapped_file;
+
+/**
+ * @brief Maps the file at `path` read-only.
+ *
+ * Empty files succeed with a zero-length view. The file must not be truncated while
+ * mapped; on POSIX systems that raises `SIGBUS` on access.
+ *
+ * @param map Receives the mapping; release it with `strsafe_unmap_file`.
+ * @param path Path of the file to map.
+ * @return `true` if successful, `false` if the file cannot be opened, is too large for
+ *         the address space, or cannot be mapped (`map` is left empty).
+ */
+static inline bool strsafe_map_file(StrSafe_mapped_file* map, const char* path) {
+	memset(map, 0, sizeof(*map));
+	map->data = "";
+#ifdef _WIN32
+	map->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (map->file == INVALID_HANDLE_VALUE) {
+		map->file = NULL;
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(map->file, &size) || (unsigned long long)size.QuadPart > SIZE_MAX) {
+		CloseHandle(map->file);
+		map->file = NULL;
+		return false;
+	}
+	if (size.QuadPart == 0) return true;
+
+	map->mapping = CreateFileMappingA(map->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	const void* view = map->mapping ? MapViewOfFile(map->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (!view) {
+		if (map->mapping) CloseHandle(map->mapping);
+		CloseHandle(map->file);
+		map->mapping = NULL;
+		map->file = NULL;
+		return false;
+	}
+	map->data = view;
+	map->len = (size_t)size.QuadPart;
+	return true;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (unsigned long long)st.st_size > SIZE_MAX) {
+		close(fd);
+		return false;
+	}
+	if (st.st_size == 0) {
+		close(fd);
+		return true;
+	}
+
+	// the mapping keeps its own reference to the file
+	void* view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED) return false;
+	map->data = view;
+	map->len = (size_t)st.st_size;
+	return true;
+#endif
+}
+
+/**
+ * @brief Releases a mapping made by `strsafe_map_file`; views of it become invalid.
+ * @param map Mapping to release; it is left empty.
+ */
+static inline void strsafe_unmap_file(StrSafe_mapped_file* map) {
+#ifdef _WIN32
+	if (map->len > 0) UnmapViewOfFile(map->data);
+	if (map->mapping) CloseHandle(map->mapping);
+	if (map->file) CloseHandle(map->file);
+#else
+	if (map->len > 0) munmap((void*)map->data, map->len);
+#endif
+	memset(map, 0, sizeof(*map));
+	map->data = "";
+}
+
+/**
+ * @brief Returns the contents of a mapped file as a view.
+ * @param map The mapping.
+ * @return View of the whole file, valid until `strsafe_unmap_file`.
+ */
+static inline StrSafe_view strsafe_mapped_view(const StrSafe_mapped_file* map) {
+	return strsafe_view_make(map->data, map->len);
+}
+
+/**
+ * @brief Reads the whole file at `path` into a `StrSafe` with one exact-size allocation.
+ *
+ * Use this rather than a mapping when the contents must be modified or null-terminated.
+ * The file is mapped and copied once, so embedded null bytes are kept and no `strlen`
+ * pass is made.
+ *
+ * @param dst Destination string; its previous contents are replaced.
+ * @param path Path of the file to read.
+ * @return `true` if successful, `false` on I/O or allocation failure (`dst` is unchanged).
+ */
+static inline bool strsafe_read_file(StrSafe* dst, const char* path) {
+	StrSafe_mapped_file map;
+	if (!strsafe_map_file(&map, path)) return false;
+
+	StrSafe result;
+	bool ok = strsafe_init_from(&result, map.data, map.len);
+	strsafe_unmap_file(&map);
+	if (!ok) {
+		strsafe_free(&result);
+		return false;
+	}
+	strsafe_move(dst, &result);
+	return true;
+}
+
+/**
+ * @brief Skips `written` bytes over a list of views after a partial write.
+ * @param views The views being written.
+ * @param count Number of views.
+ * @param next Index of the first view not fully written; advanced.
+ * @param skip Bytes of `views[*next]` already written; updated.
+ * @param written Bytes the last call wrote.
+ */
+static inline void strsafe_io_advance(const StrSafe_view* views, size_t count, size_t* next, size_t* skip, size_t written) {
+	while (*next < count && written >= views[*next].len - *skip) {
+		written -= views[*next].len - *skip;
+		++*next;
+		*skip = 0;
+	}
+	*skip += written;
+}
+
+/**
+ * @brief Writes `count` views to a file descriptor in order, without concatenating them.
+ *
+ * On POSIX systems up to `STRSAFE_IOV_MAX` views go to each `writev` call; partial
+ * writes resume where they stopped and `EINTR` is retried. Non-blocking descriptors are
+ * not waited on: `EAGAIN` is reported as a failure.
+ *
+ * @param fd Destination file descriptor.
+ * @param views Pieces to write.
+ * @param count Number of views.
+ * @return `true` if every byte was written, `false` on a write error.
+ */
+static inline bool strsafe_write_views(int fd, const StrSafe_view* views, size_t count) {
+	size_t next = 0;
+	size_t skip = 0;
+#ifdef _WIN32
+	while (next < count) {
+		size_t remaining = views[next].len - skip;
+		if (remaining == 0) {
+			strsafe_io_advance(views, count, &next, &skip, 0);
+			continue;
+		}
+		unsigned chunk = remaining > INT_MAX ? INT_MAX : (unsigned)remaining;
+		int written = _write(fd, views[next].ptr + skip, chunk);
+		if (written <= 0) return false;
+		strsafe_io_advance(views, count, &next, &skip, (size_t)written);
+	}
+#else
+	struct iovec iov[STRSAFE_IOV_MAX];
+	while (next < count) {
+		int n = 0;
+		size_t batch_len = 0;
+		// the byte total of one call must stay within ssize_t
+		for (size_t i = next; i < count && n < STRSAFE_IOV_MAX && batch_len < SSIZE_MAX / 2; ++i, ++n) {
+			size_t offset = i == next ? skip : 0;
+			size_t len = views[i].len - offset;
+			if (len > SSIZE_MAX / 2) len = SSIZE_MAX / 2;
+			iov[n].iov_base = (void*)(views[i].ptr + offset);
+			iov[n].iov_len = len;
+			batch_len += len;
+		}
+		if (batch_len == 0) {
+			next += n;
+			skip = 0;
+			continue;
+		}
+
+		ssize_t written = writev(fd, iov, n);
+		if (written < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		if (written == 0) return false;
+		strsafe_io_advance(views, count, &next, &skip, (size_t)written);
+	}
+#endif
+	return true;
+}
+
+/**
+ * @brief Writes `count` `StrSafe` strings to a file descriptor in order.
+ *
+ * Views of the strings are gathered `STRSAFE_IOV_MAX` at a time on the stack, so no
+ * allocation or copy of the contents is made.
+ *
+ * @param fd Destination file descriptor.
+ * @param strs Strings to write.
+ * @param count Number of strings.
+ * @return `true` if every byte was written, `false` on a write error.
+ */
+static inline bool strsafe_write_strs(int fd, const StrSafe* strs, size_t count) {
+	StrSafe_view views[STRSAFE_IOV_MAX];
+	for (size_t done = 0; done < count;) {
+		size_t n = count - done < STRSAFE_IOV_MAX ? count - done : STRSAFE_IOV_MAX;
+		for (size_t i = 0; i < n; ++i) {
+			views[i] = strsafe_view_of(&strs[done + i]);
+		}
+		if (!strsafe_write_views(fd, views, n)) return false;
+		done += n;
+	}
+	return true;
+}
+
+/**
+ * @brief Writes every string of a `StrSafe_array` to a file descriptor in order.
+ * @param fd Destination file descriptor.
+ * @param strsafe_array Strings to write.
+ * @return `true` if every byte was written, `false` on a write error.
+ */
+static inline bool strsafe_write_array(int fd, const StrSafe_array* strsafe_array) {
+	return strsafe_write_strs(fd, strsafe_array->arr, (size_t)strsafe_array->array_size);
+}
+
+/**
+ * @brief Writes every view of a `StrSafe_view_array` to a file descriptor in order.
+ * @param fd Destination file descriptor.
+ * @param views Views to write.
+ * @return `true` if every byte was written, `false` on a write error.
+ */
+static inline bool strsafe_write_view_array(int fd, const StrSafe_view_array* views) {
+	return strsafe_write_views(fd, views->views, views->count);
+}
+
+/**
+ * @brief Writes `count` views to a stdio stream in order.
+ *
+ * Each view goes straight into the stream's buffer with `fwrite`, so no concatenated
+ * copy is made.
+ *
+ * @param file Destination stream.
+ * @param views Pieces to write.
+ * @param count Number of views.
+ * @return `true` if every byte was written, `false` on a write error.
+ */
+static inline bool strsafe_fwrite_views(FILE* file, const StrSafe_view* views, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		if (views[i].len > 0 && fwrite(views[i].ptr, 1, views[i].len, file) != views[i].len) return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Writes every string of a `StrSafe_array` to a stdio stream in order.
+ * @param file Destination stream.
+ * @param strsafe_array Strings to write.
+ * @return `true` if every byte was written, `false` on a write error.
+ */
+static inline bool strsafe_fwrite_array(FILE* file, const StrSafe_array* strsafe_array) {
+	for (int i = 0; i < strsafe_array->array_size; ++i) {
+		StrSafe_view view = strsafe_view_of(&strsafe_array->arr[i]);
+		if (!strsafe_fwrite_views(file, &view, 1)) return false;
+	}
+	return true;
+}
+
+#if defined(_WIN32) && defined(STRSAFE_IO_WINSOCK)
+/**
+ * @brief Sends `count` views on a socket with `WSASend`, `STRSAFE_IOV_MAX` at a time.
+ *
+ * Partial sends resume where they stopped. Link with `ws2_32`.
+ *
+ * @param socket Connected socket.
+ * @param views Pieces to send.
+ * @param count Number of views.
+ * @return `true` if every byte was sent, `false` on a socket error.
+ */
+static inline bool strsafe_send_views(SOCKET socket, const StrSafe_view* views, size_t count) {
+	WSABUF bufs[STRSAFE_IOV_MAX];
+	size_t next = 0;
+	size_t skip = 0;
+	while (next < count) {
+		DWORD n = 0;
+		size_t batch_len = 0;
+		for (size_t i = next; i < count && n < STRSAFE_IOV_MAX && batch_len < ULONG_MAX / 2; ++i, ++n) {
+			size_t offset = i == next ? skip : 0;
+			size_t len = views[i].len - offset;
+			if (len > ULONG_MAX / 2) len = ULONG_MAX / 2;
+			bufs[n].buf = (CHAR*)(views[i].ptr + offset);
+			bufs[n].len = (ULONG)len;
+			batch_len += len;
+		}
+		if (batch_len == 0) {
+			next += n;
+			skip = 0;
+			continue;
+		}
+
+		DWORD sent = 0;
+		if (WSASend(socket, bufs, n, &sent, 0, NULL, NULL) != 0 || sent == 0) return false;
+		strsafe_io_advance(views, count, &next, &skip, sent);
+	}
+	return true;
+}
+#endif
+
+#endif // SAFE_STR_IO_H
@@ -0,0 +1,487 @@
+
+/**
+ * @file StrSafe_literal.h
+ * @brief Find, count and replace with compile-time needle lengths, and type-generic entry points.
+ *
+ * The `_lit` macros take string literals and pass `sizeof(literal) - 1` as the length, so
+ * `cstr_find_lit(s, ", ")` runs no `strlen` and the kernel choice in `cstr_find_lit_n`
+ * folds away at compile time. Only literals are accepted: the macros paste `""` in front
+ * of the argument, so passing a pointer or an array variable, whose `sizeof` is not the
+ * length of the text, does not compile. Embedded null bytes count as part of the needle.
+ *
+ * Needles of 1 byte search with `memchr`, and count and replace 1 byte with 1 byte
+ * in a single vector pass. Needles of 2, 4 and 8 bytes use the first/last byte filter of
+ * `strsafe_memmem` but confirm a candidate with one word compare instead of `memcmp`,
+ * which pays off on text where the filter lets many candidates through. Other lengths
+ * take the generic path of `StrSafe.h`.
+ *
+ * In C, `STRSAFE_FIND`, `STRSAFE_COUNT`, `STRSAFE_CONTAINS` and `STRSAFE_REPLACE_ALL`
+ * pick the function from the needle's type: a C string, a `StrSafe`, a `StrSafe_view`
+ * (use `STRSAFE_LIT` to make one from a literal) or a prepared `StrSafe_needle`.
+ *
+ */
+
+#ifndef SAFE_STR_LITERAL_H
+#define SAFE_STR_LITERAL_H
+
+#include "StrSafe.h"
+
+/** @brief Expands a string literal to its bytes and length, for the `_n` functions. */
+#define STRSAFE_LIT_ARGS(lit) ("" lit), (sizeof(lit) - 1)
+
+/** @brief Makes a `StrSafe_view` of a string literal without `strlen`. */
+#define STRSAFE_LIT(lit) strsafe_view_make(STRSAFE_LIT_ARGS(lit))
+
+/**
+ * @brief Compares 2, 4 or 8 bytes as one word.
+ * @param a First bytes.
+ * @param b Second bytes.
+ * @param width 2, 4 or 8.
+ * @return `true` if the bytes are equal.
+ */
+static inline bool strsafe_word_equal(const char* a, const char* b, size_t width) {
+	switch (width) {
+	case 2: {
+		uint16_t x, y;
+		memcpy(&x, a, 2);
+		memcpy(&y, b, 2);
+		return x == y;
+	}
+	case 4: {
+		uint32_t x, y;
+		memcpy(&x, a, 4);
+		memcpy(&y, b, 4);
+		return x == y;
+	}
+	default: {
+		uint64_t x, y;
+		memcpy(&x, a, 8);
+		memcpy(&y, b, 8);
+		return x == y;
+	}
+	}
+}
+
+/**
+ * @brief Portable word kernel: `memchr` for the first byte, one word compare for the needle.
+ * @param haystack Bytes to search.
+ * @param haystack_len Number of bytes in `haystack`.
+ * @param needle Bytes to find.
+ * @param width Number of bytes in `needle`: 2, 4 or 8.
+ * @return Pointer to the first match, or `NULL` if not found.
+ */
+static inline const char* strsafe_memmem_word_scalar(const char* haystack, size_t haystack_len, const char* needle, size_t width) {
+	if (width > haystack_len) return NULL;
+
+	const char* last = haystack + (haystack_len - width);
+	const char* p = haystack;
+	while (p <= last) {
+		p = memchr(p, needle[0], last - p + 1);
+		if (!p) return NULL;
+		if (strsafe_word_equal(p, needle, width)) return p;
+		++p;
+	}
+	return NULL;
+}
+
+#ifdef STRSAFE_HAVE_AVX2
+/** @brief AVX2 version of `strsafe_memmem_word`; `haystack_len` must be at least `width + 31`. */
+STRSAFE_AVX2_TARGET
+static inline const char* strsafe_memmem_word_avx2(const char* haystack, size_t haystack_len, const char* needle, size_t width) {
+	const __m256i first = _mm256_set1_epi8(needle[0]);
+	const __m256i last = _mm256_set1_epi8(needle[width - 1]);
+	size_t i = 0;
+	for (; i + width + 31 <= haystack_len; i += 32) {
+		__m256i block_first = _mm256_loadu_si256((const __m256i*)(haystack + i));
+		__m256i block_last = _mm256_loadu_si256((const __m256i*)(haystack + i + width - 1));
+		__m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last));
+		uint64_t mask = (uint32_t)_mm256_movemask_epi8(eq);
+		while (mask) {
+			size_t pos = i + strsafe_ctz64(mask);
+			if (strsafe_word_equal(haystack + pos, needle, width)) return haystack + pos;
+			mask &= mask - 1;
+		}
+	}
+	return strsafe_memmem_word_scalar(haystack + i, haystack_len - i, needle, width);
+}
+#endif
+
+/**
+ * @brief Finds a 2, 4 or 8 byte needle: first/last byte filter, then one word compare per candidate.
+ * @param haystack Bytes to search.
+ * @param haystack_len Number of bytes in `haystack`.
+ * @param needle Bytes to find.
+ * @param width Number of bytes in `needle`: 2, 4 or 8.
+ * @return Pointer to the first match, or `NULL` if not found.
+ */
+static inline const char* strsafe_memmem_word(const char* haystack, size_t haystack_len, const char* needle, size_t width) {
+	if (width > haystack_len) return NULL;
+
+#if defined(STRSAFE_HAVE_AVX2)
+	if (haystack_len >= width + 31 && strsafe_cpu_has_avx2()) {
+		return strsafe_memmem_word_avx2(haystack, haystack_len, needle, width);
+	}
+#endif
+	size_t i = 0;
+#if defined(STRSAFE_HAVE_SSE2)
+	const __m128i first = _mm_set1_epi8(needle[0]);
+	const __m128i last = _mm_set1_epi8(needle[width - 1]);
+	for (; i + width + 15 <= haystack_len; i += 16) {
+		__m128i block_first = _mm_loadu_si128((const __m128i*)(haystack + i));
+		__m128i block_last = _mm_loadu_si128((const __m128i*)(haystack + i + width - 1));
+		__m128i eq = _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last));
+		uint64_t mask = (unsigned)_mm_movemask_epi8(eq);
+		while (mask) {
+			size_t pos = i + strsafe_ctz64(mask);
+			if (strsafe_word_equal(haystack + pos, needle, width)) return haystack + pos;
+			mask &= mask - 1;
+		}
+	}
+#elif defined(STRSAFE_HAVE_NEON)
+	const uint8x16_t first = vdupq_n_u8((uint8_t)needle[0]);
+	const uint8x16_t last = vdupq_n_u8((uint8_t)needle[width - 1]);
+	for (; i + width + 15 <= haystack_len; i += 16) {
+		uint8x16_t block_first = vld1q_u8((const uint8_t*)(haystack + i));
+		uint8x16_t block_last = vld1q_u8((const uint8_t*)(haystack + i + width - 1));
+		uint8x16_t eq = vandq_u8(vceqq_u8(first, block_first), vceqq_u8(last, block_last));
+		uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+		while (mask) {
+			unsigned bit = strsafe_ctz64(mask);
+			size_t pos = i + (bit >> 2);
+			if (strsafe_word_equal(haystack + pos, needle, width)) return haystack + pos;
+			mask &= ~((uint64_t)0xF << (bit & ~3u));
+		}
+	}
+#endif
+	return strsafe_memmem_word_scalar(haystack + i, haystack_len - i, needle, width);
+}
+
+/**
+ * @brief Finds `needle` in `haystack`, choosing the kernel from `needle_len`.
+ *
+ * Same result as `strsafe_memmem`. With a constant `needle_len`, as the `_lit` macros
+ * pass, the compiler keeps only the branch for that length.
+ *
+ * @param haystack Bytes to search.
+ * @param haystack_len Number of bytes in `haystack`.
+ * @param needle Bytes to find.
+ * @param needle_len Number of bytes in `needle`.
+ * @return Pointer to the first match, or `NULL` if not found. An empty needle matches at `haystack`.
+ */
+static inline const char* strsafe_memmem_fixed(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+	switch (needle_len) {
+	case 0: return haystack;
+	case 1: return memchr(haystack, needle[0], haystack_len);
+	case 2: case 4: case 8: return strsafe_memmem_word(haystack, haystack_len, needle, needle_len);
+	default: return strsafe_memmem(haystack, haystack_len, needle, needle_len);
+	}
+}
+
+#ifdef STRSAFE_HAVE_AVX2
+/** @brief AVX2 loop of `strsafe_count_byte`; counts whole 32-byte blocks and sets `*done`. */
+STRSAFE_AVX2_TARGET
+static inline size_t strsafe_count_byte_avx2(const char* bytes, size_t len, char c, size_t* done) {
+	const __m256i target = _mm256_set1_epi8(c);
+	size_t count = 0;
+	size_t i = 0;
+	while (i + 32 <= len) {
+		// each lane counts up by subtracting -1 for a hit; flush before it can wrap
+		__m256i lanes = _mm256_setzero_si256();
+		for (size_t run = 0; run < 255 && i + 32 <= len; ++run, i += 32) {
+			__m256i x = _mm256_loadu_si256((const __m256i*)(bytes + i));
+			lanes = _mm256_sub_epi8(lanes, _mm256_cmpeq_epi8(x, target));
+		}
+		__m256i sums = _mm256_sad_epu8(lanes, _mm256_setzero_si256());
+		__m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+		count += (size_t)_mm_cvtsi128_si32(half) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(half, 8));
+	}
+	*done = i;
+	return count;
+}
+#endif
+
+/**
+ * @brief Counts the bytes equal to `c`.
+ * @param bytes Bytes to scan.
+ * @param len Number of bytes.
+ * @param c Byte to count.
+ * @return Number of bytes equal to `c`.
+ */
+static inline size_t strsafe_count_byte(const char* bytes, size_t len, char c) {
+	size_t count = 0;
+	size_t i = 0;
+#if defined(STRSAFE_HAVE_AVX2)
+	if (len >= 32 && strsafe_cpu_has_avx2()) count = strsafe_count_byte_avx2(bytes, len, c, &i);
+#endif
+#if defined(STRSAFE_HAVE_SSE2)
+	const __m128i target = _mm_set1_epi8(c);
+	while (i + 16 <= len) {
+		__m128i lanes = _mm_setzero_si128();
+		for (size_t run = 0; run < 255 && i + 16 <= len; ++run, i += 16) {
+			__m128i x = _mm_loadu_si128((const __m128i*)(bytes + i));
+			lanes = _mm_sub_epi8(lanes, _mm_cmpeq_epi8(x, target));
+		}
+		__m128i sums = _mm_sad_epu8(lanes, _mm_setzero_si128());
+		count += (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+	}
+#elif defined(STRSAFE_HAVE_NEON)
+	const uint8x16_t target = vdupq_n_u8((uint8_t)c);
+	while (i + 16 <= len) {
+		uint8x16_t lanes = vdupq_n_u8(0);
+		for (size_t run = 0; run < 255 && i + 16 <= len; ++run, i += 16) {
+			uint8x16_t x = vld1q_u8((const uint8_t*)(bytes + i));
+			lanes = vsubq_u8(lanes, vceqq_u8(x, target));
+		}
+		uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(lanes)));
+		count += (size_t)(vgetq_lane_u64(sums, 0) + vgetq_lane_u64(sums, 1));
+	}
+#endif
+	for (; i < len; ++i) {
+		count += bytes[i] == c;
+	}
+	return count;
+}
+
+#ifdef STRSAFE_HAVE_AVX2
+/** @brief AVX2 loop of `strsafe_replace_byte`; returns the number of bytes done. */
+STRSAFE_AVX2_TARGET
+static inline size_t strsafe_replace_byte_avx2(char* bytes, size_t len, char from, char to) {
+	const __m256i target = _mm256_set1_epi8(from);
+	const __m256i replacement = _mm256_set1_epi8(to);
+	size_t i = 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i x = _mm256_loadu_si256((const __m256i*)(bytes + i));
+		__m256i hit = _mm256_cmpeq_epi8(x, target);
+		_mm256_storeu_si256((__m256i*)(bytes + i), _mm256_blendv_epi8(x, replacement, hit));
+	}
+	return i;
+}
+#endif
+
+/**
+ * @brief Replaces every byte equal to `from` with `to`.
+ * @param bytes Bytes to rewrite in place.
+ * @param len Number of bytes.
+ * @param from Byte to replace.
+ * @param to Replacement byte.
+ */
+static inline void strsafe_replace_byte(char* bytes, size_t len, char from, char to) {
+	size_t i = 0;
+#if defined(STRSAFE_HAVE_AVX2)
+	if (len >= 32 && strsafe_cpu_has_avx2()) i = strsafe_replace_byte_avx2(bytes, len, from, to);
+#endif
+#if defined(STRSAFE_HAVE_SSE2)
+	const __m128i target = _mm_set1_epi8(from);
+	const __m128i replacement = _mm_set1_epi8(to);
+	for (; i + 16 <= len; i += 16) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(bytes + i));
+		__m128i hit = _mm_cmpeq_epi8(x, target);
+		_mm_storeu_si128((__m128i*)(bytes + i), _mm_or_si128(_mm_andnot_si128(hit, x), _mm_and_si128(hit, replacement)));
+	}
+#elif defined(STRSAFE_HAVE_NEON)
+	const uint8x16_t target = vdupq_n_u8((uint8_t)from);
+	const uint8x16_t replacement = vdupq_n_u8((uint8_t)to);
+	for (; i + 16 <= len; i += 16) {
+		uint8x16_t x = vld1q_u8((const uint8_t*)(bytes + i));
+		vst1q_u8((uint8_t*)(bytes + i), vbslq_u8(vceqq_u8(x, target), replacement, x));
+	}
+#endif
+	for (; i < len; ++i) {
+		if (bytes[i] == from) bytes[i] = to;
+	}
+}
+
+/**
+ * @brief Finds the first occurrence of `needle_len` bytes of `needle`, with the kernel chosen by length.
+ *
+ * Same result as `cstr_find_n`; `cstr_find_lit` calls it with a constant length.
+ *
+ * @param haystack The string to search.
+ * @param needle The bytes to find.
+ * @param needle_len Number of bytes in `needle`.
+ * @return Position of the first match, or -1 if not found.
+ */
+static inline ssize_t cstr_find_lit_n(const StrSafe* haystack, const char* needle, size_t needle_len) {
+	const char* data = strsafe_cstr(haystack);
+	const char* pos = strsafe_memmem_fixed(data, strsafe_length(haystack), needle, needle_len);
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_FIND, pos ? (size_t)(pos - data) + needle_len : strsafe_length(haystack));
+	return pos ? (ssize_t)(pos - data) : -1;
+}
+
+/**
+ * @brief Tells whether `needle_len` bytes of `needle` occur in a `StrSafe` string.
+ * @param haystack The string to search.
+ * @param needle The bytes to find.
+ * @param needle_len Number of bytes in `needle`.
+ * @return `true` if found; an empty needle is always found.
+ */
+static inline bool cstr_contains_lit_n(const StrSafe* haystack, const char* needle, size_t needle_len) {
+	return cstr_find_lit_n(haystack, needle, needle_len) >= 0;
+}
+
+/**
+ * @brief Counts non-overlapping occurrences of `needle_len` bytes of `needle`, with the kernel chosen by length.
+ *
+ * Same result as `cstr_count_n`. A 1-byte needle is counted in one pass without stopping
+ * at each match.
+ *
+ * @param haystack The string to search.
+ * @param needle The bytes to count; an empty needle counts as 0.
+ * @param needle_len Number of bytes in `needle`.
+ * @return Number of occurrences found.
+ */
+static inline size_t cstr_count_lit_n(const StrSafe* haystack, const char* needle, size_t needle_len) {
+	const char* p = strsafe_cstr(haystack);
+	size_t len = strsafe_length(haystack);
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_COUNT, len);
+	if (needle_len == 0) return 0;
+	if (needle_len == 1) return strsafe_count_byte(p, len, needle[0]);
+
+	size_t count = 0;
+	const char* end = p + len;
+	while ((p = strsafe_memmem_fixed(p, end - p, needle, needle_len))) {
+		++count;
+		p += needle_len;
+	}
+	return count;
+}
+
+/**
+ * @brief Replaces all occurrences of `old_len` bytes of `old_str` with `new_len` bytes of `new_str`.
+ *
+ * Same result as `cstr_replace_all_n`. Replacing one byte with one byte rewrites the
+ * string in place in one vector pass from the first match; a string without a match is
+ * left untouched and stays shared if it was.
+ *
+ * @param dst The target string to modify.
+ * @param old_str The bytes to be replaced; an empty pattern leaves `dst` unchanged.
+ * @param old_len Number of bytes in `old_str`.
+ * @param new_str The replacement bytes; neither pattern may point into `dst`.
+ * @param new_len Number of bytes in `new_str`.
+ * @return Pointer to `dst`, or `NULL` on allocation failure.
+ */
+static inline StrSafe* cstr_replace_all_lit_n(StrSafe* dst, const char* old_str, size_t old_len, const char* new_str, size_t new_len) {
+	if (old_len != 1 || new_len != 1) return cstr_replace_all_n(dst, old_str, old_len, new_str, new_len);
+
+	size_t len = strsafe_length(dst);
+	STRSAFE_STAT_SEARCH(STRSAFE_STAT_REPLACE, len);
+	const char* first = memchr(strsafe_cstr(dst), old_str[0], len);
+	if (!first) return dst;
+	size_t from = first - strsafe_cstr(dst);
+	if (strsafe_is_shared(dst) && !strsafe_unshare(dst)) return NULL;
+	strsafe_replace_byte(strsafe_data(dst) + from, len - from, old_str[0], new_str[0]);
+	STRSAFE_STAT(STRSAFE_STAT_REPLACE, STRSAFE_EVENT_COPY, len - from);
+	return dst;
+}
+
+/** @brief `cstr_find_lit_n` with the length of a string literal taken at compile time. */
+#define cstr_find_lit(haystack, lit) cstr_find_lit_n((haystack), STRSAFE_LIT_ARGS(lit))
+
+/** @brief `cstr_contains_lit_n` with the length of a string literal taken at compile time. */
+#define cstr_contains_lit(haystack, lit) cstr_contains_lit_n((haystack), STRSAFE_LIT_ARGS(lit))
+
+/** @brief `cstr_count_lit_n` with the length of a string literal taken at compile time. */
+#define cstr_count_lit(haystack, lit) cstr_count_lit_n((haystack), STRSAFE_LIT_ARGS(lit))
+
+/** @brief `cstr_replace_all_lit_n` with the lengths of two string literals taken at compile time. */
+#define cstr_replace_all_lit(dst, old_lit, new_lit) cstr_replace_all_lit_n((dst), STRSAFE_LIT_ARGS(old_lit), STRSAFE_LIT_ARGS(new_lit))
+
+/** @brief `cstr_append_n` with the length of a string literal taken at compile time. */
+#define cstr_append_lit(dst, lit) cstr_append_n((dst), STRSAFE_LIT_ARGS(lit))
+
+#ifndef __cplusplus
+/*
+ * Targets of the type-generic macros below. Each needle type gets one function per
+ * operation with the same shape, so `_Generic` only has to pick a name.
+ */
+
+static inline ssize_t strsafe_generic_find_cstr(const StrSafe* haystack, const char* needle) {
+	return cstr_find_lit_n(haystack, needle, strlen(needle));
+}
+
+static inline ssize_t strsafe_generic_find_str(const StrSafe* haystack, const StrSafe* needle) {
+	return cstr_find_lit_n(haystack, strsafe_cstr(needle), strsafe_length(needle));
+}
+
+static inline ssize_t strsafe_generic_find_view(const StrSafe* haystack, StrSafe_view needle) {
+	return cstr_find_lit_n(haystack, needle.ptr, needle.len);
+}
+
+static inline size_t strsafe_generic_count_cstr(const StrSafe* haystack, const char* needle) {
+	return cstr_count_lit_n(haystack, needle, strlen(needle));
+}
+
+static inline size_t strsafe_generic_count_str(const StrSafe* haystack, const StrSafe* needle) {
+	return cstr_count_lit_n(haystack, strsafe_cstr(needle), strsafe_length(needle));
+}
+
+static inline size_t strsafe_generic_count_view(const StrSafe* haystack, StrSafe_view needle) {
+	return cstr_count_lit_n(haystack, needle.ptr, needle.len);
+}
+
+static inline bool strsafe_generic_replace_all_cstr(StrSafe* dst, const char* old_str, const char* new_str) {
+	return cstr_replace_all_lit_n(dst, old_str, strlen(old_str), new_str, strlen(new_str)) != NULL;
+}
+
+static inline bool strsafe_generic_replace_all_str(StrSafe* dst, const StrSafe* old_str, const StrSafe* new_str) {
+	return cstr_replace_all_lit_n(dst, strsafe_cstr(old_str), strsafe_length(old_str), strsafe_cstr(new_str), strsafe_length(new_str)) != NULL;
+}
+
+static inline bool strsafe_generic_replace_all_view(StrSafe* dst, StrSafe_view old_str, StrSafe_view new_str) {
+	return cstr_replace_all_lit_n(dst, old_str.ptr, old_str.len, new_str.ptr, new_str.len) != NULL;
+}
+
+static inline bool strsafe_generic_replace_all_needle(StrSafe* dst, const StrSafe_needle* old_str, StrSafe_view new_str) {
+	return strsafe_needle_replace_all(dst, old_str, new_str.ptr, new_str.len) != NULL;
+}
+
+/**
+ * @brief Finds the first occurrence of `needle` in the `StrSafe` pointed to by `haystack`.
+ *
+ * `needle` may be a C string, a `StrSafe*`, a `StrSafe_view` or a `StrSafe_needle*`.
+ * Evaluates to the position of the first match, or -1 if not found.
+ */
+#define STRSAFE_FIND(haystack, needle) _Generic((needle), \
+	char*: strsafe_generic_find_cstr, \
+	const char*: strsafe_generic_find_cstr, \
+	StrSafe*: strsafe_generic_find_str, \
+	const StrSafe*: strsafe_generic_find_str, \
+	StrSafe_view: strsafe_generic_find_view, \
+	StrSafe_needle*: strsafe_needle_find, \
+	const StrSafe_needle*: strsafe_needle_find)((haystack), (needle))
+
+/**
+ * @brief Counts non-overlapping occurrences of `needle`, which may be any type `STRSAFE_FIND` takes.
+ *
+ * Evaluates to the number of occurrences; an empty needle counts as 0.
+ */
+#define STRSAFE_COUNT(haystack, needle) _Generic((needle), \
+	char*: strsafe_generic_count_cstr, \
+	const char*: strsafe_generic_count_cstr, \
+	StrSafe*: strsafe_generic_count_str, \
+	const StrSafe*: strsafe_generic_count_str, \
+	StrSafe_view: strsafe_generic_count_view, \
+	StrSafe_needle*: strsafe_needle_count, \
+	const StrSafe_needle*: strsafe_needle_count)((haystack), (needle))
+
+/** @brief Tells whether `needle`, of any type `STRSAFE_FIND` takes, occurs in `haystack`. */
+#define STRSAFE_CONTAINS(haystack, needle) (STRSAFE_FIND((haystack), (needle)) >= 0)
+
+/**
+ * @brief Replaces all occurrences of `old_str` with `new_str` in the `StrSafe` pointed to by `dst`.
+ *
+ * `old_str` and `new_str` are both C strings, both `StrSafe*` or both `StrSafe_view`;
+ * with a `StrSafe_needle*` pattern the replacement is a `StrSafe_view`. Evaluates to
+ * `true` if successful, `false` on allocation failure.
+ */
+#define STRSAFE_REPLACE_ALL(dst, old_str, new_str) _Generic((old_str), \
+	char*: strsafe_generic_replace_all_cstr, \
+	const char*: strsafe_generic_replace_all_cstr, \
+	StrSafe*: strsafe_generic_replace_all_str, \
+	const StrSafe*: strsafe_generic_replace_all_str, \
+	StrSafe_view: strsafe_generic_replace_all_view, \
+	StrSafe_needle*: strsafe_generic_replace_all_needle, \
+	const StrSafe_needle*: strsafe_generic_replace_all_needle)((dst), (old_str), (new_str))
+#endif
+
+#endif // SAFE_STR_LITERAL_H
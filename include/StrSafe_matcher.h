@@ -0,0 +1,345 @@
+
+/**
+ * @file StrSafe_matcher.h
+ * @brief Precompiled multi-pattern matcher (Aho-Corasick) for batch substitutions on `StrSafe`.
+ *
+ * A `StrSafe_matcher` is compiled once from an array of (from, to) pairs and can then be
+ * applied to any number of strings with `strsafe_replace_many`, which rewrites a string
+ * in a single scan with a single output allocation instead of one `cstr_replace_all`
+ * pass per pattern. A compiled matcher is read-only and can be shared between threads.
+ *
+ * Matching is leftmost-longest and non-overlapping: of all matches the one starting
+ * earliest wins, ties go to the longest pattern, and replaced text is never rescanned.
+ *
+ */
+
+#ifndef SAFE_STR_MATCHER_H
+#define SAFE_STR_MATCHER_H
+
+#include "StrSafe.h"
+
+/**
+ * @struct StrSafe_replacement
+ * @brief One substitution: every match of `from` is replaced with `to`.
+ */
+typedef struct {
+	StrSafe_view from;   /**< Pattern to find; empty patterns are ignored. */
+	StrSafe_view to;     /**< Replacement text. */
+} StrSafe_replacement;
+
+/**
+ * @struct StrSafe_matcher
+ * @brief Aho-Corasick automaton over byte classes, with the replacement texts it owns.
+ */
+typedef struct {
+	int32_t* delta;           /**< Transition table, `state_count * class_count` entries. */
+	int32_t* pattern;         /**< Pattern ending at each state, or -1. */
+	int32_t* match_link;      /**< Nearest shorter matching state on the failure chain, or 0. */
+	uint32_t* depth;          /**< Length of the prefix each state represents. */
+	size_t state_count;       /**< Number of states; state 0 is the root. */
+	size_t class_count;       /**< Number of byte classes; class 0 is every byte absent from the patterns. */
+	uint8_t classes[256];     /**< Byte to class mapping. */
+	size_t* from_len;         /**< Length of each pattern. */
+	size_t* to_offset;        /**< Offset of each replacement in `to_bytes`. */
+	size_t* to_len;           /**< Length of each replacement. */
+	char* to_bytes;           /**< Copies of all replacement texts. */
+	size_t pattern_count;     /**< Number of pairs the matcher was compiled from. */
+} StrSafe_matcher;
+
+/**
+ * @brief Initializes a matcher to empty; applying it changes nothing.
+ * @param matcher Matcher to initialize.
+ */
+static inline void strsafe_matcher_init(StrSafe_matcher* matcher) {
+	memset(matcher, 0, sizeof(*matcher));
+}
+
+/**
+ * @brief Frees all memory owned by a matcher.
+ * @param matcher Matcher to free; it is left empty.
+ */
+static inline void strsafe_matcher_free(StrSafe_matcher* matcher) {
+	STRSAFE_FREE(matcher->delta);
+	STRSAFE_FREE(matcher->pattern);
+	STRSAFE_FREE(matcher->match_link);
+	STRSAFE_FREE(matcher->depth);
+	STRSAFE_FREE(matcher->from_len);
+	STRSAFE_FREE(matcher->to_offset);
+	STRSAFE_FREE(matcher->to_len);
+	STRSAFE_FREE(matcher->to_bytes);
+	strsafe_matcher_init(matcher);
+}
+
+/**
+ * @brief Compiles `count` replacement pairs into a matcher.
+ *
+ * The pattern and replacement bytes are copied, so `pairs` may be released afterwards.
+ * When the same pattern appears twice, the first pair wins.
+ *
+ * @param matcher Matcher to build; any previous contents are freed.
+ * @param pairs Replacement pairs.
+ * @param count Number of pairs.
+ * @return `true` if successful, `false` on allocation failure (`matcher` is left empty).
+ */
+static inline bool strsafe_matcher_compile(StrSafe_matcher* matcher, const StrSafe_replacement* pairs, size_t count) {
+	strsafe_matcher_free(matcher);
+
+	// byte classes: every byte used by a pattern gets its own class
+	bool used[256] = { false };
+	size_t total_from = 0;
+	size_t total_to = 0;
+	for (size_t i = 0; i < count; ++i) {
+		for (size_t j = 0; j < pairs[i].from.len; ++j) {
+			used[(uint8_t)pairs[i].from.ptr[j]] = true;
+		}
+		total_from += pairs[i].from.len;
+		total_to += pairs[i].to.len;
+	}
+	matcher->class_count = 1;
+	for (int b = 0; b < 256; ++b) {
+		matcher->classes[b] = used[b] ? (uint8_t)matcher->class_count++ : 0;
+	}
+
+	size_t max_states = total_from + 1;
+	size_t classes = matcher->class_count;
+	matcher->delta = STRSAFE_MALLOC(sizeof(int32_t) * max_states * classes);
+	matcher->pattern = STRSAFE_MALLOC(sizeof(int32_t) * max_states);
+	matcher->match_link = STRSAFE_MALLOC(sizeof(int32_t) * max_states);
+	matcher->depth = STRSAFE_MALLOC(sizeof(uint32_t) * max_states);
+	matcher->from_len = STRSAFE_MALLOC(sizeof(size_t) * (count ? count : 1));
+	matcher->to_offset = STRSAFE_MALLOC(sizeof(size_t) * (count ? count : 1));
+	matcher->to_len = STRSAFE_MALLOC(sizeof(size_t) * (count ? count : 1));
+	matcher->to_bytes = STRSAFE_MALLOC(total_to ? total_to : 1);
+	int32_t* fail = STRSAFE_MALLOC(sizeof(int32_t) * max_states);
+	int32_t* queue = STRSAFE_MALLOC(sizeof(int32_t) * max_states);
+	if (!matcher->delta || !matcher->pattern || !matcher->match_link || !matcher->depth || !matcher->from_len
+		|| !matcher->to_offset || !matcher->to_len || !matcher->to_bytes || !fail || !queue) {
+		STRSAFE_FREE(fail);
+		STRSAFE_FREE(queue);
+		strsafe_matcher_free(matcher);
+		return false;
+	}
+
+	for (size_t i = 0; i < max_states * classes; ++i) {
+		matcher->delta[i] = -1;
+	}
+	matcher->pattern[0] = -1;
+	matcher->depth[0] = 0;
+	matcher->state_count = 1;
+
+	// trie of the patterns
+	size_t to_used = 0;
+	for (size_t i = 0; i < count; ++i) {
+		matcher->from_len[i] = pairs[i].from.len;
+		matcher->to_offset[i] = to_used;
+		matcher->to_len[i] = pairs[i].to.len;
+		if (pairs[i].to.len) {
+			memcpy(matcher->to_bytes + to_used, pairs[i].to.ptr, pairs[i].to.len);
+		}
+		to_used += pairs[i].to.len;
+		if (pairs[i].from.len == 0) {
+			continue;
+		}
+
+		int32_t state = 0;
+		for (size_t j = 0; j < pairs[i].from.len; ++j) {
+			int32_t* next = &matcher->delta[state * classes + matcher->classes[(uint8_t)pairs[i].from.ptr[j]]];
+			if (*next < 0) {
+				int32_t created = (int32_t)matcher->state_count++;
+				matcher->pattern[created] = -1;
+				matcher->depth[created] = matcher->depth[state] + 1;
+				*next = created;
+			}
+			state = *next;
+		}
+		if (matcher->pattern[state] < 0) {
+			matcher->pattern[state] = (int32_t)i;
+		}
+	}
+	matcher->pattern_count = count;
+
+	// breadth-first pass: failure links, completed transitions and match links
+	size_t head = 0;
+	size_t tail = 0;
+	fail[0] = 0;
+	matcher->match_link[0] = 0;
+	for (size_t c = 0; c < classes; ++c) {
+		int32_t next = matcher->delta[c];
+		if (next < 0) {
+			matcher->delta[c] = 0;
+		}
+		else {
+			fail[next] = 0;
+			matcher->match_link[next] = 0;
+			queue[tail++] = next;
+		}
+	}
+	while (head < tail) {
+		int32_t state = queue[head++];
+		for (size_t c = 0; c < classes; ++c) {
+			int32_t* next = &matcher->delta[state * classes + c];
+			int32_t fallback = matcher->delta[fail[state] * classes + c];
+			if (*next < 0) {
+				*next = fallback;
+			}
+			else {
+				fail[*next] = fallback;
+				matcher->match_link[*next] = matcher->pattern[fallback] >= 0 ? fallback : matcher->match_link[fallback];
+				queue[tail++] = *next;
+			}
+		}
+	}
+
+	STRSAFE_FREE(fail);
+	STRSAFE_FREE(queue);
+	return true;
+}
+
+/**
+ * @struct StrSafe_match
+ * @brief A match reported by the matcher.
+ */
+typedef struct {
+	size_t pos;       /**< Offset of the match in the text. */
+	size_t pattern;   /**< Index of the pair whose pattern matched. */
+} StrSafe_match;
+
+/**
+ * @brief Scans `text` and reports leftmost-longest, non-overlapping matches in order.
+ *
+ * A match starting at `start` is final once no pattern prefix still in progress could
+ * begin at or before `start`; the automaton then restarts at the end of the match, so
+ * each match rescans at most one pattern length of text.
+ *
+ * @param matcher Compiled matcher.
+ * @param text Text to scan.
+ * @param on_match Called for each match in order; returning `false` stops the scan.
+ * @param ctx Passed to `on_match`.
+ * @return `false` if `on_match` stopped the scan, `true` otherwise.
+ */
+static inline bool strsafe_matcher_scan(const StrSafe_matcher* matcher, StrSafe_view text,
+	bool (*on_match)(void* ctx, StrSafe_match match), void* ctx) {
+	if (matcher->state_count <= 1) return true;
+
+	size_t classes = matcher->class_count;
+	const uint8_t* bytes = (const uint8_t*)text.ptr;
+	size_t cand_start = SIZE_MAX;
+	size_t cand_len = 0;
+	int32_t cand_pattern = -1;
+	int32_t state = 0;
+
+	for (size_t j = 0; j < text.len; ++j) {
+		state = matcher->delta[state * classes + matcher->classes[bytes[j]]];
+
+		// the longest match ending here is the first on the chain
+		int32_t t = matcher->pattern[state] >= 0 ? state : matcher->match_link[state];
+		if (t) {
+			size_t len = matcher->depth[t];
+			size_t start = j + 1 - len;
+			if (start < cand_start || (start == cand_start && len > cand_len)) {
+				cand_start = start;
+				cand_len = len;
+				cand_pattern = matcher->pattern[t];
+			}
+		}
+
+		// final once no prefix in progress starts at or before it, or the text ends
+		if (cand_pattern >= 0 && (j + 1 == text.len || j + 1 - matcher->depth[state] > cand_start)) {
+			StrSafe_match match = { cand_start, (size_t)cand_pattern };
+			if (!on_match(ctx, match)) return false;
+			j = cand_start + cand_len - 1;
+			state = 0;
+			cand_start = SIZE_MAX;
+			cand_len = 0;
+			cand_pattern = -1;
+		}
+	}
+	return true;
+}
+
+/**
+ * @struct StrSafe_match_list
+ * @brief Growable list of matches with inline storage for the common case.
+ */
+typedef struct {
+	StrSafe_match* items;                    /**< Matches, `local` or heap storage. */
+	size_t count;                            /**< Number of matches. */
+	size_t cap;                              /**< Capacity of `items`. */
+	bool failed;                             /**< An allocation failed while collecting. */
+	StrSafe_match local[STRSAFE_MATCH_STACK];
+} StrSafe_match_list;
+
+static inline bool strsafe_match_list_push_cb(void* ctx, StrSafe_match match) {
+	StrSafe_match_list* list = ctx;
+	if (list->count == list->cap) {
+		size_t new_cap = list->cap * 2;
+		StrSafe_match* grown = list->items == list->local ? STRSAFE_MALLOC(sizeof(StrSafe_match) * new_cap)
+			: STRSAFE_REALLOC(list->items, sizeof(StrSafe_match) * new_cap);
+		if (!grown) {
+			list->failed = true;
+			return false;
+		}
+		if (list->items == list->local) memcpy(grown, list->local, sizeof(list->local));
+		list->items = grown;
+		list->cap = new_cap;
+	}
+	list->items[list->count++] = match;
+	return true;
+}
+
+/**
+ * @brief Applies every replacement of a compiled matcher to `dst` in one pass.
+ *
+ * Matches are collected in a single scan and the result is written with a single
+ * exact-size allocation. Strings without matches are left untouched.
+ *
+ * @param dst The target string to modify.
+ * @param matcher Compiled matcher.
+ * @return `true` if successful, `false` on allocation failure (`dst` is unchanged).
+ */
+static inline bool strsafe_replace_many(StrSafe* dst, const StrSafe_matcher* matcher) {
+	StrSafe_match_list list;
+	list.items = list.local;
+	list.count = 0;
+	list.cap = STRSAFE_MATCH_STACK;
+	list.failed = false;
+
+	const char* src = strsafe_cstr(dst);
+	size_t len = strsafe_length(dst);
+	strsafe_matcher_scan(matcher, strsafe_view_make(src, len), strsafe_match_list_push_cb, &list);
+	bool ok = !list.failed;
+
+	if (ok && list.count > 0) {
+		size_t final_len = len;
+		for (size_t i = 0; i < list.count; ++i) {
+			size_t p = list.items[i].pattern;
+			final_len = final_len - matcher->from_len[p] + matcher->to_len[p];
+		}
+
+		StrSafe result;
+		strsafe_init(&result);
+		ok = strsafe_reserve(&result, final_len + 1);
+		if (ok) {
+			char* out = strsafe_data(&result);
+			size_t copied = 0;
+			for (size_t i = 0; i < list.count; ++i) {
+				size_t pos = list.items[i].pos;
+				size_t p = list.items[i].pattern;
+				memcpy(out, src + copied, pos - copied);
+				out += pos - copied;
+				memcpy(out, matcher->to_bytes + matcher->to_offset[p], matcher->to_len[p]);
+				out += matcher->to_len[p];
+				copied = pos + matcher->from_len[p];
+			}
+			memcpy(out, src + copied, len - copied);
+			out[len - copied] = '\0';
+			strsafe_set_length(&result, final_len);
+			strsafe_move(dst, &result);
+		}
+	}
+
+	if (list.items != list.local) STRSAFE_FREE(list.items);
+	return ok;
+}
+
+#endif // SAFE_STR_MATCHER_H
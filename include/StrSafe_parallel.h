@@ -0,0 +1,962 @@
+
+/**
+ * @file StrSafe_parallel.h
+ * @brief Multi-threaded count, split and replace over large buffers.
+ *
+ * A `StrSafe_thread_pool` keeps worker threads alive between calls; `strsafe_thread_pool_run`
+ * hands them a batch of indexed tasks and returns once all of them are done, with the
+ * calling thread taking tasks as well.
+ *
+ * The parallel functions cut the haystack into chunks and scan each one on the pool. A chunk
+ * owns the matches that start inside it, searching up to `needle->len - 1` bytes past its end,
+ * so matches straddling a cut are found exactly once. The chunk results are then merged in
+ * order without rescanning: when the last match of one chunk overlaps the start of the next,
+ * only the next chunk's first few matches are rechecked from the true resume point until they
+ * line up with the chunk's own scan again, which for any needle that cannot overlap itself
+ * happens at once. Counts, split fields and replaced output all match the single-threaded
+ * functions byte for byte; the split and replace outputs are written in a second parallel pass
+ * into storage sized exactly from the merged match counts.
+ *
+ * Inputs shorter than the pool's `parallel_min` (`STRSAFE_PARALLEL_MIN` by default), a `NULL`
+ * pool, or a pool of one thread run the single-threaded code instead.
+ *
+ */
+
+#ifndef SAFE_STR_PARALLEL_H
+#define SAFE_STR_PARALLEL_H
+
+#include "StrSafe.h"
+#include <limits.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#ifndef STRSAFE_PARALLEL_MIN
+#define STRSAFE_PARALLEL_MIN (1u << 20)     /**< Default input size below which the parallel functions stay single-threaded. */
+#endif
+
+#ifndef STRSAFE_PARALLEL_CHUNK
+#define STRSAFE_PARALLEL_CHUNK (256u << 10) /**< Smallest chunk handed to one task. */
+#endif
+
+#ifndef STRSAFE_PARALLEL_SYNC
+#define STRSAFE_PARALLEL_SYNC 16            /**< Matches rechecked at a chunk start before falling back to rescanning it. */
+#endif
+
+/** @brief Task run by `strsafe_thread_pool_run` for each index. */
+typedef void (*strsafe_task_fn)(void* ctx, size_t index);
+
+/**
+ * @struct StrSafe_thread_pool
+ * @brief Fixed set of worker threads that run batches of indexed tasks.
+ *
+ * Only one thread may call `strsafe_thread_pool_run` on a pool at a time.
+ */
+typedef struct {
+#ifdef _WIN32
+	HANDLE* threads;               /**< Worker threads. */
+	CRITICAL_SECTION lock;         /**< Protects the fields below. */
+	CONDITION_VARIABLE work;       /**< Signalled when tasks are posted or the pool stops. */
+	CONDITION_VARIABLE done;       /**< Signalled when the last task of a batch finishes. */
+#else
+	pthread_t* threads;            /**< Worker threads. */
+	pthread_mutex_t lock;          /**< Protects the fields below. */
+	pthread_cond_t work;           /**< Signalled when tasks are posted or the pool stops. */
+	pthread_cond_t done;           /**< Signalled when the last task of a batch finishes. */
+#endif
+	size_t thread_count;           /**< Number of worker threads. */
+	strsafe_task_fn fn;            /**< Task of the current batch. */
+	void* ctx;                     /**< Argument of the current batch. */
+	size_t next;                   /**< Next task index to hand out. */
+	size_t count;                  /**< Number of tasks in the current batch. */
+	size_t remaining;              /**< Tasks of the current batch not finished yet. */
+	bool stop;                     /**< Workers exit when set. */
+	size_t parallel_min;           /**< Inputs shorter than this run single-threaded; tunable. */
+} StrSafe_thread_pool;
+
+/**
+ * @brief Returns the number of online processors.
+ * @return The processor count, at least 1.
+ */
+static inline size_t strsafe_cpu_count(void) {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (size_t)n : 1;
+#endif
+}
+
+/** @brief Takes the pool lock. */
+static inline void strsafe_thread_pool_lock(StrSafe_thread_pool* pool) {
+#ifdef _WIN32
+	EnterCriticalSection(&pool->lock);
+#else
+	pthread_mutex_lock(&pool->lock);
+#endif
+}
+
+/** @brief Releases the pool lock. */
+static inline void strsafe_thread_pool_unlock(StrSafe_thread_pool* pool) {
+#ifdef _WIN32
+	LeaveCriticalSection(&pool->lock);
+#else
+	pthread_mutex_unlock(&pool->lock);
+#endif
+}
+
+/**
+ * @brief Runs tasks of the current batch until none are left; called with the lock held.
+ * @param pool The pool.
+ */
+static inline void strsafe_thread_pool_drain(StrSafe_thread_pool* pool) {
+	while (pool->next < pool->count) {
+		size_t index = pool->next++;
+		strsafe_task_fn fn = pool->fn;
+		void* ctx = pool->ctx;
+		strsafe_thread_pool_unlock(pool);
+		fn(ctx, index);
+		strsafe_thread_pool_lock(pool);
+		if (--pool->remaining == 0) {
+#ifdef _WIN32
+			WakeConditionVariable(&pool->done);
+#else
+			pthread_cond_signal(&pool->done);
+#endif
+		}
+	}
+}
+
+/** @brief Body of each worker thread. */
+#ifdef _WIN32
+static inline DWORD WINAPI strsafe_thread_pool_worker(LPVOID arg) {
+#else
+static inline void* strsafe_thread_pool_worker(void* arg) {
+#endif
+	StrSafe_thread_pool* pool = (StrSafe_thread_pool*)arg;
+	strsafe_thread_pool_lock(pool);
+	for (;;) {
+		while (!pool->stop && pool->next >= pool->count) {
+#ifdef _WIN32
+			SleepConditionVariableCS(&pool->work, &pool->lock, INFINITE);
+#else
+			pthread_cond_wait(&pool->work, &pool->lock);
+#endif
+		}
+		if (pool->stop) break;
+		strsafe_thread_pool_drain(pool);
+	}
+	strsafe_thread_pool_unlock(pool);
+#ifdef STRSAFE_POOL
+	// hand the blocks this thread cached to the global list before its cache goes away
+	strsafe_pool_flush();
+#endif
+#ifdef _WIN32
+	return 0;
+#else
+	return NULL;
+#endif
+}
+
+/**
+ * @brief Frees a pool, joining its workers.
+ * @param pool Pool to free; no batch may be running.
+ */
+static inline void strsafe_thread_pool_free(StrSafe_thread_pool* pool) {
+	strsafe_thread_pool_lock(pool);
+	pool->stop = true;
+#ifdef _WIN32
+	WakeAllConditionVariable(&pool->work);
+#else
+	pthread_cond_broadcast(&pool->work);
+#endif
+	strsafe_thread_pool_unlock(pool);
+
+	for (size_t i = 0; i < pool->thread_count; ++i) {
+#ifdef _WIN32
+		WaitForSingleObject(pool->threads[i], INFINITE);
+		CloseHandle(pool->threads[i]);
+#else
+		pthread_join(pool->threads[i], NULL);
+#endif
+	}
+#ifdef _WIN32
+	DeleteCriticalSection(&pool->lock);
+#else
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->work);
+	pthread_cond_destroy(&pool->done);
+#endif
+	STRSAFE_FREE(pool->threads);
+	pool->threads = NULL;
+	pool->thread_count = 0;
+}
+
+/**
+ * @brief Starts a pool of worker threads.
+ *
+ * The calling thread also runs tasks, so a pool of `n - 1` workers keeps `n` cores busy.
+ *
+ * @param pool Pool to initialize; must not be moved while in use.
+ * @param thread_count Number of worker threads, or 0 for one fewer than `strsafe_cpu_count`.
+ * @return `true` if successful, `false` if the threads or their synchronization objects could
+ *         not be created; the pool then holds nothing and must not be used or freed.
+ */
+static inline bool strsafe_thread_pool_init(StrSafe_thread_pool* pool, size_t thread_count) {
+	memset(pool, 0, sizeof(*pool));
+	pool->parallel_min = STRSAFE_PARALLEL_MIN;
+	if (thread_count == 0) thread_count = strsafe_cpu_count() - 1;
+
+#ifdef _WIN32
+	InitializeCriticalSection(&pool->lock);
+	InitializeConditionVariable(&pool->work);
+	InitializeConditionVariable(&pool->done);
+#else
+	if (pthread_mutex_init(&pool->lock, NULL) != 0) return false;
+	if (pthread_cond_init(&pool->work, NULL) != 0) {
+		pthread_mutex_destroy(&pool->lock);
+		return false;
+	}
+	if (pthread_cond_init(&pool->done, NULL) != 0) {
+		pthread_cond_destroy(&pool->work);
+		pthread_mutex_destroy(&pool->lock);
+		return false;
+	}
+#endif
+	if (thread_count == 0) return true;
+
+	pool->threads = STRSAFE_MALLOC(sizeof(*pool->threads) * thread_count);
+	bool ok = pool->threads != NULL;
+	for (; ok && pool->thread_count < thread_count; ++pool->thread_count) {
+#ifdef _WIN32
+		HANDLE thread = CreateThread(NULL, 0, strsafe_thread_pool_worker, pool, 0, NULL);
+		ok = thread != NULL;
+		if (!ok) break;
+		pool->threads[pool->thread_count] = thread;
+#else
+		ok = pthread_create(&pool->threads[pool->thread_count], NULL, strsafe_thread_pool_worker, pool) == 0;
+		if (!ok) break;
+#endif
+	}
+	if (!ok) {
+		// joins the workers started so far and releases the synchronization objects
+		strsafe_thread_pool_free(pool);
+	}
+	return ok;
+}
+
+/**
+ * @brief Runs `fn(ctx, i)` for every `i` in `[0, count)` on the pool and waits for all of them.
+ * @param pool The pool.
+ * @param fn Task to run; invocations may run concurrently and in any order.
+ * @param ctx Argument passed to every invocation.
+ * @param count Number of tasks.
+ */
+static inline void strsafe_thread_pool_run(StrSafe_thread_pool* pool, strsafe_task_fn fn, void* ctx, size_t count) {
+	if (count == 0) return;
+	strsafe_thread_pool_lock(pool);
+	pool->fn = fn;
+	pool->ctx = ctx;
+	pool->next = 0;
+	pool->count = count;
+	pool->remaining = count;
+#ifdef _WIN32
+	WakeAllConditionVariable(&pool->work);
+#else
+	pthread_cond_broadcast(&pool->work);
+#endif
+	strsafe_thread_pool_drain(pool);
+	while (pool->remaining > 0) {
+#ifdef _WIN32
+		SleepConditionVariableCS(&pool->done, &pool->lock, INFINITE);
+#else
+		pthread_cond_wait(&pool->done, &pool->lock);
+#endif
+	}
+	strsafe_thread_pool_unlock(pool);
+}
+
+/**
+ * @struct StrSafe_parallel_chunk
+ * @brief Matches found in one chunk of a parallel scan.
+ *
+ * After merging, the chunk's matches in text order are `extra[0 .. extra_len)` followed by
+ * `pos[skip .. count)`.
+ */
+typedef struct {
+	size_t begin;                          /**< First match start owned by the chunk. */
+	size_t end;                            /**< One past the last match start owned by the chunk. */
+	size_t count;                          /**< Matches found scanning from `begin`. */
+	size_t last;                           /**< Start of the last of those matches. */
+	size_t* pos;                           /**< Match starts: all of them when recording, else the first few. */
+	size_t pos_cap;                        /**< Entries `pos` can hold. */
+	size_t pos_stack[STRSAFE_PARALLEL_SYNC]; /**< Storage of `pos` when not recording. */
+	size_t skip;                           /**< Leading matches of `pos` invalidated by the previous chunk. */
+	size_t extra[STRSAFE_PARALLEL_SYNC];   /**< Matches found from the true resume point before realigning. */
+	size_t extra_len;                      /**< Entries of `extra` in use. */
+	size_t carry;                          /**< End of the last match before this chunk, or 0. */
+	size_t match_base;                     /**< Matches in all earlier chunks. */
+	bool failed;                           /**< Recording a match, or copying a field of a split, failed to allocate. */
+} StrSafe_parallel_chunk;
+
+/**
+ * @struct StrSafe_parallel_job
+ * @brief State shared by the tasks of one parallel operation.
+ */
+typedef struct {
+	const char* data;                  /**< Haystack bytes. */
+	size_t len;                        /**< Haystack length. */
+	const StrSafe_needle* needle;      /**< Pattern searched for. */
+	bool record;                       /**< Keep every match position. */
+	StrSafe_parallel_chunk* chunks;    /**< One entry per chunk. */
+	size_t chunk_count;                /**< Number of chunks. */
+	size_t matches;                    /**< Total matches after merging. */
+	size_t carry;                      /**< End of the last match after merging, or 0. */
+	const char* new_str;               /**< Replacement bytes, for replace. */
+	size_t new_len;                    /**< Replacement length, for replace. */
+	char* out;                         /**< Output buffer, for replace. */
+	StrSafe* fields;                   /**< Output strings, for split. */
+	StrSafe_view* views;               /**< Output views, for split into views. */
+} StrSafe_parallel_job;
+
+/**
+ * @brief Scans `[from, end)` of a chunk, replacing its recorded matches.
+ * @param job The operation.
+ * @param chunk The chunk.
+ * @param from Position to resume searching at.
+ */
+static inline void strsafe_parallel_scan(StrSafe_parallel_job* job, StrSafe_parallel_chunk* chunk, size_t from) {
+	size_t m = job->needle->len;
+	size_t limit = chunk->end + m - 1 < job->len ? chunk->end + m - 1 : job->len;
+	chunk->count = 0;
+	chunk->skip = 0;
+	chunk->extra_len = 0;
+
+	size_t p = from;
+	while (p < chunk->end) {
+		const char* found = strsafe_needle_search(job->data + p, limit - p, job->needle);
+		if (!found) break;
+		size_t at = found - job->data;
+		if (chunk->count == chunk->pos_cap) {
+			if (job->record) {
+				size_t cap = chunk->pos_cap ? chunk->pos_cap * 2 : 64;
+				size_t* grown = STRSAFE_REALLOC(chunk->pos, sizeof(size_t) * cap);
+				if (!grown) {
+					chunk->failed = true;
+					return;
+				}
+				chunk->pos = grown;
+				chunk->pos_cap = cap;
+			}
+		}
+		if (chunk->count < chunk->pos_cap) chunk->pos[chunk->count] = at;
+		chunk->count++;
+		chunk->last = at;
+		p = at + m;
+	}
+}
+
+/** @brief Task of the first pass: scans one chunk from its own start. */
+static inline void strsafe_parallel_scan_task(void* ctx, size_t index) {
+	StrSafe_parallel_job* job = (StrSafe_parallel_job*)ctx;
+	StrSafe_parallel_chunk* chunk = &job->chunks[index];
+	strsafe_parallel_scan(job, chunk, chunk->begin);
+}
+
+/**
+ * @brief Corrects a chunk whose scan started inside a match of the previous chunk.
+ *
+ * Searches from `carry` and stops as soon as a match coincides with one of the chunk's own,
+ * since both scans agree from there on; matches before that are kept in `extra`. If that
+ * does not happen within the recorded matches or `STRSAFE_PARALLEL_SYNC` steps, the chunk
+ * is rescanned from `carry`.
+ *
+ * @param job The operation.
+ * @param chunk The chunk.
+ * @param carry End of the previous match, greater than `chunk->begin`.
+ */
+static inline void strsafe_parallel_resync(StrSafe_parallel_job* job, StrSafe_parallel_chunk* chunk, size_t carry) {
+	size_t m = job->needle->len;
+	size_t limit = chunk->end + m - 1 < job->len ? chunk->end + m - 1 : job->len;
+	size_t known = chunk->count < chunk->pos_cap ? chunk->count : chunk->pos_cap;
+	size_t j = 0;
+	size_t p = carry;
+	while (chunk->extra_len < STRSAFE_PARALLEL_SYNC) {
+		const char* found = p < chunk->end ? strsafe_needle_search(job->data + p, limit - p, job->needle) : NULL;
+		if (!found) {
+			// no match left in the chunk: only the ones in `extra` survive
+			chunk->skip = chunk->count;
+			return;
+		}
+		size_t at = found - job->data;
+		while (j < known && chunk->pos[j] < at) ++j;
+		if (j < known && chunk->pos[j] == at) {
+			chunk->skip = j;
+			return;
+		}
+		if (j == known && known < chunk->count) break;
+		chunk->extra[chunk->extra_len++] = at;
+		p = at + m;
+	}
+	strsafe_parallel_scan(job, chunk, carry);
+}
+
+/**
+ * @brief Returns the `k`-th match of a merged chunk.
+ * @param chunk The chunk.
+ * @param k Index among the chunk's matches.
+ * @return Start of the match.
+ */
+static inline size_t strsafe_parallel_match(const StrSafe_parallel_chunk* chunk, size_t k) {
+	return k < chunk->extra_len ? chunk->extra[k] : chunk->pos[chunk->skip + k - chunk->extra_len];
+}
+
+/**
+ * @brief Number of matches of a merged chunk.
+ * @param chunk The chunk.
+ * @return Matches the chunk contributes to the result.
+ */
+static inline size_t strsafe_parallel_match_count(const StrSafe_parallel_chunk* chunk) {
+	return chunk->extra_len + chunk->count - chunk->skip;
+}
+
+/**
+ * @brief Releases the chunk table of a job.
+ * @param job The operation.
+ */
+static inline void strsafe_parallel_job_free(StrSafe_parallel_job* job) {
+	if (!job->chunks) return;
+	for (size_t i = 0; i < job->chunk_count; ++i) {
+		if (job->chunks[i].pos != job->chunks[i].pos_stack) STRSAFE_FREE(job->chunks[i].pos);
+	}
+	STRSAFE_FREE(job->chunks);
+	job->chunks = NULL;
+}
+
+/**
+ * @brief Cuts the haystack into chunks, scans them on the pool and merges the results.
+ *
+ * With a `NULL` pool the whole haystack is a single chunk scanned by the caller.
+ *
+ * @param pool Pool to run on, or `NULL`.
+ * @param job Operation with `data`, `len`, `needle` and `record` set; receives the chunks.
+ * @return `true` if successful, `false` on allocation failure (the job holds no chunks).
+ */
+static inline bool strsafe_parallel_find_all(StrSafe_thread_pool* pool, StrSafe_parallel_job* job) {
+	size_t chunk_count = 1;
+	if (pool) {
+		size_t workers = pool->thread_count + 1;
+		chunk_count = job->len / STRSAFE_PARALLEL_CHUNK;
+		if (chunk_count > workers * 4) chunk_count = workers * 4;
+		if (chunk_count < workers) chunk_count = workers;
+	}
+	job->chunks = STRSAFE_MALLOC(sizeof(StrSafe_parallel_chunk) * chunk_count);
+	if (!job->chunks) return false;
+	job->chunk_count = chunk_count;
+
+	size_t step = job->len / chunk_count;
+	for (size_t i = 0; i < chunk_count; ++i) {
+		StrSafe_parallel_chunk* chunk = &job->chunks[i];
+		memset(chunk, 0, sizeof(*chunk));
+		chunk->begin = i * step;
+		chunk->end = i + 1 == chunk_count ? job->len : (i + 1) * step;
+		if (!job->record) {
+			chunk->pos = chunk->pos_stack;
+			chunk->pos_cap = STRSAFE_PARALLEL_SYNC;
+		}
+	}
+
+	if (pool) {
+		strsafe_thread_pool_run(pool, strsafe_parallel_scan_task, job, chunk_count);
+	}
+	else {
+		strsafe_parallel_scan_task(job, 0);
+	}
+
+	size_t m = job->needle->len;
+	size_t carry = 0;
+	size_t matches = 0;
+	for (size_t i = 0; i < chunk_count; ++i) {
+		StrSafe_parallel_chunk* chunk = &job->chunks[i];
+		if (carry > chunk->begin && chunk->count > 0 && !chunk->failed) {
+			strsafe_parallel_resync(job, chunk, carry);
+		}
+		if (chunk->failed) {
+			strsafe_parallel_job_free(job);
+			return false;
+		}
+		chunk->carry = carry;
+		chunk->match_base = matches;
+		size_t n = strsafe_parallel_match_count(chunk);
+		if (n > 0) {
+			carry = (chunk->count > chunk->skip ? chunk->last : chunk->extra[chunk->extra_len - 1]) + m;
+		}
+		matches += n;
+	}
+	job->matches = matches;
+	job->carry = carry;
+	return true;
+}
+
+/**
+ * @brief Tells whether an input is large enough to spread over the pool.
+ * @param pool Pool, or `NULL`.
+ * @param len Input length.
+ * @param needle The pattern.
+ * @return `true` to run in parallel.
+ */
+static inline bool strsafe_parallel_worthwhile(const StrSafe_thread_pool* pool, size_t len, const StrSafe_needle* needle) {
+	return pool && pool->thread_count > 0 && needle->len > 0 && len >= pool->parallel_min && len >= 2 * STRSAFE_PARALLEL_CHUNK;
+}
+
+/**
+ * @brief Counts non-overlapping occurrences of a needle, as `strsafe_needle_count` does.
+ * @param pool Pool to run on, or `NULL` for the calling thread only.
+ * @param haystack Bytes to search, such as a mapped file.
+ * @param needle Prepared needle; an empty needle counts 0.
+ * @return Number of occurrences, or `SIZE_MAX` on allocation failure.
+ */
+static inline size_t strsafe_parallel_count(StrSafe_thread_pool* pool, StrSafe_view haystack, const StrSafe_needle* needle) {
+	if (needle->len == 0) return 0;
+	StrSafe_parallel_job job;
+	memset(&job, 0, sizeof(job));
+	job.data = haystack.ptr;
+	job.len = haystack.len;
+	job.needle = needle;
+	if (!strsafe_parallel_find_all(strsafe_parallel_worthwhile(pool, haystack.len, needle) ? pool : NULL, &job)) return SIZE_MAX;
+	strsafe_parallel_job_free(&job);
+	return job.matches;
+}
+
+/** @brief Task of the split-into-views pass. */
+static inline void strsafe_parallel_split_view_task(void* ctx, size_t index) {
+	StrSafe_parallel_job* job = (StrSafe_parallel_job*)ctx;
+	const StrSafe_parallel_chunk* chunk = &job->chunks[index];
+	size_t start = chunk->carry;
+	size_t n = strsafe_parallel_match_count(chunk);
+	for (size_t k = 0; k < n; ++k) {
+		size_t at = strsafe_parallel_match(chunk, k);
+		job->views[chunk->match_base + k] = strsafe_view_make(job->data + start, at - start);
+		start = at + job->needle->len;
+	}
+}
+
+/**
+ * @brief Splits a view on a needle into views of it, as `strsafe_needle_split_view` does.
+ * @param pool Pool to run on, or `NULL` for the calling thread only.
+ * @param src Bytes to split.
+ * @param delim Prepared delimiter.
+ * @param out Receives the fields; its previous contents are replaced and its storage reused.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_parallel_split_view(StrSafe_thread_pool* pool, StrSafe_view src, const StrSafe_needle* delim, StrSafe_view_array* out) {
+	if (!strsafe_parallel_worthwhile(pool, src.len, delim)) return strsafe_needle_split_view(src, delim, out);
+
+	StrSafe_parallel_job job;
+	memset(&job, 0, sizeof(job));
+	job.data = src.ptr;
+	job.len = src.len;
+	job.needle = delim;
+	job.record = true;
+	if (!strsafe_parallel_find_all(pool, &job)) return false;
+
+	size_t total = job.matches + 1;
+	if (out->cap < total) {
+		StrSafe_view* grown = STRSAFE_REALLOC(out->views, sizeof(StrSafe_view) * total);
+		if (!grown) {
+			strsafe_parallel_job_free(&job);
+			return false;
+		}
+		out->views = grown;
+		out->cap = total;
+	}
+	job.views = out->views;
+	strsafe_thread_pool_run(pool, strsafe_parallel_split_view_task, &job, job.chunk_count);
+	out->views[job.matches] = strsafe_view_make(src.ptr + job.carry, src.len - job.carry);
+	out->count = total;
+	strsafe_parallel_job_free(&job);
+	return true;
+}
+
+/** @brief Task of the split-into-strings pass; a failed copy is flagged on the task's own chunk. */
+static inline void strsafe_parallel_split_task(void* ctx, size_t index) {
+	StrSafe_parallel_job* job = (StrSafe_parallel_job*)ctx;
+	StrSafe_parallel_chunk* chunk = &job->chunks[index];
+	size_t start = chunk->carry;
+	size_t n = strsafe_parallel_match_count(chunk);
+	for (size_t k = 0; k < n; ++k) {
+		size_t at = strsafe_parallel_match(chunk, k);
+		if (!strsafe_init_from(&job->fields[chunk->match_base + k], job->data + start, at - start)) {
+			chunk->failed = true;
+		}
+		start = at + job->needle->len;
+	}
+}
+
+/**
+ * @brief Splits a string on a needle into new strings, as `strsafe_needle_split` does.
+ *
+ * The fields are copied into their own strings in parallel as well.
+ *
+ * @param pool Pool to run on, or `NULL` for the calling thread only.
+ * @param src String to split.
+ * @param delim Prepared delimiter.
+ * @return The fields, or an empty array on allocation failure.
+ */
+static inline StrSafe_array strsafe_parallel_split(StrSafe_thread_pool* pool, const StrSafe* src, const StrSafe_needle* delim) {
+	StrSafe_array result;
+	strsafe_array_init(&result);
+	size_t len = strsafe_length(src);
+	if (!strsafe_parallel_worthwhile(pool, len, delim)) return strsafe_needle_split(src, delim);
+
+	StrSafe_parallel_job job;
+	memset(&job, 0, sizeof(job));
+	job.data = strsafe_cstr(src);
+	job.len = len;
+	job.needle = delim;
+	job.record = true;
+	if (!strsafe_parallel_find_all(pool, &job)) return result;
+
+	if (job.matches >= (size_t)INT_MAX || !strsafe_array_reserve(&result, (int)(job.matches + 1))) {
+		strsafe_parallel_job_free(&job);
+		return result;
+	}
+	result.array_size = (int)(job.matches + 1);
+	job.fields = result.arr;
+	strsafe_thread_pool_run(pool, strsafe_parallel_split_task, &job, job.chunk_count);
+	bool failed = !strsafe_init_from(&result.arr[job.matches], job.data + job.carry, len - job.carry);
+	for (size_t i = 0; i < job.chunk_count; ++i) {
+		failed = failed || job.chunks[i].failed;
+	}
+	strsafe_parallel_job_free(&job);
+
+	if (failed) {
+		strsafe_array_free(&result);
+		strsafe_array_init(&result);
+	}
+	return result;
+}
+
+/** @brief Task of the replace pass: writes one chunk's share of the output. */
+static inline void strsafe_parallel_replace_task(void* ctx, size_t index) {
+	StrSafe_parallel_job* job = (StrSafe_parallel_job*)ctx;
+	const StrSafe_parallel_chunk* chunk = &job->chunks[index];
+	size_t m = job->needle->len;
+	size_t from = chunk->begin > chunk->carry ? chunk->begin : chunk->carry;
+	size_t to = job->len;
+	if (index + 1 < job->chunk_count) {
+		const StrSafe_parallel_chunk* next = &job->chunks[index + 1];
+		to = next->begin > next->carry ? next->begin : next->carry;
+	}
+
+	char* out = job->out + from - chunk->match_base * m + chunk->match_base * job->new_len;
+	size_t n = strsafe_parallel_match_count(chunk);
+	for (size_t k = 0; k < n; ++k) {
+		size_t at = strsafe_parallel_match(chunk, k);
+		memcpy(out, job->data + from, at - from);
+		out += at - from;
+		memcpy(out, job->new_str, job->new_len);
+		out += job->new_len;
+		from = at + m;
+	}
+	if (to > from) memcpy(out, job->data + from, to - from);
+}
+
+/**
+ * @brief Replaces all occurrences of a needle, as `strsafe_needle_replace_all` does.
+ *
+ * The result is written into one new buffer of exactly the final size, each chunk filling
+ * its own region of it.
+ *
+ * @param pool Pool to run on, or `NULL` for the calling thread only.
+ * @param dst The target string to modify.
+ * @param old_str Prepared needle for the bytes to be replaced; an empty needle leaves `dst` unchanged.
+ * @param new_str The replacement bytes; neither pattern may point into `dst`.
+ * @param new_len Number of bytes in `new_str`.
+ * @return Pointer to `dst`, or `NULL` on allocation failure (`dst` is unchanged).
+ */
+static inline StrSafe* strsafe_parallel_replace_all(StrSafe_thread_pool* pool, StrSafe* dst, const StrSafe_needle* old_str, const char* new_str, size_t new_len) {
+	size_t len = strsafe_length(dst);
+	if (!strsafe_parallel_worthwhile(pool, len, old_str)) return strsafe_needle_replace_all(dst, old_str, new_str, new_len);
+
+	StrSafe_parallel_job job;
+	memset(&job, 0, sizeof(job));
+	job.data = strsafe_cstr(dst);
+	job.len = len;
+	job.needle = old_str;
+	job.record = true;
+	job.new_str = new_str;
+	job.new_len = new_len;
+	if (!strsafe_parallel_find_all(pool, &job)) return NULL;
+	if (job.matches == 0) {
+		strsafe_parallel_job_free(&job);
+		return dst;
+	}
+
+	size_t final_len = len - job.matches * old_str->len + job.matches * new_len;
+	StrSafe result;
+	strsafe_init(&result);
+	if (!strsafe_reserve(&result, final_len + 1)) {
+		strsafe_parallel_job_free(&job);
+		return NULL;
+	}
+	job.out = strsafe_data(&result);
+	strsafe_thread_pool_run(pool, strsafe_parallel_replace_task, &job, job.chunk_count);
+	job.out[final_len] = '\0';
+	strsafe_set_length(&result, final_len);
+	strsafe_parallel_job_free(&job);
+
+	strsafe_move(dst, &result);
+	return dst;
+}
+
+/**
+ * @struct StrSafe_parallel_batch
+ * @brief Shared state of one batch operation over the rows of an array.
+ *
+ * The rows are cut into `task_count` contiguous ranges; each task writes only its own rows
+ * and its own slot of `results`.
+ */
+typedef struct {
+	StrSafe_array* arr;            /**< The rows. */
+	const StrSafe_needle* needle;  /**< The pattern. */
+	const char* new_str;           /**< Replacement bytes (replace only). */
+	size_t new_len;                /**< Length of `new_str`. */
+	ssize_t* positions;            /**< Per-row first match, or `NULL` (find only). */
+	size_t* counts;                /**< Per-row match count, or `NULL` (count only). */
+	bool* keep;                    /**< Per-row keep flags (filter only). */
+	bool keep_matching;            /**< Keep rows that contain the needle (filter only). */
+	size_t task_count;             /**< Number of row ranges. */
+	size_t* results;               /**< Per-task found rows, match total, or failure flag. */
+} StrSafe_parallel_batch;
+
+/**
+ * @brief Tells whether a batch over an array is large enough to spread over the pool.
+ * @param pool Pool, or `NULL`.
+ * @param arr The rows.
+ * @param needle The pattern.
+ * @return `true` to run in parallel.
+ */
+static inline bool strsafe_parallel_batch_worthwhile(const StrSafe_thread_pool* pool, const StrSafe_array* arr, const StrSafe_needle* needle) {
+	if (!pool || pool->thread_count == 0 || needle->len == 0 || arr->array_size < 2) return false;
+	size_t total = 0;
+	for (int i = 0; i < arr->array_size && total < pool->parallel_min; ++i) {
+		total += strsafe_length(&arr->arr[i]);
+	}
+	return total >= pool->parallel_min;
+}
+
+/**
+ * @brief Prepares a batch and its per-task results.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_parallel_batch_init(StrSafe_parallel_batch* batch, const StrSafe_thread_pool* pool, StrSafe_array* arr, const StrSafe_needle* needle) {
+	memset(batch, 0, sizeof(*batch));
+	batch->arr = arr;
+	batch->needle = needle;
+	// a few ranges per thread so uneven rows still balance
+	batch->task_count = (pool->thread_count + 1) * 4;
+	if (batch->task_count > (size_t)arr->array_size) batch->task_count = (size_t)arr->array_size;
+	batch->results = STRSAFE_MALLOC(batch->task_count * sizeof(size_t));
+	if (!batch->results) return false;
+	memset(batch->results, 0, batch->task_count * sizeof(size_t));
+	return true;
+}
+
+/**
+ * @brief Rows `[*begin, *end)` of one batch task.
+ */
+static inline void strsafe_parallel_batch_rows(const StrSafe_parallel_batch* batch, size_t index, int* begin, int* end) {
+	size_t rows = (size_t)batch->arr->array_size;
+	*begin = (int)(rows * index / batch->task_count);
+	*end = (int)(rows * (index + 1) / batch->task_count);
+}
+
+/**
+ * @brief Sums the per-task results of a batch and frees them.
+ */
+static inline size_t strsafe_parallel_batch_finish(StrSafe_parallel_batch* batch) {
+	size_t total = 0;
+	for (size_t t = 0; t < batch->task_count; ++t) total += batch->results[t];
+	STRSAFE_FREE(batch->results);
+	batch->results = NULL;
+	return total;
+}
+
+/** @brief Task of the batch replace: one row range with its own scratch buffer. */
+static inline void strsafe_parallel_array_replace_task(void* ctx, size_t index) {
+	StrSafe_parallel_batch* batch = (StrSafe_parallel_batch*)ctx;
+	int begin, end;
+	strsafe_parallel_batch_rows(batch, index, &begin, &end);
+	StrSafe scratch;
+	strsafe_init(&scratch);
+	for (int i = begin; i < end; ++i) {
+		if (!strsafe_needle_replace_all_scratch(&batch->arr->arr[i], batch->needle, batch->new_str, batch->new_len, &scratch)) {
+			batch->results[index] = 1;
+			break;
+		}
+	}
+	strsafe_free(&scratch);
+}
+
+/**
+ * @brief Replaces all occurrences of a needle in every row, as `strsafe_array_replace_all` does.
+ *
+ * Rows are spread over the pool in contiguous ranges; shared rows are unshared by the task
+ * that rewrites them, so rows sharing one buffer are safe to process together.
+ *
+ * @param pool Pool to run on, or `NULL` for the calling thread only.
+ * @param arr The strings to modify.
+ * @param old_str Prepared needle for the bytes to be replaced.
+ * @param new_str The replacement bytes; must not point into `arr`.
+ * @param new_len Number of bytes in `new_str`.
+ * @return `true` if successful, `false` on allocation failure (some rows may already be rewritten).
+ */
+static inline bool strsafe_parallel_array_replace_all(StrSafe_thread_pool* pool, StrSafe_array* arr, const StrSafe_needle* old_str, const char* new_str, size_t new_len) {
+	StrSafe_parallel_batch batch;
+	if (!strsafe_parallel_batch_worthwhile(pool, arr, old_str) || !strsafe_parallel_batch_init(&batch, pool, arr, old_str)) {
+		return strsafe_array_replace_all(arr, old_str, new_str, new_len);
+	}
+	batch.new_str = new_str;
+	batch.new_len = new_len;
+	strsafe_thread_pool_run(pool, strsafe_parallel_array_replace_task, &batch, batch.task_count);
+	return strsafe_parallel_batch_finish(&batch) == 0;
+}
+
+/** @brief Task of the batch find. */
+static inline void strsafe_parallel_array_find_task(void* ctx, size_t index) {
+	StrSafe_parallel_batch* batch = (StrSafe_parallel_batch*)ctx;
+	int begin, end;
+	strsafe_parallel_batch_rows(batch, index, &begin, &end);
+	size_t found = 0;
+	for (int i = begin; i < end; ++i) {
+		ssize_t pos = strsafe_needle_find(&batch->arr->arr[i], batch->needle);
+		if (batch->positions) batch->positions[i] = pos;
+		found += pos >= 0;
+	}
+	batch->results[index] = found;
+}
+
+/**
+ * @brief Finds the first occurrence of a needle in every row, as `strsafe_array_find` does.
+ * @param pool Pool to run on, or `NULL` for the calling thread only.
+ * @param arr The strings to search.
+ * @param needle Prepared needle.
+ * @param positions Receives `array_size` positions, -1 where there is no match; may be `NULL`.
+ * @return Number of strings containing the needle.
+ */
+static inline size_t strsafe_parallel_array_find(StrSafe_thread_pool* pool, const StrSafe_array* arr, const StrSafe_needle* needle, ssize_t* positions) {
+	StrSafe_parallel_batch batch;
+	if (!strsafe_parallel_batch_worthwhile(pool, arr, needle) || !strsafe_parallel_batch_init(&batch, pool, (StrSafe_array*)arr, needle)) {
+		return strsafe_array_find(arr, needle, positions);
+	}
+	batch.positions = positions;
+	strsafe_thread_pool_run(pool, strsafe_parallel_array_find_task, &batch, batch.task_count);
+	return strsafe_parallel_batch_finish(&batch);
+}
+
+/** @brief Task of the batch count. */
+static inline void strsafe_parallel_array_count_task(void* ctx, size_t index) {
+	StrSafe_parallel_batch* batch = (StrSafe_parallel_batch*)ctx;
+	int begin, end;
+	strsafe_parallel_batch_rows(batch, index, &begin, &end);
+	size_t total = 0;
+	for (int i = begin; i < end; ++i) {
+		size_t count = strsafe_needle_count(&batch->arr->arr[i], batch->needle);
+		if (batch->counts) batch->counts[i] = count;
+		total += count;
+	}
+	batch->results[index] = total;
+}
+
+/**
+ * @brief Counts the occurrences of a needle in every row, as `strsafe_array_count` does.
+ * @param pool Pool to run on, or `NULL` for the calling thread only.
+ * @param arr The strings to search.
+ * @param needle Prepared needle.
+ * @param counts Receives `array_size` per-string counts; may be `NULL`.
+ * @return Total number of occurrences.
+ */
+static inline size_t strsafe_parallel_array_count(StrSafe_thread_pool* pool, const StrSafe_array* arr, const StrSafe_needle* needle, size_t* counts) {
+	StrSafe_parallel_batch batch;
+	if (!strsafe_parallel_batch_worthwhile(pool, arr, needle) || !strsafe_parallel_batch_init(&batch, pool, (StrSafe_array*)arr, needle)) {
+		return strsafe_array_count(arr, needle, counts);
+	}
+	batch.counts = counts;
+	strsafe_thread_pool_run(pool, strsafe_parallel_array_count_task, &batch, batch.task_count);
+	return strsafe_parallel_batch_finish(&batch);
+}
+
+/** @brief Task of the batch filter: decides which rows of one range to keep. */
+static inline void strsafe_parallel_array_filter_task(void* ctx, size_t index) {
+	StrSafe_parallel_batch* batch = (StrSafe_parallel_batch*)ctx;
+	int begin, end;
+	strsafe_parallel_batch_rows(batch, index, &begin, &end);
+	for (int i = begin; i < end; ++i) {
+		batch->keep[i] = (strsafe_needle_find(&batch->arr->arr[i], batch->needle) >= 0) == batch->keep_matching;
+	}
+}
+
+/**
+ * @brief Drops the rows that do, or do not, contain a needle, as `strsafe_array_filter_ex` does.
+ *
+ * The rows are tested on the pool; moving the kept ones down is done afterwards on the
+ * calling thread.
+ *
+ * @param pool Pool to run on, or `NULL` for the calling thread only.
+ * @param arr The array to filter.
+ * @param needle Prepared needle.
+ * @param keep_matching `true` to keep the strings containing the needle, `false` to keep the others.
+ * @param allocator Allocator the strings came from, or `NULL` for the default heap.
+ * @return The new `array_size`.
+ */
+static inline int strsafe_parallel_array_filter_ex(StrSafe_thread_pool* pool, StrSafe_array* arr, const StrSafe_needle* needle, bool keep_matching, const StrSafe_allocator* allocator) {
+	StrSafe_parallel_batch batch;
+	if (!strsafe_parallel_batch_worthwhile(pool, arr, needle) || !strsafe_parallel_batch_init(&batch, pool, arr, needle)) {
+		return strsafe_array_filter_ex(arr, needle, keep_matching, allocator);
+	}
+	batch.keep = STRSAFE_MALLOC((size_t)arr->array_size * sizeof(bool));
+	if (!batch.keep) {
+		strsafe_parallel_batch_finish(&batch);
+		return strsafe_array_filter_ex(arr, needle, keep_matching, allocator);
+	}
+	batch.keep_matching = keep_matching;
+	strsafe_thread_pool_run(pool, strsafe_parallel_array_filter_task, &batch, batch.task_count);
+
+	int kept = 0;
+	for (int i = 0; i < arr->array_size; ++i) {
+		if (batch.keep[i]) {
+			arr->arr[kept++] = arr->arr[i];
+		}
+		else {
+			strsafe_free_ex(&arr->arr[i], allocator);
+		}
+	}
+	arr->array_size = kept;
+	STRSAFE_FREE(batch.keep);
+	strsafe_parallel_batch_finish(&batch);
+	return kept;
+}
+
+/**
+ * @brief Drops the rows that do, or do not, contain a needle, as `strsafe_array_filter` does.
+ * @param pool Pool to run on, or `NULL` for the calling thread only.
+ * @param arr The array to filter.
+ * @param needle Prepared needle.
+ * @param keep_matching `true` to keep the strings containing the needle, `false` to keep the others.
+ * @return The new `array_size`.
+ */
+static inline int strsafe_parallel_array_filter(StrSafe_thread_pool* pool, StrSafe_array* arr, const StrSafe_needle* needle, bool keep_matching) {
+	return strsafe_parallel_array_filter_ex(pool, arr, needle, keep_matching, NULL);
+}
+
+#endif // SAFE_STR_PARALLEL_H
@@ -0,0 +1,477 @@
+
+/**
+ * @file StrSafe_rope.h
+ * @brief Rope of `StrSafe` leaves for large buffers that see many small edits.
+ *
+ * A `StrSafe_rope` keeps its text in leaves of at most `STRSAFE_ROPE_LEAF` bytes arranged
+ * in a treap ordered by position, so insert, remove and replace touch O(log n) nodes
+ * instead of moving the whole tail. Edits that fit inside one leaf are done in place;
+ * others split the tree at the edit and merge the pieces back.
+ *
+ * Failed edits leave the rope unchanged: every allocation an edit needs is made before
+ * the tree is modified.
+ *
+ */
+
+#ifndef SAFE_STR_ROPE_H
+#define SAFE_STR_ROPE_H
+
+#include "StrSafe.h"
+
+#ifndef STRSAFE_ROPE_LEAF
+#define STRSAFE_ROPE_LEAF 1024   /**< Largest number of bytes kept in one leaf. */
+#endif
+
+/**
+ * @struct StrSafe_rope_node
+ * @brief One leaf of a rope and the root of its subtree.
+ */
+typedef struct StrSafe_rope_node {
+	struct StrSafe_rope_node* left;    /**< Text before this leaf. */
+	struct StrSafe_rope_node* right;   /**< Text after this leaf. */
+	StrSafe leaf;                      /**< Bytes of this node. */
+	size_t size;                       /**< Bytes in the whole subtree. */
+	uint32_t priority;                 /**< Heap key keeping the tree balanced. */
+} StrSafe_rope_node;
+
+/**
+ * @struct StrSafe_rope
+ * @brief Text stored as a balanced tree of leaves.
+ */
+typedef struct {
+	StrSafe_rope_node* root;    /**< Tree of leaves, or `NULL` when empty. */
+	StrSafe_rope_node* spare;   /**< Preallocated nodes for splitting leaves, chained by `right`. */
+	size_t spare_count;         /**< Number of nodes in `spare`. */
+	uint32_t seed;              /**< State of the priority generator. */
+} StrSafe_rope;
+
+/**
+ * @brief Bytes in a subtree; 0 for `NULL`.
+ * @param node Subtree root, may be `NULL`.
+ * @return Subtree size.
+ */
+static inline size_t strsafe_rope_node_size(const StrSafe_rope_node* node) {
+	return node ? node->size : 0;
+}
+
+/**
+ * @brief Recomputes `size` after the children or the leaf of `node` changed.
+ * @param node Node to update.
+ */
+static inline void strsafe_rope_node_update(StrSafe_rope_node* node) {
+	node->size = strsafe_rope_node_size(node->left) + strsafe_length(&node->leaf) + strsafe_rope_node_size(node->right);
+}
+
+/**
+ * @brief Draws the next node priority (xorshift32).
+ * @param rope Rope owning the generator state.
+ * @return Pseudo-random priority.
+ */
+static inline uint32_t strsafe_rope_priority(StrSafe_rope* rope) {
+	uint32_t x = rope->seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	rope->seed = x;
+	return x;
+}
+
+/**
+ * @brief Allocates a node holding `len` bytes of `text`, with room for `cap` bytes.
+ * @param rope Rope the node is for.
+ * @param text Leaf bytes.
+ * @param len Number of bytes in `text`, at most `cap`.
+ * @param cap Leaf capacity, not counting the null terminator.
+ * @return The node, or `NULL` on allocation failure.
+ */
+static inline StrSafe_rope_node* strsafe_rope_node_new(StrSafe_rope* rope, const char* text, size_t len, size_t cap) {
+	StrSafe_rope_node* node = STRSAFE_MALLOC(sizeof(StrSafe_rope_node));
+	if (!node) return NULL;
+	strsafe_init(&node->leaf);
+	if (!strsafe_reserve(&node->leaf, cap + 1)) {
+		STRSAFE_FREE(node);
+		return NULL;
+	}
+	strsafe_assign(&node->leaf, text, len);
+	node->left = NULL;
+	node->right = NULL;
+	node->size = len;
+	node->priority = strsafe_rope_priority(rope);
+	return node;
+}
+
+/**
+ * @brief Frees a subtree.
+ * @param node Subtree root, may be `NULL`.
+ */
+static inline void strsafe_rope_node_free(StrSafe_rope_node* node) {
+	if (!node) return;
+	strsafe_rope_node_free(node->left);
+	strsafe_rope_node_free(node->right);
+	strsafe_free(&node->leaf);
+	STRSAFE_FREE(node);
+}
+
+/**
+ * @brief Joins two trees, all of `a` before all of `b`.
+ */
+static inline StrSafe_rope_node* strsafe_rope_merge(StrSafe_rope_node* a, StrSafe_rope_node* b) {
+	if (!a) return b;
+	if (!b) return a;
+	if (a->priority >= b->priority) {
+		a->right = strsafe_rope_merge(a->right, b);
+		strsafe_rope_node_update(a);
+		return a;
+	}
+	b->left = strsafe_rope_merge(a, b->left);
+	strsafe_rope_node_update(b);
+	return b;
+}
+
+/**
+ * @brief Splits a tree into its first `pos` bytes and the rest.
+ *
+ * A leaf straddling `pos` is cut in two; the second half goes into a spare node, so the
+ * caller must have reserved one.
+ */
+static inline void strsafe_rope_split(StrSafe_rope* rope, StrSafe_rope_node* node, size_t pos,
+	StrSafe_rope_node** left, StrSafe_rope_node** right) {
+	if (!node) {
+		*left = NULL;
+		*right = NULL;
+		return;
+	}
+
+	size_t left_size = strsafe_rope_node_size(node->left);
+	size_t leaf_len = strsafe_length(&node->leaf);
+	if (pos <= left_size) {
+		strsafe_rope_split(rope, node->left, pos, left, &node->left);
+		strsafe_rope_node_update(node);
+		*right = node;
+	}
+	else if (pos >= left_size + leaf_len) {
+		strsafe_rope_split(rope, node->right, pos - left_size - leaf_len, &node->right, right);
+		strsafe_rope_node_update(node);
+		*left = node;
+	}
+	else {
+		// the tail of the leaf becomes a node of the same priority holding the right subtree
+		size_t offset = pos - left_size;
+		StrSafe_rope_node* tail = rope->spare;
+		rope->spare = tail->right;
+		--rope->spare_count;
+
+		char* data = strsafe_data(&node->leaf);
+		strsafe_assign(&tail->leaf, data + offset, leaf_len - offset);
+		data[offset] = '\0';
+		strsafe_set_length(&node->leaf, offset);
+
+		tail->priority = node->priority;
+		tail->left = NULL;
+		tail->right = node->right;
+		node->right = NULL;
+		strsafe_rope_node_update(node);
+		strsafe_rope_node_update(tail);
+		*left = node;
+		*right = tail;
+	}
+}
+
+/**
+ * @brief Makes sure `count` spare nodes are available for `strsafe_rope_split`.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_rope_reserve_spares(StrSafe_rope* rope, size_t count) {
+	while (rope->spare_count < count) {
+		StrSafe_rope_node* node = strsafe_rope_node_new(rope, "", 0, STRSAFE_ROPE_LEAF);
+		if (!node) return false;
+		node->right = rope->spare;
+		rope->spare = node;
+		++rope->spare_count;
+	}
+	return true;
+}
+
+/**
+ * @brief Builds a tree over `len` bytes of `text` cut into leaves.
+ * @param out Receives the tree, `NULL` for empty text.
+ * @return `true` if successful, `false` on allocation failure (nothing is leaked).
+ */
+static inline bool strsafe_rope_build(StrSafe_rope* rope, const char* text, size_t len, StrSafe_rope_node** out) {
+	StrSafe_rope_node* tree = NULL;
+	for (size_t done = 0; done < len;) {
+		size_t chunk = len - done < STRSAFE_ROPE_LEAF ? len - done : STRSAFE_ROPE_LEAF;
+		StrSafe_rope_node* node = strsafe_rope_node_new(rope, text + done, chunk, chunk);
+		if (!node) {
+			strsafe_rope_node_free(tree);
+			return false;
+		}
+		tree = strsafe_rope_merge(tree, node);
+		done += chunk;
+	}
+	*out = tree;
+	return true;
+}
+
+/**
+ * @brief Inserts into the leaf holding `pos` when the result still fits in a leaf.
+ * @return `true` if the text was inserted, `false` if the edit needs a split.
+ */
+static inline bool strsafe_rope_node_insert(StrSafe_rope_node* node, size_t pos, const char* text, size_t len) {
+	if (!node) return false;
+
+	size_t left_size = strsafe_rope_node_size(node->left);
+	size_t leaf_len = strsafe_length(&node->leaf);
+	bool inserted;
+	if (pos < left_size) {
+		inserted = strsafe_rope_node_insert(node->left, pos, text, len);
+	}
+	else if (pos <= left_size + leaf_len) {
+		size_t offset = pos - left_size;
+		inserted = leaf_len + len <= STRSAFE_ROPE_LEAF && strsafe_ensure_capacity(&node->leaf, leaf_len + len + 1);
+		if (inserted) {
+			char* data = strsafe_data(&node->leaf);
+			memmove(data + offset + len, data + offset, leaf_len - offset + 1);
+			memcpy(data + offset, text, len);
+			strsafe_set_length(&node->leaf, leaf_len + len);
+		}
+	}
+	else {
+		inserted = strsafe_rope_node_insert(node->right, pos - left_size - leaf_len, text, len);
+	}
+	if (inserted) node->size += len;
+	return inserted;
+}
+
+/**
+ * @brief Removes `len` bytes at `pos` when they lie inside one leaf that keeps some bytes.
+ * @return `true` if the bytes were removed, `false` if the edit needs a split.
+ */
+static inline bool strsafe_rope_node_erase(StrSafe_rope_node* node, size_t pos, size_t len) {
+	if (!node) return false;
+
+	size_t left_size = strsafe_rope_node_size(node->left);
+	size_t leaf_len = strsafe_length(&node->leaf);
+	bool erased;
+	if (pos < left_size) {
+		erased = strsafe_rope_node_erase(node->left, pos, len);
+	}
+	else if (pos < left_size + leaf_len) {
+		size_t offset = pos - left_size;
+		erased = offset + len <= leaf_len && len < leaf_len;
+		if (erased) {
+			char* data = strsafe_data(&node->leaf);
+			memmove(data + offset, data + offset + len, leaf_len - offset - len + 1);
+			strsafe_set_length(&node->leaf, leaf_len - len);
+		}
+	}
+	else {
+		erased = strsafe_rope_node_erase(node->right, pos - left_size - leaf_len, len);
+	}
+	if (erased) node->size -= len;
+	return erased;
+}
+
+/**
+ * @brief Copies `len` bytes starting at `pos` of a subtree to `out`.
+ */
+static inline void strsafe_rope_node_copy(const StrSafe_rope_node* node, size_t pos, size_t len, char* out) {
+	while (node && len > 0) {
+		size_t left_size = strsafe_rope_node_size(node->left);
+		size_t leaf_len = strsafe_length(&node->leaf);
+		if (pos < left_size) {
+			size_t from_left = left_size - pos < len ? left_size - pos : len;
+			strsafe_rope_node_copy(node->left, pos, from_left, out);
+			out += from_left;
+			len -= from_left;
+			pos = left_size;
+		}
+		if (len == 0) break;
+		if (pos < left_size + leaf_len) {
+			size_t offset = pos - left_size;
+			size_t from_leaf = leaf_len - offset < len ? leaf_len - offset : len;
+			memcpy(out, strsafe_cstr(&node->leaf) + offset, from_leaf);
+			out += from_leaf;
+			len -= from_leaf;
+			pos += from_leaf;
+		}
+		// continue in the right subtree
+		pos -= left_size + leaf_len;
+		node = node->right;
+	}
+}
+
+/**
+ * @brief Initializes an empty rope.
+ * @param rope Rope to initialize.
+ */
+static inline void strsafe_rope_init(StrSafe_rope* rope) {
+	rope->root = NULL;
+	rope->spare = NULL;
+	rope->spare_count = 0;
+	rope->seed = 0x9E3779B9u;
+}
+
+/**
+ * @brief Frees every node of a rope; it is left empty.
+ * @param rope Rope to free.
+ */
+static inline void strsafe_rope_free(StrSafe_rope* rope) {
+	strsafe_rope_node_free(rope->root);
+	while (rope->spare) {
+		StrSafe_rope_node* next = rope->spare->right;
+		rope->spare->right = NULL;
+		strsafe_rope_node_free(rope->spare);
+		rope->spare = next;
+	}
+	strsafe_rope_init(rope);
+}
+
+/**
+ * @brief Returns the number of bytes in a rope.
+ * @param rope The rope.
+ * @return Length in bytes.
+ */
+static inline size_t strsafe_rope_length(const StrSafe_rope* rope) {
+	return strsafe_rope_node_size(rope->root);
+}
+
+/**
+ * @brief Returns the byte at `pos`.
+ * @param rope The rope.
+ * @param pos Byte position, below `strsafe_rope_length`.
+ * @return The byte, or `'\0'` if `pos` is out of range.
+ */
+static inline char strsafe_rope_at(const StrSafe_rope* rope, size_t pos) {
+	const StrSafe_rope_node* node = rope->root;
+	while (node) {
+		size_t left_size = strsafe_rope_node_size(node->left);
+		size_t leaf_len = strsafe_length(&node->leaf);
+		if (pos < left_size) {
+			node = node->left;
+		}
+		else if (pos < left_size + leaf_len) {
+			return strsafe_cstr(&node->leaf)[pos - left_size];
+		}
+		else {
+			pos -= left_size + leaf_len;
+			node = node->right;
+		}
+	}
+	return '\0';
+}
+
+/**
+ * @brief Replaces `len` bytes at `pos` with `text_len` bytes of `text`.
+ *
+ * `pos` is clamped to the length of the rope and `len` to the bytes after `pos`.
+ *
+ * @param rope The rope to edit.
+ * @param pos Start of the replaced range.
+ * @param len Number of bytes to replace.
+ * @param text Replacement bytes; must not point into the rope.
+ * @param text_len Number of bytes in `text`.
+ * @return `true` if successful, `false` on allocation failure (the rope is unchanged).
+ */
+static inline bool strsafe_rope_replace(StrSafe_rope* rope, size_t pos, size_t len, const char* text, size_t text_len) {
+	size_t total = strsafe_rope_length(rope);
+	if (pos > total) pos = total;
+	if (len > total - pos) len = total - pos;
+
+	StrSafe_rope_node* inserted;
+	if (!strsafe_rope_reserve_spares(rope, 2)) return false;
+	if (!strsafe_rope_build(rope, text, text_len, &inserted)) return false;
+
+	StrSafe_rope_node* before;
+	StrSafe_rope_node* rest;
+	StrSafe_rope_node* removed;
+	StrSafe_rope_node* after;
+	strsafe_rope_split(rope, rope->root, pos, &before, &rest);
+	strsafe_rope_split(rope, rest, len, &removed, &after);
+	strsafe_rope_node_free(removed);
+	rope->root = strsafe_rope_merge(strsafe_rope_merge(before, inserted), after);
+	return true;
+}
+
+/**
+ * @brief Inserts `len` bytes of `text` at `pos`.
+ *
+ * When the leaf at `pos` has room the bytes are inserted into it directly; otherwise the
+ * text gets leaves of its own.
+ *
+ * @param rope The rope to edit.
+ * @param pos Insert position, clamped to the length of the rope.
+ * @param text Bytes to insert; must not point into the rope.
+ * @param len Number of bytes in `text`.
+ * @return `true` if successful, `false` on allocation failure (the rope is unchanged).
+ */
+static inline bool strsafe_rope_insert(StrSafe_rope* rope, size_t pos, const char* text, size_t len) {
+	if (len == 0) return true;
+	size_t total = strsafe_rope_length(rope);
+	if (pos > total) pos = total;
+	if (strsafe_rope_node_insert(rope->root, pos, text, len)) return true;
+	return strsafe_rope_replace(rope, pos, 0, text, len);
+}
+
+/**
+ * @brief Removes `len` bytes at `pos`.
+ * @param rope The rope to edit.
+ * @param pos Start of the removed range, clamped to the length of the rope.
+ * @param len Number of bytes to remove, clamped to the bytes after `pos`.
+ * @return `true` if successful, `false` on allocation failure (the rope is unchanged).
+ */
+static inline bool strsafe_rope_remove(StrSafe_rope* rope, size_t pos, size_t len) {
+	size_t total = strsafe_rope_length(rope);
+	if (pos >= total || len == 0) return true;
+	if (len > total - pos) len = total - pos;
+	if (strsafe_rope_node_erase(rope->root, pos, len)) return true;
+	return strsafe_rope_replace(rope, pos, len, "", 0);
+}
+
+/**
+ * @brief Initializes a rope holding `len` bytes of `text`.
+ * @param rope Rope to initialize.
+ * @param text Initial contents.
+ * @param len Number of bytes in `text`.
+ * @return `true` if successful, `false` on allocation failure (the rope is empty).
+ */
+static inline bool strsafe_rope_init_from(StrSafe_rope* rope, const char* text, size_t len) {
+	strsafe_rope_init(rope);
+	return strsafe_rope_build(rope, text, len, &rope->root);
+}
+
+/**
+ * @brief Copies `len` bytes starting at `pos` into a `StrSafe`.
+ *
+ * Finding the range costs O(log n); the copy is proportional to `len`.
+ *
+ * @param rope The rope.
+ * @param pos Start of the range, clamped to the length of the rope.
+ * @param len Number of bytes, clamped to the bytes after `pos`.
+ * @param dst Destination string; its previous contents are replaced.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_rope_substr(const StrSafe_rope* rope, size_t pos, size_t len, StrSafe* dst) {
+	size_t total = strsafe_rope_length(rope);
+	if (pos > total) pos = total;
+	if (len > total - pos) len = total - pos;
+
+	if (!strsafe_ensure_capacity(dst, len + 1)) return false;
+	char* data = strsafe_data(dst);
+	strsafe_rope_node_copy(rope->root, pos, len, data);
+	data[len] = '\0';
+	strsafe_set_length(dst, len);
+	return true;
+}
+
+/**
+ * @brief Copies the whole rope into a contiguous `StrSafe`.
+ * @param rope The rope.
+ * @param dst Destination string; its previous contents are replaced.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_rope_flatten(const StrSafe_rope* rope, StrSafe* dst) {
+	return strsafe_rope_substr(rope, 0, SIZE_MAX, dst);
+}
+
+#endif // SAFE_STR_ROPE_H
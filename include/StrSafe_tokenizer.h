@@ -0,0 +1,178 @@
+
+/**
+ * @file StrSafe_tokenizer.h
+ * @brief Incremental delimiter tokenizer over input that arrives in chunks.
+ *
+ * Feed a `StrSafe_tokenizer` chunks of any size with `strsafe_tokenizer_feed` and pull
+ * complete fields with `strsafe_tokenizer_next` until it returns `false`, then feed the
+ * next chunk. Fields that lie inside one chunk are returned as views of that chunk
+ * without copying; only the unfinished field at the end of a chunk is buffered, so memory
+ * stays bounded by the longest field rather than the size of the input. Delimiters may
+ * straddle chunk boundaries.
+ *
+ * After the last chunk call `strsafe_tokenizer_finish`; the next pull then returns the
+ * final field, which is empty when the input ends with a delimiter, as in `cstr_split`.
+ *
+ */
+
+#ifndef SAFE_STR_TOKENIZER_H
+#define SAFE_STR_TOKENIZER_H
+
+#include "StrSafe.h"
+
+/**
+ * @struct StrSafe_tokenizer
+ * @brief State of an incremental split.
+ */
+typedef struct {
+	char* delim;              /**< Copy of the delimiter bytes. */
+	StrSafe_needle needle;    /**< Delimiter prepared over `delim`. */
+	StrSafe tail;             /**< Unfinished field carried over from earlier chunks. */
+	StrSafe_view chunk;       /**< Part of the current chunk not tokenized yet. */
+	bool tail_emitted;        /**< `tail` was returned as a field and is cleared on the next pull. */
+	bool finished;            /**< `strsafe_tokenizer_finish` was called. */
+	bool done;                /**< The final field has been returned. */
+	bool failed;              /**< Buffering a field failed to allocate; the field is lost. */
+} StrSafe_tokenizer;
+
+/**
+ * @brief Initializes a tokenizer splitting on `delim_len` bytes of `delim`.
+ *
+ * An empty delimiter yields the whole input as a single field, which is then buffered
+ * in full.
+ *
+ * @param tok Tokenizer to initialize.
+ * @param delim Delimiter bytes; copied.
+ * @param delim_len Number of bytes in `delim`.
+ * @return `true` if successful, `false` on allocation failure.
+ */
+static inline bool strsafe_tokenizer_init(StrSafe_tokenizer* tok, const char* delim, size_t delim_len) {
+	memset(tok, 0, sizeof(*tok));
+	tok->delim = STRSAFE_MALLOC(delim_len ? delim_len : 1);
+	if (!tok->delim) return false;
+	memcpy(tok->delim, delim, delim_len);
+	strsafe_needle_init(&tok->needle, tok->delim, delim_len);
+	strsafe_init(&tok->tail);
+	return true;
+}
+
+/**
+ * @brief Frees the memory owned by a tokenizer.
+ * @param tok Tokenizer to free.
+ */
+static inline void strsafe_tokenizer_free(StrSafe_tokenizer* tok) {
+	STRSAFE_FREE(tok->delim);
+	strsafe_free(&tok->tail);
+	memset(tok, 0, sizeof(*tok));
+}
+
+/**
+ * @brief Hands the tokenizer its next chunk of input.
+ *
+ * The chunk is not copied up front: it must stay valid until `strsafe_tokenizer_next`
+ * returns `false`, at which point any unfinished field has been buffered and the chunk
+ * memory may be reused.
+ *
+ * @param tok The tokenizer.
+ * @param data Chunk bytes.
+ * @param len Number of bytes in `data`.
+ * @return `false` if the previous chunk has not been drained yet or input was finished.
+ */
+static inline bool strsafe_tokenizer_feed(StrSafe_tokenizer* tok, const char* data, size_t len) {
+	if (tok->chunk.len > 0 || tok->finished) return false;
+	tok->chunk = strsafe_view_make(data, len);
+	return true;
+}
+
+/**
+ * @brief Marks the end of the input so the last field can be pulled.
+ * @param tok The tokenizer.
+ */
+static inline void strsafe_tokenizer_finish(StrSafe_tokenizer* tok) {
+	tok->finished = true;
+}
+
+/**
+ * @brief Pulls the next complete field.
+ *
+ * @param tok The tokenizer.
+ * @param field Receives the field; it points into the chunk or the tokenizer and is
+ *              valid until the next call on `tok`.
+ * @return `true` if a field was returned; `false` when more input is needed, when the
+ *         input is exhausted, or when `tok->failed` is set.
+ */
+static inline bool strsafe_tokenizer_next(StrSafe_tokenizer* tok, StrSafe_view* field) {
+	if (tok->tail_emitted) {
+		if (strsafe_length(&tok->tail) > 0) {
+			strsafe_data(&tok->tail)[0] = '\0';
+			strsafe_set_length(&tok->tail, 0);
+		}
+		tok->tail_emitted = false;
+	}
+
+	size_t delim_len = tok->needle.len;
+	size_t tail_len = strsafe_length(&tok->tail);
+	if (delim_len > 0 && tok->chunk.len > 0) {
+		// a delimiter begun in `tail` and completed by the chunk; take the earliest
+		size_t k = delim_len - 1 < tail_len ? delim_len - 1 : tail_len;
+		for (; k > 0; --k) {
+			if (tok->chunk.len >= delim_len - k
+				&& memcmp(strsafe_cstr(&tok->tail) + tail_len - k, tok->delim, k) == 0
+				&& memcmp(tok->chunk.ptr, tok->delim + k, delim_len - k) == 0) {
+				*field = strsafe_view_make(strsafe_cstr(&tok->tail), tail_len - k);
+				tok->chunk = strsafe_view_substr(tok->chunk, delim_len - k, SIZE_MAX);
+				tok->tail_emitted = true;
+				return true;
+			}
+		}
+
+		const char* found = strsafe_needle_search(tok->chunk.ptr, tok->chunk.len, &tok->needle);
+		if (found) {
+			size_t field_len = found - tok->chunk.ptr;
+			if (tail_len == 0) {
+				*field = strsafe_view_make(tok->chunk.ptr, field_len);
+			}
+			else {
+				if (!cstr_append_n(&tok->tail, tok->chunk.ptr, field_len)) {
+					tok->failed = true;
+					return false;
+				}
+				*field = strsafe_view_of(&tok->tail);
+				tok->tail_emitted = true;
+			}
+			tok->chunk = strsafe_view_substr(tok->chunk, field_len + delim_len, SIZE_MAX);
+			return true;
+		}
+	}
+
+	// no delimiter left in the chunk: keep its rest as the start of the next field
+	if (tok->chunk.len > 0) {
+		if (!cstr_append_n(&tok->tail, tok->chunk.ptr, tok->chunk.len)) {
+			tok->failed = true;
+			return false;
+		}
+		tok->chunk.len = 0;
+	}
+
+	if (tok->finished && !tok->done) {
+		tok->done = true;
+		*field = strsafe_length(&tok->tail) ? strsafe_view_of(&tok->tail) : strsafe_view_make("", 0);
+		tok->tail_emitted = true;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * @brief Pulls the next complete field as a copy in a `StrSafe`.
+ * @param tok The tokenizer.
+ * @param dst Receives the field; its previous contents are replaced.
+ * @return `true` if a field was returned, `false` as for `strsafe_tokenizer_next` or on allocation failure.
+ */
+static inline bool strsafe_tokenizer_next_str(StrSafe_tokenizer* tok, StrSafe* dst) {
+	StrSafe_view field;
+	if (!strsafe_tokenizer_next(tok, &field)) return false;
+	return strsafe_assign(dst, field.ptr, field.len) != NULL;
+}
+
+#endif // SAFE_STR_TOKENIZER_H
@@ -0,0 +1,436 @@
+
+/**
+ * @file StrSafe_utf8.h
+ * @brief UTF-8 validation, codepoint counting and codepoint-safe slicing.
+ *
+ * `strsafe_utf8_validate` accepts exactly the well-formed UTF-8 of RFC 3629: no overlong
+ * forms, no surrogates, nothing above U+10FFFF and no truncated sequences. On AVX2 it
+ * classifies 32 bytes per step with the three nibble lookups of Keiser and Lemire
+ * ("Validating UTF-8 in less than one instruction per byte"); blocks of pure ASCII skip
+ * the classification entirely. Other targets skip ASCII runs 16 bytes at a time with SSE2
+ * or NEON and decode the rest one sequence at a time.
+ *
+ * The codepoint functions expect valid input: `strsafe_utf8_length` counts the bytes that
+ * are not continuation bytes, and `strsafe_utf8_substr`/`strsafe_utf8_split_at` take
+ * positions in codepoints and only ever cut between sequences.
+ *
+ * Defining `STRSAFE_UTF8_CACHE` before including `StrSafe.h` makes `strsafe_utf8_check`
+ * remember a successful validation in a bit of the heap string's `cap`, so checking the
+ * same string again is free. Every `strsafe_data` and `strsafe_set_length` call clears
+ * the bit, which covers all functions of the library; code writing through a pointer it
+ * obtained earlier must call `strsafe_utf8_invalidate`. Define the macro the same way in
+ * every translation unit. Strings stored inline are short enough to validate each time.
+ *
+ */
+
+#ifndef SAFE_STR_UTF8_H
+#define SAFE_STR_UTF8_H
+
+#include "StrSafe.h"
+
+/**
+ * @brief Number of set bits in a 64-bit mask.
+ * @param mask The mask.
+ * @return Bit count.
+ */
+static inline unsigned strsafe_popcount64(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned)__builtin_popcountll(mask);
+#else
+	mask = mask - ((mask >> 1) & 0x5555555555555555ull);
+	mask = (mask & 0x3333333333333333ull) + ((mask >> 2) & 0x3333333333333333ull);
+	mask = (mask + (mask >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+	return (unsigned)((mask * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+/**
+ * @brief Tells whether a byte starts a codepoint, i.e. is not a continuation byte.
+ * @param c The byte.
+ * @return `true` unless `c` is in `0x80`-`0xBF`.
+ */
+static inline bool strsafe_utf8_is_lead(unsigned char c) {
+	return (c & 0xC0) != 0x80;
+}
+
+/**
+ * @brief Validates one sequence at a time, skipping ASCII runs.
+ * @param bytes Bytes to validate.
+ * @param len Number of bytes.
+ * @return `true` if `bytes` is well-formed UTF-8.
+ */
+static inline bool strsafe_utf8_validate_scalar(const char* bytes, size_t len) {
+	const unsigned char* s = (const unsigned char*)bytes;
+	size_t i = 0;
+	while (i < len) {
+#if defined(STRSAFE_HAVE_SSE2)
+		if (i + 16 <= len && _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(s + i))) == 0) {
+			i += 16;
+			continue;
+		}
+#elif defined(STRSAFE_HAVE_NEON)
+		if (i + 16 <= len) {
+			uint8x16_t high = vcgeq_u8(vld1q_u8(s + i), vdupq_n_u8(0x80));
+			if (vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(high), 4)), 0) == 0) {
+				i += 16;
+				continue;
+			}
+		}
+#endif
+		unsigned char c = s[i];
+		if (c < 0x80) {
+			++i;
+			continue;
+		}
+		if (c < 0xC2 || c > 0xF4) return false;
+		if (c < 0xE0) {
+			if (i + 1 >= len || (s[i + 1] & 0xC0) != 0x80) return false;
+			i += 2;
+			continue;
+		}
+		if (c < 0xF0) {
+			if (i + 2 >= len) return false;
+			unsigned char c1 = s[i + 1];
+			if ((c1 & 0xC0) != 0x80 || (s[i + 2] & 0xC0) != 0x80) return false;
+			// overlong below U+0800, or a UTF-16 surrogate
+			if ((c == 0xE0 && c1 < 0xA0) || (c == 0xED && c1 > 0x9F)) return false;
+			i += 3;
+			continue;
+		}
+		if (i + 3 >= len) return false;
+		unsigned char c1 = s[i + 1];
+		if ((c1 & 0xC0) != 0x80 || (s[i + 2] & 0xC0) != 0x80 || (s[i + 3] & 0xC0) != 0x80) return false;
+		// overlong below U+10000, or above U+10FFFF
+		if ((c == 0xF0 && c1 < 0x90) || (c == 0xF4 && c1 > 0x8F)) return false;
+		i += 4;
+	}
+	return true;
+}
+
+#ifdef STRSAFE_HAVE_AVX2
+/** @brief The 32 bytes ending `n` bytes before the end of `input`, continuing from `prev`. */
+#define STRSAFE_UTF8_PREV(input, prev, n) _mm256_alignr_epi8((input), _mm256_permute2x128_si256((prev), (input), 0x21), 16 - (n))
+
+/**
+ * @brief Error bits of one 32-byte block given the block before it.
+ *
+ * Each pair of adjacent bytes is looked up by the high nibble of the first, its low nibble
+ * and the high nibble of the second; the three tables flag every invalid two-byte pattern
+ * and their AND is non-zero only where all three agree. Third and fourth bytes must be
+ * continuations exactly where the `TWO_CONTS` bit says two continuations follow each other.
+ *
+ * @param input The block.
+ * @param prev The previous block, or zeros.
+ * @return Non-zero lanes where the input is invalid.
+ */
+STRSAFE_AVX2_TARGET
+static inline __m256i strsafe_utf8_check_avx2(__m256i input, __m256i prev) {
+	enum {
+		TOO_SHORT = 1 << 0, TOO_LONG = 1 << 1, OVERLONG_3 = 1 << 2, TOO_LARGE = 1 << 3,
+		SURROGATE = 1 << 4, OVERLONG_2 = 1 << 5, TOO_LARGE_1000 = 1 << 6, OVERLONG_4 = 1 << 6,
+		TWO_CONTS = 1 << 7, CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS
+	};
+	const __m256i byte_1_high_table = _mm256_setr_epi8(
+		TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+		(char)TWO_CONTS, (char)TWO_CONTS, (char)TWO_CONTS, (char)TWO_CONTS,
+		TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE,
+		TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+		TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+		(char)TWO_CONTS, (char)TWO_CONTS, (char)TWO_CONTS, (char)TWO_CONTS,
+		TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE,
+		TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+	const __m256i byte_1_low_table = _mm256_setr_epi8(
+		(char)(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4), (char)(CARRY | OVERLONG_2), (char)CARRY, (char)CARRY,
+		(char)(CARRY | TOO_LARGE), (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		(char)(CARRY | TOO_LARGE | TOO_LARGE_1000), (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		(char)(CARRY | TOO_LARGE | TOO_LARGE_1000), (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		(char)(CARRY | TOO_LARGE | TOO_LARGE_1000), (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		(char)(CARRY | TOO_LARGE | TOO_LARGE_1000), (char)(CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE),
+		(char)(CARRY | TOO_LARGE | TOO_LARGE_1000), (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		(char)(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4), (char)(CARRY | OVERLONG_2), (char)CARRY, (char)CARRY,
+		(char)(CARRY | TOO_LARGE), (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		(char)(CARRY | TOO_LARGE | TOO_LARGE_1000), (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		(char)(CARRY | TOO_LARGE | TOO_LARGE_1000), (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		(char)(CARRY | TOO_LARGE | TOO_LARGE_1000), (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+		(char)(CARRY | TOO_LARGE | TOO_LARGE_1000), (char)(CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE),
+		(char)(CARRY | TOO_LARGE | TOO_LARGE_1000), (char)(CARRY | TOO_LARGE | TOO_LARGE_1000));
+	const __m256i byte_2_high_table = _mm256_setr_epi8(
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		(char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4),
+		(char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE),
+		(char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+		(char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		(char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4),
+		(char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE),
+		(char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+		(char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+	const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+
+	__m256i prev1 = STRSAFE_UTF8_PREV(input, prev, 1);
+	__m256i byte_1_high = _mm256_shuffle_epi8(byte_1_high_table, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+	__m256i byte_1_low = _mm256_shuffle_epi8(byte_1_low_table, _mm256_and_si256(prev1, low_nibble));
+	__m256i byte_2_high = _mm256_shuffle_epi8(byte_2_high_table, _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+	__m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+	// only 111_____ two bytes back and 1111____ three bytes back stay at or above 0x80
+	__m256i third = _mm256_subs_epu8(STRSAFE_UTF8_PREV(input, prev, 2), _mm256_set1_epi8((char)(0xE0 - 0x80)));
+	__m256i fourth = _mm256_subs_epu8(STRSAFE_UTF8_PREV(input, prev, 3), _mm256_set1_epi8((char)(0xF0 - 0x80)));
+	__m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+	return _mm256_xor_si256(must_continue, special);
+}
+
+/**
+ * @brief AVX2 validator; the tail is zero-padded into one last block.
+ * @return `true` if `bytes` is well-formed UTF-8.
+ */
+STRSAFE_AVX2_TARGET
+static inline bool strsafe_utf8_validate_avx2(const char* bytes, size_t len) {
+	// lanes at or above these mark a lead byte whose sequence runs past the block
+	const __m256i incomplete_min = _mm256_setr_epi8(
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		(char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+	__m256i error = _mm256_setzero_si256();
+	__m256i prev = _mm256_setzero_si256();
+	__m256i prev_incomplete = _mm256_setzero_si256();
+	char last[32];
+	size_t i = 0;
+	for (;;) {
+		__m256i input;
+		bool tail = i + 32 > len;
+		if (!tail) {
+			input = _mm256_loadu_si256((const __m256i*)(bytes + i));
+		}
+		else {
+			memset(last, 0, sizeof(last));
+			if (len > i) memcpy(last, bytes + i, len - i);
+			input = _mm256_loadu_si256((const __m256i*)last);
+		}
+		if (_mm256_movemask_epi8(input) == 0) {
+			error = _mm256_or_si256(error, prev_incomplete);
+		}
+		else {
+			error = _mm256_or_si256(error, strsafe_utf8_check_avx2(input, prev));
+			prev_incomplete = _mm256_subs_epu8(input, incomplete_min);
+		}
+		if (tail) break;
+		prev = input;
+		i += 32;
+		// bail out early on bad input, but without a branch in every block
+		if ((i & 1023) == 0 && !_mm256_testz_si256(error, error)) return false;
+	}
+	return _mm256_testz_si256(error, error) != 0;
+}
+#endif
+
+/**
+ * @brief Tells whether `len` bytes are well-formed UTF-8.
+ * @param bytes Bytes to validate.
+ * @param len Number of bytes.
+ * @return `true` if valid; an empty input is valid.
+ */
+static inline bool strsafe_utf8_validate_n(const char* bytes, size_t len) {
+#if defined(STRSAFE_HAVE_AVX2)
+	if (len >= 32 && strsafe_cpu_has_avx2()) return strsafe_utf8_validate_avx2(bytes, len);
+#endif
+	return strsafe_utf8_validate_scalar(bytes, len);
+}
+
+/**
+ * @brief Tells whether a view is well-formed UTF-8.
+ * @param view The view.
+ * @return `true` if valid.
+ */
+static inline bool strsafe_view_utf8_validate(StrSafe_view view) {
+	return strsafe_utf8_validate_n(view.ptr, view.len);
+}
+
+/**
+ * @brief Tells whether a string is well-formed UTF-8.
+ * @param src The string.
+ * @return `true` if valid.
+ */
+static inline bool strsafe_utf8_validate(const StrSafe* src) {
+	return strsafe_utf8_validate_n(strsafe_cstr(src), strsafe_length(src));
+}
+
+/**
+ * @brief Validates a string, remembering success when built with `STRSAFE_UTF8_CACHE`.
+ *
+ * A heap string found valid keeps a flag until it is next modified, and later checks
+ * return at once. Without the macro this is `strsafe_utf8_validate`.
+ *
+ * @param src The string.
+ * @return `true` if valid.
+ */
+static inline bool strsafe_utf8_check(StrSafe* src) {
+#ifdef STRSAFE_UTF8_CACHE
+	if (strsafe_is_inline(src)) return strsafe_utf8_validate(src);
+	if (src->cap & STRSAFE_UTF8_FLAG) return true;
+	if (!strsafe_utf8_validate(src)) return false;
+	src->cap |= STRSAFE_UTF8_FLAG;
+	return true;
+#else
+	return strsafe_utf8_validate(src);
+#endif
+}
+
+/**
+ * @brief Forgets a cached validation after the contents were changed behind the library's back.
+ * @param src The string.
+ */
+static inline void strsafe_utf8_invalidate(StrSafe* src) {
+	if (!strsafe_is_inline(src)) src->cap &= ~STRSAFE_UTF8_FLAG;
+}
+
+/**
+ * @brief Counts the codepoint-starting bytes of a 16-byte block.
+ * @param bytes At least 16 readable bytes.
+ * @return Number of bytes that are not continuation bytes.
+ */
+static inline size_t strsafe_utf8_leads16(const char* bytes) {
+#if defined(STRSAFE_HAVE_SSE2)
+	__m128i leads = _mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)bytes), _mm_set1_epi8((char)0xBF));
+	return strsafe_popcount64((unsigned)_mm_movemask_epi8(leads));
+#elif defined(STRSAFE_HAVE_NEON)
+	uint8x16_t leads = vcgtq_s8(vreinterpretq_s8_u8(vld1q_u8((const uint8_t*)bytes)), vdupq_n_s8((int8_t)0xBF));
+	return strsafe_popcount64(vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(leads), 4)), 0)) / 4;
+#else
+	size_t count = 0;
+	for (size_t i = 0; i < 16; ++i) count += strsafe_utf8_is_lead((unsigned char)bytes[i]);
+	return count;
+#endif
+}
+
+#ifdef STRSAFE_HAVE_AVX2
+/** @brief AVX2 loop of `strsafe_utf8_length_n`; returns the count over the first `*done` bytes. */
+STRSAFE_AVX2_TARGET
+static inline size_t strsafe_utf8_length_avx2(const char* bytes, size_t len, size_t* done) {
+	// continuation bytes are exactly the signed values below -64
+	const __m256i threshold = _mm256_set1_epi8((char)0xBF);
+	size_t count = 0;
+	size_t i = 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i leads = _mm256_cmpgt_epi8(_mm256_loadu_si256((const __m256i*)(bytes + i)), threshold);
+		count += strsafe_popcount64((uint32_t)_mm256_movemask_epi8(leads));
+	}
+	*done = i;
+	return count;
+}
+#endif
+
+/**
+ * @brief Counts the codepoints of valid UTF-8.
+ * @param bytes Bytes to count.
+ * @param len Number of bytes.
+ * @return Number of bytes that are not continuation bytes.
+ */
+static inline size_t strsafe_utf8_length_n(const char* bytes, size_t len) {
+	size_t count = 0;
+	size_t i = 0;
+#if defined(STRSAFE_HAVE_AVX2)
+	if (len >= 32 && strsafe_cpu_has_avx2()) count = strsafe_utf8_length_avx2(bytes, len, &i);
+#endif
+	for (; i + 16 <= len; i += 16) count += strsafe_utf8_leads16(bytes + i);
+	for (; i < len; ++i) count += strsafe_utf8_is_lead((unsigned char)bytes[i]);
+	return count;
+}
+
+/**
+ * @brief Counts the codepoints of a view.
+ * @param view Valid UTF-8.
+ * @return Number of codepoints.
+ */
+static inline size_t strsafe_view_utf8_length(StrSafe_view view) {
+	return strsafe_utf8_length_n(view.ptr, view.len);
+}
+
+/**
+ * @brief Counts the codepoints of a string.
+ * @param src Valid UTF-8.
+ * @return Number of codepoints.
+ */
+static inline size_t strsafe_utf8_length(const StrSafe* src) {
+	return strsafe_utf8_length_n(strsafe_cstr(src), strsafe_length(src));
+}
+
+/**
+ * @brief Byte offset of a codepoint.
+ *
+ * Whole 16-byte blocks are skipped by their codepoint count, so only the block holding the
+ * codepoint is walked byte by byte.
+ *
+ * @param bytes Valid UTF-8.
+ * @param len Number of bytes.
+ * @param index Codepoint index.
+ * @return Offset of codepoint `index`, or `len` if there are not that many.
+ */
+static inline size_t strsafe_utf8_offset(const char* bytes, size_t len, size_t index) {
+	size_t i = 0;
+	for (; i + 16 <= len; i += 16) {
+		size_t leads = strsafe_utf8_leads16(bytes + i);
+		if (leads > index) break;
+		index -= leads;
+	}
+	for (; i < len; ++i) {
+		if (strsafe_utf8_is_lead((unsigned char)bytes[i])) {
+			if (index == 0) return i;
+			--index;
+		}
+	}
+	return len;
+}
+
+/**
+ * @brief Moves a byte position back to the start of the codepoint containing it.
+ * @param bytes Valid UTF-8.
+ * @param len Number of bytes.
+ * @param pos Byte position, clamped to `len`.
+ * @return The nearest sequence boundary at or before `pos`.
+ */
+static inline size_t strsafe_utf8_floor(const char* bytes, size_t len, size_t pos) {
+	if (pos >= len) return len;
+	for (int back = 0; back < 3 && pos > 0 && !strsafe_utf8_is_lead((unsigned char)bytes[pos]); ++back) --pos;
+	return pos;
+}
+
+/**
+ * @brief Extracts a range of codepoints from a view.
+ * @param view Valid UTF-8.
+ * @param pos First codepoint, clamped to the length.
+ * @param len Number of codepoints, clamped to what remains.
+ * @return The codepoints as a view of the same bytes.
+ */
+static inline StrSafe_view strsafe_view_utf8_substr(StrSafe_view view, size_t pos, size_t len) {
+	size_t begin = strsafe_utf8_offset(view.ptr, view.len, pos);
+	size_t end = begin + strsafe_utf8_offset(view.ptr + begin, view.len - begin, len);
+	return strsafe_view_make(view.ptr + begin, end - begin);
+}
+
+/**
+ * @brief Extracts a range of codepoints from a string in place, as `strsafe_substr` does for bytes.
+ * @param dst Valid UTF-8 to cut down.
+ * @param pos First codepoint, clamped to the length.
+ * @param len Number of codepoints, clamped to what remains.
+ * @return Pointer to `dst`, or `NULL` if a shared buffer could not be copied.
+ */
+static inline StrSafe* strsafe_utf8_substr(StrSafe* dst, size_t pos, size_t len) {
+	StrSafe_view all = strsafe_view_of(dst);
+	StrSafe_view kept = strsafe_view_utf8_substr(all, pos, len);
+	return strsafe_substr(dst, (size_t)(kept.ptr - all.ptr), kept.len);
+}
+
+/**
+ * @brief Splits a string in two before a codepoint, as `strsafe_split_at` does for bytes.
+ * @param src Valid UTF-8.
+ * @param pos Codepoint to start the second half, clamped to the length.
+ * @return Array of the two halves.
+ */
+static inline StrSafe_array strsafe_utf8_split_at(const StrSafe* src, size_t pos) {
+	return strsafe_split_at(src, strsafe_utf8_offset(strsafe_cstr(src), strsafe_length(src), pos));
+}
+
+#endif // SAFE_STR_UTF8_H
@@ -3,6 +3,16 @@
 #include <string.h>
 #include <time.h>
 #include "StrSafe.h"
+#include "StrSafe_matcher.h"
+#include "StrSafe_tokenizer.h"
+#include "StrSafe_io.h"
+#include "StrSafe_rope.h"
+#include "StrSafe_intern.h"
+#include "StrSafe_parallel.h"
+#include "StrSafe_ascii.h"
+#include "StrSafe_utf8.h"
+#include "StrSafe_edit.h"
+#include "StrSafe_literal.h"
 
 #define NUM_TESTS 100
 #define MAX_LEN 64
@@ -45,7 +55,7 @@ void test_strsafe_set(FILE* f) {
         StrSafe s;
         strsafe_init(&s);
         strsafe_set(&s, src);
-        fprintf(f, "%s,%s\n", src, s.data);
+        fprintf(f, "%s,%s\n", src, strsafe_cstr(&s));
         strsafe_free(&s);
         free(src);
     }
@@ -60,9 +70,37 @@ void test_strsafe_compare(FILE* f) {
         StrSafe a;
         strsafe_init(&a);
         strsafe_set(&a, a_str);
-        bool result = strsafe_compare(&a, &(StrSafe){.data = b_str, .len = strlen(b_str)});
+        StrSafe b;
+        strsafe_init(&b);
+        strsafe_set(&b, b_str);
+        bool result = strsafe_compare(&a, &b);
         fprintf(f, "%s,%s,%s\n", a_str, b_str, result ? "true" : "false");
         strsafe_free(&a);
+        strsafe_free(&b);
+        free(a_str);
+        free(b_str);
+    }
+}
+
+// Test: strsafe_hash / strsafe_hashed_compare
+void test_strsafe_hash(FILE* f) {
+    log_header(f, "strsafe_hash");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* a_str = random_string(rand() % MAX_LEN);
+        char* b_str = (i % 2 == 0) ? strdup(a_str) : random_string(rand() % MAX_LEN);
+        StrSafe a, b;
+        strsafe_init(&a);
+        strsafe_init(&b);
+        strsafe_set(&a, a_str);
+        strsafe_set(&b, b_str);
+        bool view_match = strsafe_view_hash(strsafe_view_of(&a)) == cstr_hash(a_str);
+        StrSafe_hashed ha, hb;
+        strsafe_hashed_from(&ha, &a);
+        strsafe_hashed_from(&hb, &b);
+        fprintf(f, "%s,%s,%s,%s,%s\n", a_str, b_str, ha.hash == hb.hash ? "same hash" : "different hash",
+            strsafe_hashed_compare(&ha, &hb) ? "true" : "false", view_match ? "view ok" : "view mismatch");
+        strsafe_hashed_free(&ha);
+        strsafe_hashed_free(&hb);
         free(a_str);
         free(b_str);
     }
@@ -78,13 +116,38 @@ void test_strsafe_copy(FILE* f) {
         strsafe_init(&dst);
         strsafe_set(&src, src_str);
         strsafe_copy(&dst, &src);
-        fprintf(f, "%s,%s\n", src.data, dst.data);
+        fprintf(f, "%s,%s\n", strsafe_cstr(&src), strsafe_cstr(&dst));
         strsafe_free(&src);
         strsafe_free(&dst);
         free(src_str);
     }
 }
 
+// Test: strsafe_share / strsafe_copy of a shared buffer, detached by cstr_append
+void test_strsafe_share(FILE* f) {
+    log_header(f, "strsafe_share");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* src_str = random_string(rand() % MAX_LEN + 32);
+        char* suffix = random_string(3);
+        StrSafe src, first, second;
+        strsafe_init(&src);
+        strsafe_init(&first);
+        strsafe_init(&second);
+        strsafe_set(&src, src_str);
+        strsafe_share(&first, &src);
+        strsafe_copy(&second, &first);
+        size_t count = strsafe_share_count(&src);
+        cstr_append(&second, suffix);
+        fprintf(f, "%s,%s,%zu,%s,%s,%zu\n", src_str, suffix, count, strsafe_cstr(&first),
+            strsafe_cstr(&second), strsafe_share_count(&src));
+        strsafe_free(&src);
+        strsafe_free(&first);
+        strsafe_free(&second);
+        free(src_str);
+        free(suffix);
+    }
+}
+
 // Test: strsafe_append
 void test_strsafe_append(FILE* f) {
     log_header(f, "strsafe_append");
@@ -97,7 +160,7 @@ void test_strsafe_append(FILE* f) {
         strsafe_set(&s, base);
         strsafe_set(&suf, suffix);
         strsafe_append(&s, &suf);
-        fprintf(f, "%s,%s,%s\n", base, suffix, s.data);
+        fprintf(f, "%s,%s,%s\n", base, suffix, strsafe_cstr(&s));
         strsafe_free(&s);
         strsafe_free(&suf);
         free(base);
@@ -117,13 +180,33 @@ void test_strsafe_substr(FILE* f) {
         size_t pos = rand() % 5;
         size_t len = rand() % 5;
         strsafe_substr(&sub, pos, len);
-        fprintf(f, "%s,%zu,%zu,%s\n", base, pos, len, sub.data);
+        fprintf(f, "%s,%zu,%zu,%s\n", base, pos, len, strsafe_cstr(&sub) ? strsafe_cstr(&sub) : "");
         strsafe_free(&s);
         strsafe_free(&sub);
         free(base);
     }
 }
 
+// Test: strsafe_substr / cstr_remove_all editing one buffer in place
+void test_strsafe_substr_inplace(FILE* f) {
+    log_header(f, "strsafe_substr / cstr_remove_all (in place)");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* remove = random_string(1);
+        char* base = generate_haystack(remove, true);
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, base);
+        size_t cap_before = strsafe_capacity(&s);
+        cstr_remove_all(&s, remove);
+        strsafe_substr(&s, 1, strsafe_length(&s) / 2);
+        fprintf(f, "%s,%s,%s,%s\n", base, remove, strsafe_cstr(&s),
+            strsafe_capacity(&s) == cap_before ? "in place" : "reallocated");
+        strsafe_free(&s);
+        free(base);
+        free(remove);
+    }
+}
+
 // Test: strsafe_replace_all
 void test_strsafe_replace_all(FILE* f) {
     log_header(f, "strsafe_replace_all");
@@ -140,7 +223,7 @@ void test_strsafe_replace_all(FILE* f) {
         strsafe_set(&old, old_str);
         strsafe_set(&new, new_str);
         strsafe_replace_all(&s, &old, &new);
-        fprintf(f, "%s,%s,%s,%s\n", base, old_str, new_str, s.data);
+        fprintf(f, "%s,%s,%s,%s\n", base, old_str, new_str, strsafe_cstr(&s));
         strsafe_free(&s);
         strsafe_free(&old);
         strsafe_free(&new);
@@ -165,7 +248,7 @@ void test_strsafe_insert(FILE* f) {
         strsafe_set(&ins, insert);
 
         strsafe_insert(&s, pos, &ins);
-        fprintf(f, "%s,%s,%zu,%s\n", base, insert, pos, s.data);
+        fprintf(f, "%s,%s,%zu,%s\n", base, insert, pos, strsafe_cstr(&s));
 
         strsafe_free(&s);
         strsafe_free(&ins);
@@ -189,7 +272,7 @@ void test_strsafe_remove_all(FILE* f) {
         strsafe_set(&rem, remove);
 
         strsafe_remove_all(&s, &rem);
-        fprintf(f, "%s,%s,%s\n", base, remove, s.data);
+        fprintf(f, "%s,%s,%s\n", base, remove, strsafe_cstr(&s));
 
         strsafe_free(&s);
         strsafe_free(&rem);
@@ -271,6 +354,50 @@ void test_strsafe_find_from_pos(FILE* f) {
     }
 }
 
+// Test: strsafe_memmem (dispatched kernel) against the scalar kernel
+void test_strsafe_memmem(FILE* f) {
+    log_header(f, "strsafe_memmem");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* needle = random_string(rand() % 6 + 2);
+        bool should_contain = i < NUM_TESTS / 2;
+        char* haystack = generate_haystack(needle, should_contain);
+        size_t haystack_len = strlen(haystack);
+        size_t needle_len = strlen(needle);
+
+        const char* fast = strsafe_memmem(haystack, haystack_len, needle, needle_len);
+        const char* slow = strsafe_memmem_scalar(haystack, haystack_len, needle, needle_len);
+        fprintf(f, "%s,%s,%zd,%s\n", haystack, needle, fast ? (ssize_t)(fast - haystack) : -1,
+            fast == slow ? "same" : "MISMATCH");
+
+        free(haystack);
+        free(needle);
+    }
+}
+
+// Test: strsafe_needle_find / strsafe_needle_count
+void test_strsafe_needle(FILE* f) {
+    log_header(f, "strsafe_needle_find / strsafe_needle_count");
+    char* needle = random_string(rand() % 6 + 1);
+    StrSafe_needle prepared;
+    strsafe_needle_init(&prepared, needle, strlen(needle));
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        bool should_contain = i < NUM_TESTS / 2;
+        char* base = generate_haystack(needle, should_contain);
+
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, base);
+        ssize_t pos = strsafe_needle_find(&s, &prepared);
+        size_t count = strsafe_needle_count(&s, &prepared);
+        fprintf(f, "%s,%s,%zd,%zu,%s\n", base, needle, pos, count,
+            pos == cstr_find(&s, needle) ? "same" : "MISMATCH");
+
+        strsafe_free(&s);
+        free(base);
+    }
+    free(needle);
+}
+
 // Test: strsafe_array_free (used after split)
 void test_strsafe_array_free(FILE* f) {
     log_header(f, "strsafe_array_free (via strsafe_split)");
@@ -287,7 +414,7 @@ void test_strsafe_array_free(FILE* f) {
         StrSafe_array parts = strsafe_split(&s, &d);
         fprintf(f, "%s,%s,%d parts\n", base, delim, parts.array_size);
         for (int j = 0; j < parts.array_size; ++j) {
-            fprintf(f, ",%s", parts.arr[j].data);
+            fprintf(f, ",%s", strsafe_cstr(&parts.arr[j]));
             strsafe_free(&parts.arr[j]);
         }
         fprintf(f, "\n");
@@ -307,14 +434,16 @@ void test_strsafe_trim(FILE* f) {
         char* base = malloc(MAX_LEN + 1);
         size_t pad = rand() % 5;
         memset(base, ' ', pad);
-        strcpy(base + pad, random_string(10));
+        char* word = random_string(10);
+        strcpy(base + pad, word);
         strcat(base, "     ");
+        free(word);
 
         StrSafe s;
         strsafe_init(&s);
         strsafe_set(&s, base);
         strsafe_trim(&s);
-        fprintf(f, "\"%s\",\"%s\"\n", base, s.data);
+        fprintf(f, "\"%s\",\"%s\"\n", base, strsafe_cstr(&s));
 
         strsafe_free(&s);
         free(base);
@@ -334,6 +463,51 @@ void test_strsafe_ensure_capacity(FILE* f) {
     }
 }
 
+// Test: strsafe_ensure_capacity growth across repeated appends
+void test_strsafe_growth(FILE* f) {
+    log_header(f, "strsafe_growth");
+    StrSafe s;
+    strsafe_init(&s);
+    size_t reallocs = 0;
+    size_t last_cap = 0;
+    for (int i = 0; i < NUM_TESTS * 10; ++i) {
+        char* piece = random_string(rand() % 8 + 1);
+        cstr_append(&s, piece);
+        if (strsafe_capacity(&s) != last_cap) {
+            ++reallocs;
+            last_cap = strsafe_capacity(&s);
+            fprintf(f, "%zu,%zu\n", strsafe_length(&s), strsafe_capacity(&s));
+        }
+        free(piece);
+    }
+    fprintf(f, "%zu reallocs for %zu bytes\n", reallocs, strsafe_length(&s));
+    strsafe_trim(&s);
+    fprintf(f, "trimmed %zu,%zu\n", strsafe_length(&s), strsafe_capacity(&s));
+    strsafe_free(&s);
+}
+
+// Test: inline/heap transitions (meaningful when built with STRSAFE_SSO)
+void test_strsafe_sso(FILE* f) {
+    log_header(f, "strsafe_sso");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* base = random_string(rand() % 40);
+        char* suffix = random_string(rand() % 8);
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, base);
+        bool was_inline = strsafe_is_inline(&s);
+        cstr_append(&s, suffix);
+        bool grown_inline = strsafe_is_inline(&s);
+        strsafe_substr(&s, 0, strlen(base) / 2);
+        strsafe_trim(&s);
+        fprintf(f, "%s,%s,%s,%s,%s,%zu\n", base, suffix, was_inline ? "inline" : "heap",
+            grown_inline ? "inline" : "heap", strsafe_cstr(&s) ? strsafe_cstr(&s) : "", strsafe_length(&s));
+        strsafe_free(&s);
+        free(base);
+        free(suffix);
+    }
+}
+
 // Test: strsafe_appendv
 void test_strsafe_appendv(FILE* f) {
     log_header(f, "strsafe_appendv");
@@ -355,7 +529,7 @@ void test_strsafe_appendv(FILE* f) {
         strsafe_set(&c, s3);
 
         strsafe_appendv(&s, &a, &b, &c, NULL);
-        fprintf(f, "%s,%s,%s,%s,%s\n", base, s1, s2, s3, s.data);
+        fprintf(f, "%s,%s,%s,%s,%s\n", base, s1, s2, s3, strsafe_cstr(&s));
 
         strsafe_free(&s);
         strsafe_free(&a);
@@ -367,6 +541,31 @@ void test_strsafe_appendv(FILE* f) {
         free(s3);
     }
 }
+
+// Test: strsafe_appendf / strsafe_append_int / strsafe_append_double against snprintf
+void test_strsafe_appendf(FILE* f) {
+    log_header(f, "strsafe_appendf / strsafe_append_int");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        StrSafe s;
+        strsafe_init(&s);
+        char* base = random_string(rand() % 20);
+        strsafe_set(&s, base);
+
+        long long value = (long long)rand() * rand() - (long long)rand() * rand();
+        double real = (double)value / (rand() % 1000 + 1);
+        strsafe_appendf(&s, "[%s:%d]", base, i);
+        strsafe_append_int(&s, value);
+        strsafe_appendf(&s, ",");
+        strsafe_append_double(&s, real, 3);
+
+        char expected[256];
+        snprintf(expected, sizeof(expected), "%s[%s:%d]%lld,%.3f", base, base, i, value, real);
+        fprintf(f, "%s,%s\n", strsafe_cstr(&s), strcmp(strsafe_cstr(&s), expected) == 0 ? "same" : "different");
+
+        strsafe_free(&s);
+        free(base);
+    }
+}
 // Test: strsafe_split
 void test_strsafe_split(FILE* f) {
     log_header(f, "strsafe_split");
@@ -383,7 +582,7 @@ void test_strsafe_split(FILE* f) {
         StrSafe_array parts = strsafe_split(&s, &d);
         fprintf(f, "%s,%s,%d parts", base, delim, parts.array_size);
         for (int j = 0; j < parts.array_size; ++j) {
-            fprintf(f, ",%s", parts.arr[j].data);
+            fprintf(f, ",%s", strsafe_cstr(&parts.arr[j]));
             strsafe_free(&parts.arr[j]);
         }
         fprintf(f, "\n");
@@ -410,7 +609,7 @@ void test_cstr_replace(FILE* f) {
         strsafe_set(&s, base);
 
         cstr_replace(&s, old_str, new_str);
-        fprintf(f, "%s,%s,%s,%s\n", base, old_str, new_str, s.data);
+        fprintf(f, "%s,%s,%s,%s\n", base, old_str, new_str, strsafe_cstr(&s));
 
         strsafe_free(&s);
         free(base);
@@ -433,7 +632,7 @@ void test_cstr_replace_all(FILE* f) {
         strsafe_set(&s, base);
 
         cstr_replace_all(&s, old_str, new_str);
-        fprintf(f, "%s,%s,%s,%s\n", base, old_str, new_str, s.data);
+        fprintf(f, "%s,%s,%s,%s\n", base, old_str, new_str, strsafe_cstr(&s));
 
         strsafe_free(&s);
         free(base);
@@ -442,6 +641,59 @@ void test_cstr_replace_all(FILE* f) {
     }
 }
 
+// Test: cstr_replace_all_n with shorter (in place) and longer replacements
+void test_cstr_replace_all_n(FILE* f) {
+    log_header(f, "cstr_replace_all_n");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* old_str = random_string(1);
+        char* new_str = random_string(rand() % 4);
+        char* base = generate_haystack(old_str, true);
+
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, base);
+        size_t cap_before = strsafe_capacity(&s);
+
+        cstr_replace_all_n(&s, old_str, 1, new_str, strlen(new_str));
+        fprintf(f, "%s,%s,%s,%s,%s\n", base, old_str, new_str, strsafe_cstr(&s),
+            strsafe_capacity(&s) == cap_before ? "in place" : "reallocated");
+
+        strsafe_free(&s);
+        free(base);
+        free(old_str);
+        free(new_str);
+    }
+}
+
+// Test: strsafe_replace_many
+void test_strsafe_replace_many(FILE* f) {
+    log_header(f, "strsafe_replace_many");
+    const char* from[] = { "a", "ab", "abc", "zz", "q" };
+    const char* to[] = { "1", "22", "", "Z", "queue" };
+    StrSafe_replacement pairs[5];
+    for (int i = 0; i < 5; ++i) {
+        pairs[i].from = strsafe_view_from_cstr(from[i]);
+        pairs[i].to = strsafe_view_from_cstr(to[i]);
+    }
+
+    StrSafe_matcher m;
+    strsafe_matcher_init(&m);
+    strsafe_matcher_compile(&m, pairs, 5);
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* base = random_string(rand() % MAX_LEN);
+
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, base);
+        strsafe_replace_many(&s, &m);
+        fprintf(f, "%s,%s\n", base, strsafe_cstr(&s));
+
+        strsafe_free(&s);
+        free(base);
+    }
+    strsafe_matcher_free(&m);
+}
+
 // Test: cstr_find
 void test_cstr_find(FILE* f) {
     log_header(f, "cstr_find");
@@ -526,6 +778,29 @@ void test_cstr_count(FILE* f) {
     }
 }
 
+// Test: cstr_find_n / cstr_count_n with an explicit needle length
+void test_cstr_count_n(FILE* f) {
+    log_header(f, "cstr_count_n");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* needle = random_string(3);
+        bool should_contain = i < NUM_TESTS / 2;
+        char* haystack = generate_haystack(needle, should_contain);
+
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, haystack);
+
+        size_t needle_len = rand() % 3 + 1;
+        ssize_t pos = cstr_find_n(&s, needle, needle_len);
+        size_t count = cstr_count_n(&s, needle, needle_len);
+        fprintf(f, "%s,%.*s,%zd,%zu\n", haystack, (int)needle_len, needle, pos, count);
+
+        strsafe_free(&s);
+        free(haystack);
+        free(needle);
+    }
+}
+
 // Test: cstr_remove
 void test_cstr_remove(FILE* f) {
     log_header(f, "cstr_remove");
@@ -539,7 +814,7 @@ void test_cstr_remove(FILE* f) {
         strsafe_set(&s, base);
 
         cstr_remove(&s, remove);
-        fprintf(f, "%s,%s,%s\n", base, remove, s.data);
+        fprintf(f, "%s,%s,%s\n", base, remove, strsafe_cstr(&s));
 
         strsafe_free(&s);
         free(base);
@@ -560,7 +835,7 @@ void test_cstr_remove_all(FILE* f) {
         strsafe_set(&s, base);
 
         cstr_remove_all(&s, remove);
-        fprintf(f, "%s,%s,%s\n", base, remove, s.data);
+        fprintf(f, "%s,%s,%s\n", base, remove, strsafe_cstr(&s));
 
         strsafe_free(&s);
         free(base);
@@ -580,7 +855,7 @@ void test_cstr_append(FILE* f) {
         strsafe_set(&s, base);
 
         cstr_append(&s, suffix);
-        fprintf(f, "%s,%s,%s\n", base, suffix, s.data);
+        fprintf(f, "%s,%s,%s\n", base, suffix, strsafe_cstr(&s));
 
         strsafe_free(&s);
         free(base);
@@ -602,7 +877,7 @@ void test_cstr_appendv(FILE* f) {
         strsafe_set(&s, base);
 
         cstr_appendv(&s, s1, s2, s3, NULL);
-        fprintf(f, "%s,%s,%s,%s,%s\n", base, s1, s2, s3, s.data);
+        fprintf(f, "%s,%s,%s,%s,%s\n", base, s1, s2, s3, strsafe_cstr(&s));
 
         strsafe_free(&s);
         free(base);
@@ -626,7 +901,7 @@ void test_cstr_split(FILE* f) {
         StrSafe_array parts = cstr_split(&s, delim);
         fprintf(f, "%s,%s,%d parts", base, delim, parts.array_size);
         for (int j = 0; j < parts.array_size; ++j) {
-            fprintf(f, ",%s", parts.arr[j].data);
+            fprintf(f, ",%s", strsafe_cstr(&parts.arr[j]));
             strsafe_free(&parts.arr[j]);
         }
         fprintf(f, "\n");
@@ -636,7 +911,581 @@ void test_cstr_split(FILE* f) {
         free(base);
         free(delim);
     }
+
+    // an empty string that never owned a buffer still splits into one empty part
+    StrSafe empty;
+    strsafe_init(&empty);
+    StrSafe_array parts = cstr_split(&empty, ",");
+    fprintf(f, ",,,%d parts,%s\n", parts.array_size,
+        parts.array_size == 1 && strsafe_length(&parts.arr[0]) == 0 ? "empty" : "not empty");
+    strsafe_array_free(&parts);
+}
+// Test: cstr_array_join / strsafe_view_join_to rebuild what cstr_split took apart
+void test_cstr_array_join(FILE* f) {
+    log_header(f, "cstr_array_join");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* delim = random_string(rand() % 2 + 1);
+        char* base = generate_haystack(delim, true);
+
+        StrSafe s, joined;
+        strsafe_init(&s);
+        strsafe_init(&joined);
+        strsafe_set(&s, base);
+
+        StrSafe_array parts = cstr_split(&s, delim);
+        cstr_array_join(&joined, &parts, delim);
+
+        StrSafe_view_array views = { 0 };
+        cstr_split_view(&s, delim, &views);
+        char buffer[MAX_LEN + 1];
+        size_t len = strsafe_view_join_to(buffer, sizeof(buffer), views.views, views.count, strsafe_view_from_cstr(delim));
+        fprintf(f, "%s,%s,%d parts,%s,%s\n", base, delim, parts.array_size,
+            strsafe_compare(&s, &joined) ? "same" : "different",
+            len < sizeof(buffer) && strcmp(buffer, base) == 0 ? "same" : "different");
+
+        strsafe_array_free(&parts);
+        free(views.views);
+        strsafe_free(&s);
+        strsafe_free(&joined);
+        free(base);
+        free(delim);
+    }
+}
+// Test: cstr_split_ex / strsafe_substr_ex / strsafe_array_filter_ex from an arena released by one reset
+void test_cstr_split_arena(FILE* f) {
+    log_header(f, "cstr_split_ex (arena)");
+    StrSafe_arena arena;
+    strsafe_arena_init(&arena, 0);
+    const StrSafe_allocator* allocator = strsafe_arena_allocator(&arena);
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* delim = random_string(1);
+        char* base = generate_haystack(delim, true);
+
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, base);
+
+        StrSafe_array parts = cstr_split_ex(&s, delim, allocator);
+        fprintf(f, "%s,%s,%d parts", base, delim, parts.array_size);
+        for (int j = 0; j < parts.array_size; ++j) {
+            strsafe_substr_ex(&parts.arr[j], 0, 3, allocator);
+            fprintf(f, ",%s", strsafe_cstr(&parts.arr[j]) ? strsafe_cstr(&parts.arr[j]) : "");
+        }
+        StrSafe_needle needle;
+        strsafe_needle_init(&needle, "a", 1);
+        int kept = strsafe_array_filter_ex(&parts, &needle, false, allocator);
+        fprintf(f, ",%d kept\n", kept);
+
+        strsafe_arena_reset(&arena);
+        strsafe_free(&s);
+        free(base);
+        free(delim);
+    }
+    strsafe_arena_destroy(&arena);
 }
+
+// Test: cstr_split_view reusing one StrSafe_view_array
+void test_cstr_split_view(FILE* f) {
+    log_header(f, "cstr_split_view");
+    StrSafe_view_array fields;
+    strsafe_view_array_init(&fields);
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* delim = random_string(1);
+        char* base = generate_haystack(delim, true);
+
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, base);
+
+        cstr_split_view(&s, delim, &fields);
+        fprintf(f, "%s,%s,%zu parts", base, delim, fields.count);
+        for (size_t j = 0; j < fields.count; ++j) {
+            fprintf(f, ",%.*s", (int)fields.views[j].len, fields.views[j].ptr);
+        }
+        fprintf(f, "\n");
+
+        strsafe_free(&s);
+        free(base);
+        free(delim);
+    }
+    strsafe_view_array_free(&fields);
+}
+
+// Test: cstr_split_packed
+void test_cstr_split_packed(FILE* f) {
+    log_header(f, "cstr_split_packed");
+    StrSafe_packed_array fields;
+    strsafe_packed_array_init(&fields);
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* delim = random_string(1);
+        char* base = generate_haystack(delim, true);
+
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, base);
+
+        cstr_split_packed(&s, delim, &fields);
+        fprintf(f, "%s,%s,%zu parts", base, delim, fields.count);
+        for (size_t j = 0; j < fields.count; ++j) {
+            fprintf(f, ",%s", strsafe_packed_array_cstr(&fields, j));
+        }
+        fprintf(f, "\n");
+
+        strsafe_free(&s);
+        free(base);
+        free(delim);
+    }
+    strsafe_packed_array_free(&fields);
+}
+
+// Test: strsafe_tokenizer_next over random chunks
+void test_strsafe_tokenizer(FILE* f) {
+    log_header(f, "strsafe_tokenizer_next");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* delim = random_string(rand() % 2 + 1);
+        char* base = generate_haystack(delim, true);
+        size_t len = strlen(base);
+
+        StrSafe_tokenizer tok;
+        strsafe_tokenizer_init(&tok, delim, strlen(delim));
+        fprintf(f, "%s,%s", base, delim);
+        size_t pos = 0;
+        StrSafe_view field;
+        while (!tok.done) {
+            while (strsafe_tokenizer_next(&tok, &field)) {
+                fprintf(f, ",%.*s", (int)field.len, field.ptr);
+            }
+            if (pos == len) {
+                strsafe_tokenizer_finish(&tok);
+                continue;
+            }
+            size_t chunk = rand() % 8 + 1;
+            if (chunk > len - pos) chunk = len - pos;
+            strsafe_tokenizer_feed(&tok, base + pos, chunk);
+            pos += chunk;
+        }
+        fprintf(f, "\n");
+
+        strsafe_tokenizer_free(&tok);
+        free(base);
+        free(delim);
+    }
+}
+
+// Test: strsafe_map_file / strsafe_read_file
+void test_strsafe_map_file(FILE* f) {
+    log_header(f, "strsafe_map_file");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* needle = random_string(1);
+        char* base = generate_haystack(needle, i % 2 == 0);
+        FILE* out = fopen("test_map.txt", "wb");
+        fputs(base, out);
+        fclose(out);
+
+        StrSafe_mapped_file map;
+        StrSafe copy;
+        strsafe_init(&copy);
+        bool mapped = strsafe_map_file(&map, "test_map.txt");
+        bool read = strsafe_read_file(&copy, "test_map.txt");
+        StrSafe_view view = strsafe_mapped_view(&map);
+        fprintf(f, "%s,%s,%d,%d,%zu,%zu,%zu\n", base, needle, mapped, read, view.len,
+            strsafe_view_count(view, strsafe_view_from_cstr(needle)), cstr_count(&copy, needle));
+
+        strsafe_unmap_file(&map);
+        strsafe_free(&copy);
+        free(base);
+        free(needle);
+    }
+    remove("test_map.txt");
+}
+
+// Test: strsafe_write_array
+void test_strsafe_write_array(FILE* f) {
+    log_header(f, "strsafe_write_array");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* delim = random_string(1);
+        char* base = generate_haystack(delim, true);
+
+        StrSafe s, back;
+        strsafe_init(&s);
+        strsafe_init(&back);
+        strsafe_set(&s, base);
+        StrSafe_array parts = cstr_split(&s, delim);
+
+        FILE* out = fopen("test_write.txt", "wb");
+        bool written = strsafe_write_array(fileno(out), &parts);
+        fclose(out);
+        strsafe_read_file(&back, "test_write.txt");
+        fprintf(f, "%s,%s,%d parts,%d,%s\n", base, delim, parts.array_size, written, strsafe_cstr(&back));
+
+        strsafe_array_free(&parts);
+        strsafe_free(&s);
+        strsafe_free(&back);
+        free(base);
+        free(delim);
+    }
+    remove("test_write.txt");
+}
+
+// Test: strsafe_rope_insert / strsafe_rope_remove
+void test_strsafe_rope(FILE* f) {
+    log_header(f, "strsafe_rope_insert / strsafe_rope_remove");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* base = random_string(rand() % MAX_LEN);
+        char* ins = random_string(rand() % 4 + 1);
+        size_t len = strlen(base);
+        size_t pos = rand() % (len + 1);
+        size_t rem_pos = rand() % (len + 1);
+
+        StrSafe_rope rope;
+        StrSafe flat;
+        strsafe_init(&flat);
+        strsafe_rope_init_from(&rope, base, len);
+        strsafe_rope_insert(&rope, pos, ins, strlen(ins));
+        strsafe_rope_remove(&rope, rem_pos, 2);
+        strsafe_rope_flatten(&rope, &flat);
+        fprintf(f, "%s,%s,%zu,%zu,%s\n", base, ins, pos, rem_pos, strsafe_cstr(&flat));
+
+        strsafe_rope_free(&rope);
+        strsafe_free(&flat);
+        free(base);
+        free(ins);
+    }
+}
+
+// Test: cstr_intern returns one handle per distinct key
+void test_cstr_intern(FILE* f) {
+    log_header(f, "cstr_intern");
+    StrSafe_intern_table* table = malloc(sizeof(StrSafe_intern_table));
+    strsafe_intern_init(table);
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* key = random_string(rand() % 2 + 1);
+        char* other = random_string(rand() % 2 + 1);
+        const StrSafe* a = cstr_intern(table, key);
+        const StrSafe* b = cstr_intern(table, other);
+        fprintf(f, "%s,%s,%s,%s\n", key, other, strsafe_cstr(a), a == b ? "same" : "different");
+        free(key);
+        free(other);
+    }
+    fprintf(f, "distinct %zu\n", strsafe_intern_count(table));
+    strsafe_intern_free(table);
+    free(table);
+}
+
+// Test: strsafe_parallel_count / strsafe_parallel_replace_all against the single-threaded results
+void test_strsafe_parallel(FILE* f) {
+    log_header(f, "strsafe_parallel_count / strsafe_parallel_replace_all");
+    StrSafe_thread_pool pool;
+    strsafe_thread_pool_init(&pool, 3);
+    pool.parallel_min = 0;
+    for (int i = 0; i < NUM_TESTS / 10; ++i) {
+        char* needle_str = random_string(rand() % 3 + 1);
+        size_t big_len = 2 * STRSAFE_PARALLEL_CHUNK + rand() % MAX_LEN;
+        char* big = random_string(big_len);
+        // a three-letter alphabet gives plenty of matches, overlapping ones included
+        for (size_t j = 0; j < big_len; ++j)
+            big[j] = 'a' + big[j] % 3;
+        for (size_t j = 0; needle_str[j]; ++j)
+            needle_str[j] = 'a' + needle_str[j] % 3;
+        StrSafe s, r;
+        strsafe_init(&s);
+        strsafe_init(&r);
+        strsafe_set(&s, big);
+        strsafe_set(&r, big);
+        StrSafe_needle needle;
+        strsafe_needle_init(&needle, needle_str, strlen(needle_str));
+        size_t serial = strsafe_needle_count(&s, &needle);
+        size_t parallel = strsafe_parallel_count(&pool, strsafe_view_of(&s), &needle);
+        strsafe_needle_replace_all(&s, &needle, "#", 1);
+        strsafe_parallel_replace_all(&pool, &r, &needle, "#", 1);
+        fprintf(f, "%s,%zu,%zu,%zu,%s\n", needle_str, big_len, serial, parallel,
+            strsafe_compare(&s, &r) ? "same" : "different");
+        strsafe_free(&s);
+        strsafe_free(&r);
+        free(big);
+        free(needle_str);
+    }
+    strsafe_thread_pool_free(&pool);
+}
+
+// Test: batch replace / count / filter over an array, serial and on a pool
+void test_strsafe_array_replace_all(FILE* f) {
+    log_header(f, "strsafe_array_replace_all / strsafe_parallel_array_replace_all");
+    StrSafe_thread_pool pool;
+    strsafe_thread_pool_init(&pool, 3);
+    pool.parallel_min = 0;
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* needle_str = random_string(rand() % 2 + 1);
+        StrSafe_array a, b;
+        strsafe_array_init(&a);
+        strsafe_array_init(&b);
+        int rows = rand() % 50 + 2;
+        for (int j = 0; j < rows; ++j) {
+            char* row = generate_haystack(needle_str, rand() % 2);
+            strsafe_array_push(&a, row, strlen(row));
+            strsafe_array_push(&b, row, strlen(row));
+            free(row);
+        }
+        StrSafe_needle needle;
+        strsafe_needle_init(&needle, needle_str, strlen(needle_str));
+        size_t serial = strsafe_array_count(&a, &needle, NULL);
+        size_t parallel = strsafe_parallel_array_count(&pool, &b, &needle, NULL);
+        strsafe_array_replace_all(&a, &needle, "<match>", 7);
+        strsafe_parallel_array_replace_all(&pool, &b, &needle, "<match>", 7);
+        int same = 1;
+        for (int j = 0; j < rows; ++j)
+            same &= strsafe_compare(&a.arr[j], &b.arr[j]);
+        int kept = cstr_array_filter(&a, "<match>", true);
+        fprintf(f, "%s,%d,%zu,%zu,%d,%s\n", needle_str, rows, serial, parallel, kept,
+            same ? "same" : "different");
+        strsafe_array_free(&a);
+        strsafe_array_free(&b);
+        free(needle_str);
+    }
+    strsafe_thread_pool_free(&pool);
+}
+
+// Test: strsafe_to_lower / strsafe_strip / cstr_find_icase / cstr_find_first_of
+void test_strsafe_to_lower(FILE* f) {
+    log_header(f, "strsafe_to_lower / strsafe_strip / cstr_find_icase");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* needle = random_string(2);
+        char* base = generate_haystack(needle, i < NUM_TESTS / 2);
+
+        StrSafe s, padded;
+        strsafe_init(&s);
+        strsafe_init(&padded);
+        strsafe_set(&s, base);
+        strsafe_to_upper(&s);
+        ssize_t pos = cstr_find_icase(&s, needle);
+        ssize_t exact = cstr_find(&s, needle);
+        strsafe_to_lower(&s);
+
+        cstr_appendv(&padded, " \t", strsafe_cstr(&s), "\r\n", NULL);
+        strsafe_strip(&padded);
+        ssize_t first_of = cstr_find_first_of(&s, needle);
+        fprintf(f, "%s,%s,%zd,%zd,%zd,%s\n", base, needle, pos, exact, first_of,
+            cstr_compare_icase(&padded, base) ? "same" : "different");
+
+        strsafe_free(&s);
+        strsafe_free(&padded);
+        free(base);
+        free(needle);
+    }
+}
+
+// Test: strsafe_utf8_validate / strsafe_utf8_length / strsafe_utf8_substr on mixed text
+void test_strsafe_utf8_validate(FILE* f) {
+    log_header(f, "strsafe_utf8_validate / strsafe_utf8_substr");
+    const char* pieces[] = { "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80" };
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* base = random_string(rand() % 40);
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, base);
+        for (int j = rand() % 5; j > 0; --j)
+            cstr_append(&s, pieces[rand() % 3]);
+        cstr_append(&s, base);
+        bool valid = strsafe_utf8_validate(&s);
+        size_t codepoints = strsafe_utf8_length(&s);
+
+        // cutting a sequence in half must be caught
+        StrSafe broken;
+        strsafe_init(&broken);
+        strsafe_copy(&broken, &s);
+        strsafe_substr(&broken, 0, strlen(base) + 1);
+        strsafe_utf8_substr(&s, 1, codepoints / 2);
+        fprintf(f, "%s,%zu,%s,%s,%zu,%s\n", base, codepoints, valid ? "valid" : "invalid",
+            strsafe_utf8_validate(&broken) ? "valid" : "invalid", strsafe_utf8_length(&s),
+            strsafe_utf8_validate(&s) ? "valid" : "invalid");
+
+        strsafe_free(&s);
+        strsafe_free(&broken);
+        free(base);
+    }
+}
+
+// Test: strsafe_edit_batch_apply with inserts, removes and replaces queued out of order
+void test_strsafe_edit_batch(FILE* f) {
+    log_header(f, "strsafe_edit_batch_apply");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* base = random_string(rand() % 40);
+        size_t len = strlen(base);
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, base);
+
+        // edits are queued out of order over disjoint slots of the original
+        StrSafe_edit_batch batch;
+        strsafe_edit_batch_init(&batch);
+        size_t slot = len / 4;
+        for (int j = 3; j >= 0; --j) {
+            size_t offset = slot * j;
+            switch (rand() % 3) {
+            case 0: strsafe_edit_batch_insert(&batch, offset, "<+>", 3); break;
+            case 1: strsafe_edit_batch_remove(&batch, offset, slot / 2); break;
+            default: strsafe_edit_batch_replace(&batch, offset, slot / 2, "#", 1); break;
+            }
+        }
+        bool ok = strsafe_edit_batch_apply(&s, &batch);
+        fprintf(f, "%s,%s,%s\n", base, strsafe_cstr(&s), ok ? "true" : "false");
+
+        strsafe_edit_batch_free(&batch);
+        strsafe_free(&s);
+        free(base);
+    }
+}
+
+// Test: cstr_*_lit and the STRSAFE_FIND / STRSAFE_COUNT type-generic macros agree on literals
+void test_cstr_literal(FILE* f) {
+    log_header(f, "cstr_find_lit / cstr_count_lit / cstr_replace_all_lit / STRSAFE_FIND");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* base = random_string(rand() % 60);
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, base);
+        ssize_t pos_1 = cstr_find_lit(&s, "a");
+        ssize_t pos_2 = cstr_find_lit(&s, "ab");
+        ssize_t pos_4 = STRSAFE_FIND(&s, STRSAFE_LIT("abcd"));
+        size_t count = cstr_count_lit(&s, "a");
+        bool same = count == STRSAFE_COUNT(&s, "a") && pos_2 == STRSAFE_FIND(&s, "ab");
+        cstr_replace_all_lit(&s, "a", "-");
+        fprintf(f, "%s,%zd,%zd,%zd,%zu,%s,%s\n", base, pos_1, pos_2, pos_4, count,
+            strsafe_cstr(&s), same ? "same" : "differ");
+
+        strsafe_free(&s);
+        free(base);
+    }
+}
+
+#ifdef STRSAFE_POOL
+// Test: freed buffers are reused through STRSAFE_POOL
+void test_strsafe_pool(FILE* f) {
+    log_header(f, "strsafe_pool");
+    strsafe_pool_reset_stats();
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* base = random_string(rand() % MAX_LEN);
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, base);
+        cstr_append(&s, base);
+        size_t cap = strsafe_capacity(&s);
+        strsafe_free(&s);
+
+        StrSafe_pool_stats before = strsafe_pool_stats();
+        strsafe_init(&s);
+        strsafe_set(&s, base);
+        cstr_append(&s, base);
+        StrSafe_pool_stats after = strsafe_pool_stats();
+        fprintf(f, "%s,%zu,%zu,%zu,%zu\n", strsafe_cstr(&s), strsafe_length(&s), cap,
+            strsafe_capacity(&s), after.hits - before.hits);
+
+        strsafe_free(&s);
+        free(base);
+    }
+    StrSafe_pool_stats stats = strsafe_pool_stats();
+    fprintf(f, "hits=%zu,misses=%zu,cached=%zu,hit_rate=%.2f\n", stats.hits, stats.misses,
+        stats.cached, strsafe_pool_hit_rate());
+    strsafe_pool_purge();
+}
+
+// Test: STRSAFE_POOL blocks cached by pool workers are handed back when the workers exit
+void test_strsafe_pool_parallel(FILE* f) {
+    log_header(f, "strsafe_pool / strsafe_parallel_split");
+    StrSafe_thread_pool pool;
+    strsafe_thread_pool_init(&pool, 3);
+    pool.parallel_min = 0;
+    for (int i = 0; i < NUM_TESTS / 10; ++i) {
+        size_t big_len = 2 * STRSAFE_PARALLEL_CHUNK + rand() % MAX_LEN;
+        char* big = random_string(big_len);
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_set(&s, big);
+        StrSafe_needle needle;
+        strsafe_needle_init(&needle, "e", 1);
+        StrSafe_array serial = strsafe_needle_split(&s, &needle);
+        StrSafe_array parallel = strsafe_parallel_split(&pool, &s, &needle);
+        size_t count = strsafe_parallel_count(&pool, strsafe_view_of(&s), &needle);
+        strsafe_parallel_replace_all(&pool, &s, &needle, "<e>", 3);
+        fprintf(f, "%zu,%d,%d,%zu,%zu\n", big_len, serial.array_size, parallel.array_size,
+            count, strsafe_length(&s));
+        strsafe_array_free(&serial);
+        strsafe_array_free(&parallel);
+        strsafe_free(&s);
+        free(big);
+    }
+    strsafe_thread_pool_free(&pool);
+    StrSafe_pool_stats stats = strsafe_pool_stats();
+    fprintf(f, "cached=%zu\n", stats.cached);
+    strsafe_pool_purge();
+}
+#endif
+
+#ifdef STRSAFE_STATS
+static size_t stats_hook_events;
+
+static void stats_hook(void* ctx, StrSafe_stat_fn fn, StrSafe_stat_event event, size_t bytes) {
+    (void)fn;
+    (void)event;
+    (void)bytes;
+    ++*(size_t*)ctx;
+}
+
+// Test: STRSAFE_STATS counters and hook around split and append
+void test_strsafe_stats(FILE* f) {
+    log_header(f, "strsafe_stats");
+    strsafe_stats_set_hook(stats_hook, &stats_hook_events);
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* base = random_string(rand() % MAX_LEN);
+        StrSafe s;
+        strsafe_init(&s);
+        strsafe_stats_reset();
+        stats_hook_events = 0;
+        strsafe_set(&s, base);
+        for (int j = 0; j < 4; ++j)
+            cstr_append(&s, ",");
+        StrSafe_array parts = cstr_split(&s, ",");
+        ssize_t pos = cstr_find(&s, ",");
+
+        StrSafe_stats stats = strsafe_stats_snapshot();
+        const StrSafe_stat_counters* split = &stats.fn[STRSAFE_STAT_SPLIT];
+        const StrSafe_stat_counters* grow = &stats.fn[STRSAFE_STAT_ENSURE_CAPACITY];
+        fprintf(f, "%s,%d,%zd,%s=%zu/%zu/%zu,%s=%zu/%zu,%s=%zu,%zu\n", base, parts.array_size, pos,
+            strsafe_stat_name(STRSAFE_STAT_SPLIT), split->calls, split->bytes_scanned, split->bytes_copied,
+            strsafe_stat_name(STRSAFE_STAT_ENSURE_CAPACITY), grow->calls, grow->allocs + grow->reallocs,
+            strsafe_stat_name(STRSAFE_STAT_FIND), stats.fn[STRSAFE_STAT_FIND].bytes_scanned, stats_hook_events);
+
+        strsafe_array_free(&parts);
+        strsafe_free(&s);
+        free(base);
+    }
+    strsafe_stats_set_hook(NULL, NULL);
+}
+#endif
+
+// Test: strsafe_view_find / strsafe_view_count over a substring view
+void test_strsafe_view_find(FILE* f) {
+    log_header(f, "strsafe_view_find");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        char* needle = random_string(2);
+        bool should_contain = i < NUM_TESTS / 2;
+        char* haystack = generate_haystack(needle, should_contain);
+
+        StrSafe h;
+        strsafe_init(&h);
+        strsafe_set(&h, haystack);
+
+        StrSafe_view tail = strsafe_substr_view(&h, 1, SIZE_MAX);
+        ssize_t pos = strsafe_view_find(tail, strsafe_view_from_cstr(needle));
+        size_t count = strsafe_view_count(tail, strsafe_view_from_cstr(needle));
+        fprintf(f, "%s,%s,%zd,%zu\n", haystack, needle, pos, count);
+
+        strsafe_free(&h);
+        free(haystack);
+        free(needle);
+    }
+}
+
 // Main
 int main() {
     srand((unsigned int)time(NULL));
@@ -649,33 +1498,67 @@ int main() {
     // StrSafe-based tests
     test_strsafe_set(f);
     test_strsafe_compare(f);
+    test_strsafe_hash(f);
     test_strsafe_copy(f);
+    test_strsafe_share(f);
     test_strsafe_append(f);
     test_strsafe_appendv(f);
+    test_strsafe_appendf(f);
     test_strsafe_insert(f);
     test_strsafe_substr(f);
+    test_strsafe_substr_inplace(f);
     test_strsafe_replace_all(f);
     test_strsafe_remove_all(f);
     test_strsafe_count(f);
     test_strsafe_find(f);
     test_strsafe_find_from_pos(f);
+    test_strsafe_memmem(f);
+    test_strsafe_needle(f);
     test_strsafe_split(f);
     test_strsafe_array_free(f);  // via split
     test_strsafe_trim(f);
     test_strsafe_ensure_capacity(f);
+    test_strsafe_growth(f);
+    test_strsafe_sso(f);
 
     // C-string based tests
     test_cstr_replace(f);
     test_cstr_replace_all(f);
+    test_cstr_replace_all_n(f);
+    test_strsafe_replace_many(f);
     test_cstr_find(f);
     test_cstr_find_from_pos(f);
     test_cstr_compare(f);
     test_cstr_count(f);
+    test_cstr_count_n(f);
     test_cstr_remove(f);
     test_cstr_remove_all(f);
     test_cstr_append(f);
     test_cstr_appendv(f);
     test_cstr_split(f);
+    test_cstr_array_join(f);
+    test_cstr_split_arena(f);
+    test_cstr_split_view(f);
+    test_cstr_split_packed(f);
+    test_strsafe_tokenizer(f);
+    test_strsafe_map_file(f);
+    test_strsafe_write_array(f);
+    test_strsafe_rope(f);
+    test_cstr_intern(f);
+    test_strsafe_parallel(f);
+    test_strsafe_array_replace_all(f);
+    test_strsafe_view_find(f);
+    test_strsafe_to_lower(f);
+    test_strsafe_utf8_validate(f);
+    test_strsafe_edit_batch(f);
+    test_cstr_literal(f);
+#ifdef STRSAFE_POOL
+    test_strsafe_pool(f);
+    test_strsafe_pool_parallel(f);
+#endif
+#ifdef STRSAFE_STATS
+    test_strsafe_stats(f);
+#endif
 
     fclose(f);
     return 0;
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "StrSafe.hpp"
+
+#define NUM_TESTS 100
+#define MAX_LEN 64
+
+// Utility: Generate a random lowercase string
+std::string random_string(size_t len) {
+    std::string str(len, 'a');
+    for (size_t i = 0; i < len; ++i)
+        str[i] = (char)('a' + rand() % 26);
+    return str;
+}
+
+// Logging
+void log_header(FILE* f, const char* func_name) {
+    fprintf(f, "\n=== %s ===\n", func_name);
+}
+
+// Test: strsafe::String moves hand over the buffer instead of copying it
+void test_string_move(FILE* f) {
+    log_header(f, "strsafe::String move");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        std::string src = random_string(rand() % MAX_LEN);
+        strsafe::String a(src);
+        const char* buffer = a.data();
+        strsafe::String b = std::move(a);
+        bool stolen = b.data() == buffer && a.empty();
+        a = std::move(b);
+        stolen = stolen && a.data() == buffer && b.empty();
+        fprintf(f, "%s,%.*s,%s\n", src.c_str(), (int)a.size(), a.data(), stolen ? "moved" : strsafe_is_inline(a.get()) ? "inline" : "copied");
+    }
+}
+
+// Test: std::string_view in and out, and ownership across the C boundary
+void test_string_view_interop(FILE* f) {
+    log_header(f, "strsafe::String string_view / adopt / release");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        std::string src = random_string(rand() % MAX_LEN);
+        StrSafe raw;
+        strsafe_init(&raw);
+        strsafe_assign(&raw, src.data(), src.size());
+        strsafe::String s = strsafe::String::adopt(&raw);
+        s += std::string_view(src).substr(0, src.size() / 2);
+        std::string_view view = s;
+        size_t pos = s.find("a");
+        fprintf(f, "%s,%.*s,%zd,", src.c_str(), (int)view.size(), view.data(),
+            pos == strsafe::String::npos ? (ssize_t)-1 : (ssize_t)pos);
+        StrSafe back = s.release();
+        fprintf(f, "%s\n", strsafe_is_inline(&back) ? "inline" : strsafe_cstr(&back) == view.data() ? "same" : "differ");
+        strsafe_free(&back);
+    }
+}
+
+// Test: empty, cleared and moved-from strsafe::String still give a valid c_str()
+void test_string_empty(FILE* f) {
+    log_header(f, "strsafe::String empty c_str");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        std::string src = random_string(rand() % MAX_LEN);
+        strsafe::String empty;
+        strsafe::String cleared(src);
+        cleared.clear();
+        strsafe::String moved(src);
+        strsafe::String taken = std::move(moved);
+        std::string copy = std::string(empty.c_str()) + cleared.c_str() + moved.c_str();
+        bool valid = empty.c_str() && cleared.c_str() && moved.c_str() && empty.begin() == empty.end();
+        fprintf(f, "%s,[%s],[%s],[%s],%zu,%s\n", src.c_str(), empty.c_str(), cleared.c_str(), moved.c_str(),
+            copy.size(), valid ? "valid" : "null");
+    }
+}
+
+// Test: strsafe::Array iterated as a range of std::string_view
+void test_array_range(FILE* f) {
+    log_header(f, "strsafe::split / strsafe::Array");
+    for (int i = 0; i < NUM_TESTS; ++i) {
+        std::string src = random_string(rand() % MAX_LEN);
+        strsafe::Array parts = strsafe::split(strsafe::String(src), "a");
+        fprintf(f, "%s,%zu", src.c_str(), parts.size());
+        for (std::string_view part : parts)
+            fprintf(f, ",%.*s", (int)part.size(), part.data());
+        fprintf(f, "\n");
+    }
+}
+
+int main() {
+    srand((unsigned int)time(NULL));
+    FILE* f = fopen("test_results_cpp.txt", "w");
+    if (!f) {
+        perror("Failed to open test_results_cpp.txt");
+        return 1;
+    }
+
+    test_string_move(f);
+    test_string_view_interop(f);
+    test_string_empty(f);
+    test_array_range(f);
+
+    fclose(f);
+    return 0;
+}
@@ -1,803 +1,396 @@
+// Benchmark harness for the StrSafe search, edit and append paths.
+//
+// Build and run it from the repository root with `make bench` (or `make bench-nosimd`,
+// `make bench-avx2`, ... for the other configurations), or from this directory with any C compiler:
+//     cc -O2 -I../include StrSafe_test_timed.c -o strsafe_bench
+// and run `./strsafe_bench --help` for the options. Results go to stdout as CSV, one row
+// per operation, implementation, input size, needle length and hit pattern:
+//     op,impl,size,needle,hits,matches,iters,median_ns,p99_ns,ns_per_byte,gb_per_s,vs_libc
+// `median_ns`/`p99_ns` are per call over `--runs` samples taken after `--warmup` discarded
+// ones; each sample repeats the call `iters` times so it lasts at least `--sample-us`.
+// `ns_per_byte`/`gb_per_s` always divide by the whole input, also for a find that stops at
+// an early match. `vs_libc` is the fastest libc baseline (`strstr`/`memmem`) divided by the row's median.
+// Inputs are lowercase text from a seeded generator, so runs with the same `--seed` see
+// the same bytes on every platform. Needles carry a letter the text lacks, so `matches`
+// counts exactly the copies planted by the hit pattern: `none`, one at the very end
+// (`last`, the full scan that still finds something), or one every 16 needle lengths (`dense`).
+
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include "C:\\msys64\\home\\Nicci\\Source\\programs\\include\\StrSafe.h"
-
-#define NUM_TESTS 1000
-#define MAX_LEN 6400
-
-#include <time.h>
-
-long long get_nanoseconds(struct timespec start, struct timespec end) {
-	return (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
-}
-
-// Utility: Generate a random lowercase string
-char* random_string(size_t len) {
-	char* str = malloc(len + 1);
-	for (size_t i = 0; i < len; ++i)
-		str[i] = 'a' + rand() % 26;
-	str[len] = '\0';
-	return str;
-}
-
-// Utility: Ensure needle is in haystack in 50% of cases
-char* generate_haystack(const char* needle, bool ensure_contains) {
-	size_t base_len = rand() % (MAX_LEN - strlen(needle));
-	char* base = random_string(base_len);
-	if (ensure_contains) {
-		char* result = malloc(base_len + strlen(needle) + 1);
-		size_t insert_pos = rand() % (base_len + 1);
-		strncpy(result, base, insert_pos);
-		strcpy(result + insert_pos, needle);
-		strcpy(result + insert_pos + strlen(needle), base + insert_pos);
-		free(base);
-		return result;
+#include "StrSafe.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+#if defined(__GLIBC__) || defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) \
+	|| defined(__NetBSD__) || defined(__OpenBSD__)
+#define BENCH_HAVE_MEMMEM 1
+#endif
+
+#define BENCH_MAX_RUNS 1001
+#define BENCH_MAX_NEEDLE 64
+
+static const size_t bench_needle_lens[] = { 1, 2, 4, 8, 16, 64 };
+static const char* const bench_hit_names[] = { "none", "last", "dense" };
+
+typedef struct {
+	uint64_t seed;
+	int runs;
+	int warmup;
+	uint64_t sample_ns;
+	size_t min_size;
+	size_t max_size;
+	const char* op;
+} Bench_options;
+
+typedef struct {
+	StrSafe text;                          // haystack, rebuilt for every needle and hit pattern
+	char needle[BENCH_MAX_NEEDLE + 1];
+	char alt[BENCH_MAX_NEEDLE + 1];        // uppercase needle, never present in the lowercase text
+	size_t needle_len;
+	StrSafe_needle prepared;
+	size_t size;
+	size_t matches;
+	bool flipped;                          // replace_all has turned every needle into `alt`
+} Bench_case;
+
+typedef void (*bench_fn)(Bench_case* c, size_t iters);
+
+typedef struct {
+	double median_ns;
+	double p99_ns;
+	size_t iters;
+} Bench_result;
+
+static volatile size_t bench_sink;
+static StrSafe* volatile bench_escape;
+
+// Utility: hide the haystack from the optimizer so pure calls are not hoisted out of the loop
+static StrSafe* bench_text(Bench_case* c) {
+	bench_escape = &c->text;
+	return bench_escape;
+}
+
+// Utility: monotonic clock in nanoseconds
+static uint64_t bench_now_ns(void) {
+#ifdef _WIN32
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER now;
+	if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// Utility: splitmix64, so data depends only on the seed and not on the libc rand()
+static uint64_t bench_next(uint64_t* state) {
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+// Utility: fill `len` bytes with the letters 'a' to 'y'; 'z' is kept for needles
+static void bench_fill(char* dst, size_t len, uint64_t* state) {
+	size_t i = 0;
+	while (i < len) {
+		uint64_t r = bench_next(state);
+		for (int k = 0; k < 8 && i < len; ++k, r >>= 8) {
+			dst[i++] = (char)('a' + (r & 0xff) % 25);
+		}
 	}
-	return base;
 }
 
-void log_header_time(FILE* f, const char* func_name, long long duration_ns) {
-	fprintf(f, "\n=== %s ===\n", func_name);
-	fprintf(f, "Duration (ns): %lld\n", duration_ns);
-}
-// Logging
-void log_header(FILE* f, const char* func_name) {
-	fprintf(f, "\n=== %s ===\n", func_name);
+static int bench_compare_double(const void* a, const void* b) {
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
 }
 
-// Test: strsafe_set
-void test_strsafe_set(FILE* f) {
-	log_header(f, "strsafe_set");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* src = random_string(rand() % MAX_LEN);
-		StrSafe s;
-		strsafe_init(&s);
-		strsafe_set(&s, src);
-		fprintf(f, "%s,%s\n", src, s.data);
-		strsafe_free(&s);
-		free(src);
-	}
-}
+// Measure: calibrate the repeat count, drop the warmup samples, then take the median and p99
+static Bench_result bench_measure(bench_fn fn, Bench_case* c, const Bench_options* opt) {
+	static double samples[BENCH_MAX_RUNS];
+	Bench_result result = { 0, 0, 1 };
 
-// Test: strsafe_compare
-void test_strsafe_compare(FILE* f) {
-	log_header(f, "strsafe_compare");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* a_str = random_string(5);
-		char* b_str = (i % 2 == 0) ? strdup(a_str) : random_string(5);
-		StrSafe a;
-		strsafe_init(&a);
-		strsafe_set(&a, a_str);
-		bool result = strsafe_compare(&a, &(StrSafe){.data = b_str, .len = strlen(b_str)});
-		fprintf(f, "%s,%s,%s\n", a_str, b_str, result ? "true" : "false");
-		strsafe_free(&a);
-		free(a_str);
-		free(b_str);
+	for (;;) {
+		uint64_t start = bench_now_ns();
+		fn(c, result.iters);
+		uint64_t elapsed = bench_now_ns() - start;
+		if (elapsed >= opt->sample_ns || result.iters >= ((size_t)1 << 30)) break;
+		size_t next = elapsed ? (size_t)((double)result.iters * (double)opt->sample_ns / (double)elapsed * 1.1) : result.iters * 16;
+		result.iters = next > result.iters * 16 ? result.iters * 16 : next > result.iters ? next : result.iters * 2;
 	}
-}
 
-// Test: strsafe_copy
-void test_strsafe_copy(FILE* f) {
-	log_header(f, "strsafe_copy");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* src_str = random_string(rand() % MAX_LEN);
-		StrSafe src, dst;
-		strsafe_init(&src);
-		strsafe_init(&dst);
-		strsafe_set(&src, src_str);
-		strsafe_copy(&dst, &src);
-		fprintf(f, "%s,%s\n", src.data, dst.data);
-		strsafe_free(&src);
-		strsafe_free(&dst);
-		free(src_str);
-	}
-}
-
-// Test: strsafe_append
-void test_strsafe_append(FILE* f) {
-	log_header(f, "strsafe_append");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* base = random_string(5);
-		char* suffix = random_string(5);
-		StrSafe s, suf;
-		strsafe_init(&s);
-		strsafe_init(&suf);
-		strsafe_set(&s, base);
-		strsafe_set(&suf, suffix);
-		strsafe_append(&s, &suf);
-		fprintf(f, "%s,%s,%s\n", base, suffix, s.data);
-		strsafe_free(&s);
-		strsafe_free(&suf);
-		free(base);
-		free(suffix);
+	for (int i = 0; i < opt->warmup; ++i) {
+		fn(c, result.iters);
 	}
-}
-
-// Test: strsafe_substr
-void test_strsafe_substr(FILE* f) {
-	log_header(f, "strsafe_substr");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* base = random_string(10);
-		StrSafe s, sub;
-		strsafe_init(&s);
-		strsafe_init(&sub);
-		strsafe_set(&s, base);
-		size_t pos = rand() % 5;
-		size_t len = rand() % 5;
-		strsafe_substr(&sub, pos, len);
-		fprintf(f, "%s,%zu,%zu,%s\n", base, pos, len, sub.data);
-		strsafe_free(&s);
-		strsafe_free(&sub);
-		free(base);
+	for (int i = 0; i < opt->runs; ++i) {
+		uint64_t start = bench_now_ns();
+		fn(c, result.iters);
+		samples[i] = (double)(bench_now_ns() - start) / (double)result.iters;
 	}
+	qsort(samples, (size_t)opt->runs, sizeof(double), bench_compare_double);
+	result.median_ns = samples[opt->runs / 2];
+	size_t p99 = ((size_t)opt->runs * 99 + 99) / 100;
+	result.p99_ns = samples[p99 ? p99 - 1 : 0];
+	return result;
 }
 
-// Test: strsafe_replace_all
-void test_strsafe_replace_all(FILE* f) {
-	log_header(f, "strsafe_replace_all");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* old_str = random_string(2);
-		char* new_str = random_string(2);
-		bool should_contain = i < NUM_TESTS / 2;
-		char* base = generate_haystack(old_str, should_contain);
-		StrSafe s, old, new;
-		strsafe_init(&s);
-		strsafe_init(&old);
-		strsafe_init(&new);
-		strsafe_set(&s, base);
-		strsafe_set(&old, old_str);
-		strsafe_set(&new, new_str);
-		strsafe_replace_all(&s, &old, &new);
-		fprintf(f, "%s,%s,%s,%s\n", base, old_str, new_str, s.data);
-		strsafe_free(&s);
-		strsafe_free(&old);
-		strsafe_free(&new);
-		free(base);
-		free(old_str);
-		free(new_str);
-	}
+// Operations: each runs `iters` calls on the prepared case
+static void bench_find_strsafe(Bench_case* c, size_t iters) {
+	size_t sum = 0;
+	for (size_t i = 0; i < iters; ++i) sum += (size_t)cstr_find_n(bench_text(c), c->needle, c->needle_len);
+	bench_sink += sum;
 }
 
-// Test: strsafe_insert
-void test_strsafe_insert(FILE* f) {
-	log_header(f, "strsafe_insert");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* base = random_string(10);
-		char* insert = random_string(5);
-		size_t pos = rand() % (strlen(base) + 1);
-
-		StrSafe s, ins;
-		strsafe_init(&s);
-		strsafe_init(&ins);
-		strsafe_set(&s, base);
-		strsafe_set(&ins, insert);
-
-		strsafe_insert(&s, pos, &ins);
-		fprintf(f, "%s,%s,%zu,%s\n", base, insert, pos, s.data);
-
-		strsafe_free(&s);
-		strsafe_free(&ins);
-		free(base);
-		free(insert);
-	}
+static void bench_find_needle(Bench_case* c, size_t iters) {
+	size_t sum = 0;
+	for (size_t i = 0; i < iters; ++i) sum += (size_t)strsafe_needle_find(bench_text(c), &c->prepared);
+	bench_sink += sum;
 }
 
-// Test: strsafe_remove_all
-void test_strsafe_remove_all(FILE* f) {
-	log_header(f, "strsafe_remove_all");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* remove = random_string(2);
-		bool should_contain = i < NUM_TESTS / 2;
-		char* base = generate_haystack(remove, should_contain);
-
-		StrSafe s, rem;
-		strsafe_init(&s);
-		strsafe_init(&rem);
-		strsafe_set(&s, base);
-		strsafe_set(&rem, remove);
-
-		strsafe_remove_all(&s, &rem);
-		fprintf(f, "%s,%s,%s\n", base, remove, s.data);
-
-		strsafe_free(&s);
-		strsafe_free(&rem);
-		free(base);
-		free(remove);
-	}
+static void bench_find_strstr(Bench_case* c, size_t iters) {
+	size_t sum = 0;
+	for (size_t i = 0; i < iters; ++i) sum += (size_t)strstr(strsafe_cstr(bench_text(c)), c->needle);
+	bench_sink += sum;
 }
 
-// Test: strsafe_count
-void test_strsafe_count(FILE* f) {
-	log_header(f, "strsafe_count");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* needle = random_string(2);
-		bool should_contain = i < NUM_TESTS / 2;
-		char* haystack = generate_haystack(needle, should_contain);
-
-		StrSafe h, n;
-		strsafe_init(&h);
-		strsafe_init(&n);
-		strsafe_set(&h, haystack);
-		strsafe_set(&n, needle);
-
-		size_t count = strsafe_count(&h, &n);
-		fprintf(f, "%s,%s,%zu\n", haystack, needle, count);
-
-		strsafe_free(&h);
-		strsafe_free(&n);
-		free(haystack);
-		free(needle);
-	}
+#ifdef BENCH_HAVE_MEMMEM
+static void bench_find_memmem(Bench_case* c, size_t iters) {
+	size_t sum = 0;
+	for (size_t i = 0; i < iters; ++i) sum += (size_t)memmem(strsafe_cstr(bench_text(c)), c->size, c->needle, c->needle_len);
+	bench_sink += sum;
 }
+#endif
 
-// Test: strsafe_find
-void test_strsafe_find(FILE* f) {
-	log_header(f, "strsafe_find");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* needle = random_string(3);
-		bool should_contain = i < NUM_TESTS / 2;
-		char* haystack = generate_haystack(needle, should_contain);
-
-		StrSafe h, n;
-		strsafe_init(&h);
-		strsafe_init(&n);
-		strsafe_set(&h, haystack);
-		strsafe_set(&n, needle);
-
-		ssize_t pos = strsafe_find(&h, &n);
-		fprintf(f, "%s,%s,%zd\n", haystack, needle, pos);
-
-		strsafe_free(&h);
-		strsafe_free(&n);
-		free(haystack);
-		free(needle);
-	}
+static void bench_count_strsafe(Bench_case* c, size_t iters) {
+	size_t sum = 0;
+	for (size_t i = 0; i < iters; ++i) sum += cstr_count_n(bench_text(c), c->needle, c->needle_len);
+	bench_sink += sum;
 }
 
-// Test: strsafe_find_from_pos
-void test_strsafe_find_from_pos(FILE* f) {
-	log_header(f, "strsafe_find_from_pos");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* needle = random_string(2);
-		bool should_contain = i < NUM_TESTS / 2;
-		char* haystack = generate_haystack(needle, should_contain);
-
-		StrSafe h, n;
-		strsafe_init(&h);
-		strsafe_init(&n);
-		strsafe_set(&h, haystack);
-		strsafe_set(&n, needle);
-
-		size_t pos_start = rand() % (strlen(haystack) + 1);
-		ssize_t pos = strsafe_find_from_pos(&h, &n, pos_start);
-		fprintf(f, "%s,%s,%zu,%zd\n", haystack, needle, pos_start, pos);
-
-		strsafe_free(&h);
-		strsafe_free(&n);
-		free(haystack);
-		free(needle);
-	}
+static void bench_count_needle(Bench_case* c, size_t iters) {
+	size_t sum = 0;
+	for (size_t i = 0; i < iters; ++i) sum += strsafe_needle_count(bench_text(c), &c->prepared);
+	bench_sink += sum;
 }
 
-// Test: strsafe_array_free (used after split)
-void test_strsafe_array_free_at(FILE* f) {
-	log_header(f, "strsafe_array_free (via strsafe_split_at)");
-
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* base = random_string(16);
-		size_t base_len = strlen(base);
-
-		size_t split_pos = rand() % (base_len + 1);
-
-		StrSafe s;
-		strsafe_init(&s);
-		strsafe_set(&s, base);
-
-		StrSafe_array parts = strsafe_split_at(&s, split_pos);
-
-		fprintf(f, "%s,%zu,%zu parts", base, split_pos, parts.array_size);
-		for (size_t j = 0; j < parts.array_size; ++j) {
-			fprintf(f, ",%s", parts.arr[j].data);
-			strsafe_free(&parts.arr[j]);
+#ifdef BENCH_HAVE_MEMMEM
+static void bench_count_memmem(Bench_case* c, size_t iters) {
+	size_t sum = 0;
+	for (size_t i = 0; i < iters; ++i) {
+		const char* data = strsafe_cstr(bench_text(c));
+		const char* pos = data;
+		const char* end = data + c->size;
+		while ((pos = memmem(pos, (size_t)(end - pos), c->needle, c->needle_len)) != NULL) {
+			pos += c->needle_len;
+			++sum;
 		}
-		fprintf(f, "\n");
-
-		strsafe_array_free(&parts);
-		strsafe_free(&s);
-		free(base);
-	}
-}
-
-
-// Test: strsafe_trim
-void test_strsafe_trim(FILE* f) {
-	log_header(f, "strsafe_trim");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* base = malloc(MAX_LEN + 1);
-		size_t pad = rand() % 5;
-		memset(base, ' ', pad);
-		strcpy(base + pad, random_string(10));
-		strcat(base, "     ");
-
-		StrSafe s;
-		strsafe_init(&s);
-		strsafe_set(&s, base);
-		strsafe_trim(&s);
-		fprintf(f, "\"%s\",\"%s\"\n", base, s.data);
-
-		strsafe_free(&s);
-		free(base);
 	}
+	bench_sink += sum;
 }
+#endif
 
-// Test: strsafe_ensure_capacity
-void test_strsafe_ensure_capacity(FILE* f) {
-	log_header(f, "strsafe_ensure_capacity");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		size_t cap = rand() % 128 + 64;
-		StrSafe s;
-		strsafe_init(&s);
-		bool ok = strsafe_ensure_capacity(&s, cap);
-		fprintf(f, "%zu,%s\n", cap, ok ? "true" : "false");
-		strsafe_free(&s);
+// Same-length replacement that alternates direction, so the text is restored every second call
+static void bench_replace_all_strsafe(Bench_case* c, size_t iters) {
+	for (size_t i = 0; i < iters; ++i) {
+		cstr_replace_all(&c->text, c->flipped ? c->alt : c->needle, c->flipped ? c->needle : c->alt);
+		c->flipped = !c->flipped;
 	}
+	bench_sink += strsafe_length(&c->text);
 }
 
-// Test: strsafe_appendv
-void test_strsafe_appendv(FILE* f) {
-	log_header(f, "strsafe_appendv");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		StrSafe s, a, b, c;
-		strsafe_init(&s);
-		strsafe_init(&a);
-		strsafe_init(&b);
-		strsafe_init(&c);
-
-		char* base = random_string(5);
-		char* s1 = random_string(3);
-		char* s2 = random_string(3);
-		char* s3 = random_string(3);
-
-		strsafe_set(&s, base);
-		strsafe_set(&a, s1);
-		strsafe_set(&b, s2);
-		strsafe_set(&c, s3);
-
-		strsafe_appendv(&s, &a, &b, &c, NULL);
-		fprintf(f, "%s,%s,%s,%s,%s\n", base, s1, s2, s3, s.data);
-
-		strsafe_free(&s);
-		strsafe_free(&a);
-		strsafe_free(&b);
-		strsafe_free(&c);
-		free(base);
-		free(s1);
-		free(s2);
-		free(s3);
-	}
-}
-// Test: strsafe_split
-void test_strsafe_split_at(FILE* f) {
-	log_header(f, "strsafe_split_at");
-
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* base = random_string(16);
-		size_t base_len = strlen(base);
-
-		size_t split_pos = rand() % (base_len + 1);
-
-		StrSafe s;
-		strsafe_init(&s);
-		strsafe_set(&s, base);
-
-		StrSafe_array parts = strsafe_split_at(&s, split_pos);
-
-		fprintf(f, "%s,%zu,%zu parts", base, split_pos, parts.array_size);
-		for (size_t j = 0; j < parts.array_size; ++j) {
-			fprintf(f, ",%s", parts.arr[j].data);
-			strsafe_free(&parts.arr[j]);
-		}
-		fprintf(f, "\n");
-
+static void bench_split_strsafe(Bench_case* c, size_t iters) {
+	size_t sum = 0;
+	for (size_t i = 0; i < iters; ++i) {
+		StrSafe_array parts = cstr_split(bench_text(c), c->needle);
+		sum += (size_t)parts.array_size;
 		strsafe_array_free(&parts);
-		strsafe_free(&s);
-		free(base);
 	}
+	bench_sink += sum;
 }
 
-// Test: cstr_replace
-void test_cstr_replace(FILE* f) {
-	log_header(f, "cstr_replace");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* old_str = random_string(2);
-		char* new_str = random_string(2);
-		bool should_contain = i < NUM_TESTS / 2;
-		char* base = generate_haystack(old_str, should_contain);
-
+// Builds a string of `size` bytes from an empty one, in pieces of the needle length
+static void bench_append_strsafe(Bench_case* c, size_t iters) {
+	const char* data = strsafe_cstr(&c->text);
+	for (size_t i = 0; i < iters; ++i) {
 		StrSafe s;
 		strsafe_init(&s);
-		strsafe_set(&s, base);
-
-		cstr_replace(&s, old_str, new_str);
-		fprintf(f, "%s,%s,%s,%s\n", base, old_str, new_str, s.data);
-
-		strsafe_free(&s);
-		free(base);
-		free(old_str);
-		free(new_str);
-	}
-}
-
-// Test: cstr_replace_all
-void test_cstr_replace_all(FILE* f) {
-	log_header(f, "cstr_replace_all");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* old_str = random_string(2);
-		char* new_str = random_string(2);
-		bool should_contain = i < NUM_TESTS / 2;
-		char* base = generate_haystack(old_str, should_contain);
-
-		StrSafe s;
-		strsafe_init(&s);
-		strsafe_set(&s, base);
-
-		cstr_replace_all(&s, old_str, new_str);
-		fprintf(f, "%s,%s,%s,%s\n", base, old_str, new_str, s.data);
-
+		for (size_t off = 0; off < c->size; off += c->needle_len) {
+			size_t n = c->size - off < c->needle_len ? c->size - off : c->needle_len;
+			cstr_append_n(&s, data + off, n);
+		}
+		bench_sink += strsafe_length(&s);
 		strsafe_free(&s);
-		free(base);
-		free(old_str);
-		free(new_str);
 	}
 }
 
-// Test: cstr_find
-void test_cstr_find(FILE* f) {
-	log_header(f, "cstr_find");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* needle = random_string(3);
-		bool should_contain = i < NUM_TESTS / 2;
-		char* haystack = generate_haystack(needle, should_contain);
-
-		StrSafe s;
-		strsafe_init(&s);
-		strsafe_set(&s, haystack);
-
-		ssize_t pos = cstr_find(&s, needle);
-		fprintf(f, "%s,%s,%zd\n", haystack, needle, pos);
-
-		strsafe_free(&s);
-		free(haystack);
-		free(needle);
+typedef struct {
+	const char* op;
+	const char* impl;
+	bench_fn fn;
+	bool baseline;      // libc reference the other rows of the op are compared with
+	bool needs_hits;    // runs for every hit pattern rather than only the first
+} Bench_entry;
+
+// Baselines come before the implementations compared with them
+static const Bench_entry bench_entries[] = {
+	{ "find", "strstr", bench_find_strstr, true, true },
+#ifdef BENCH_HAVE_MEMMEM
+	{ "find", "memmem", bench_find_memmem, true, true },
+#endif
+	{ "find", "strsafe", bench_find_strsafe, false, true },
+	{ "find", "needle", bench_find_needle, false, true },
+#ifdef BENCH_HAVE_MEMMEM
+	{ "count", "memmem", bench_count_memmem, true, true },
+#endif
+	{ "count", "strsafe", bench_count_strsafe, false, true },
+	{ "count", "needle", bench_count_needle, false, true },
+	{ "replace_all", "strsafe", bench_replace_all_strsafe, false, true },
+	{ "split", "strsafe", bench_split_strsafe, false, true },
+	{ "append", "strsafe", bench_append_strsafe, false, false },
+};
+
+// Data: copy the base text and plant the needle according to the hit pattern
+static void bench_prepare(Bench_case* c, const char* base, size_t size, size_t needle_len, int hits, uint64_t* state) {
+	c->size = size;
+	c->needle_len = needle_len;
+	bench_fill(c->needle, needle_len, state);
+	c->needle[needle_len / 2] = 'z';   // never in the text, so only planted copies match
+	c->needle[needle_len] = '\0';
+	for (size_t i = 0; i <= needle_len; ++i) {
+		c->alt[i] = (char)(c->needle[i] ? c->needle[i] - 'a' + 'A' : '\0');
 	}
-}
-
-// Test: cstr_find_from_pos
-void test_cstr_find_from_pos(FILE* f) {
-	log_header(f, "cstr_find_from_pos");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* needle = random_string(2);
-		bool should_contain = i < NUM_TESTS / 2;
-		char* haystack = generate_haystack(needle, should_contain);
 
-		StrSafe s;
-		strsafe_init(&s);
-		strsafe_set(&s, haystack);
-
-		size_t pos_start = rand() % (strlen(haystack) + 1);
-		ssize_t pos = cstr_find_from_pos(&s, needle, pos_start);
-		fprintf(f, "%s,%s,%zu,%zd\n", haystack, needle, pos_start, pos);
-
-		strsafe_free(&s);
-		free(haystack);
-		free(needle);
+	strsafe_assign(&c->text, base, size);
+	char* data = strsafe_data(&c->text);
+	if (hits == 1) {
+		memcpy(data + size - needle_len, c->needle, needle_len);
 	}
-}
-
-// Test: cstr_compare
-void test_cstr_compare(FILE* f) {
-	log_header(f, "cstr_compare");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* a_str = random_string(5);
-		char* b_str = (i % 2 == 0) ? strdup(a_str) : random_string(5);
-
-		StrSafe a;
-		strsafe_init(&a);
-		strsafe_set(&a, a_str);
-
-		bool result = cstr_compare(&a, b_str);
-		fprintf(f, "%s,%s,%s\n", a_str, b_str, result ? "true" : "false");
-
-		strsafe_free(&a);
-		free(a_str);
-		free(b_str);
+	else if (hits == 2) {
+		size_t spacing = needle_len * 16;
+		for (size_t off = spacing / 2; off + needle_len <= size; off += spacing) {
+			memcpy(data + off, c->needle, needle_len);
+		}
 	}
-}
-
-// Test: cstr_count
-void test_cstr_count(FILE* f) {
-	log_header(f, "cstr_count");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* needle = random_string(2);
-		bool should_contain = i < NUM_TESTS / 2;
-		char* haystack = generate_haystack(needle, should_contain);
-
-		StrSafe s;
-		strsafe_init(&s);
-		strsafe_set(&s, haystack);
-
-		size_t count = cstr_count(&s, needle);
-		fprintf(f, "%s,%s,%zu\n", haystack, needle, count);
-
-		strsafe_free(&s);
-		free(haystack);
-		free(needle);
+	strsafe_needle_init(&c->prepared, c->needle, needle_len);
+	c->matches = cstr_count_n(&c->text, c->needle, needle_len);
+	c->flipped = false;
+}
+
+static size_t bench_parse_size(const char* arg) {
+	char* end;
+	double value = strtod(arg, &end);
+	switch (*end) {
+	case 'k': case 'K': value *= 1024.0; break;
+	case 'm': case 'M': value *= 1024.0 * 1024.0; break;
+	case 'g': case 'G': value *= 1024.0 * 1024.0 * 1024.0; break;
+	default: break;
 	}
+	return value < 1.0 ? 1 : (size_t)value;
 }
 
-// Test: cstr_remove
-void test_cstr_remove(FILE* f) {
-	log_header(f, "cstr_remove");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* remove = random_string(2);
-		bool should_contain = i < NUM_TESTS / 2;
-		char* base = generate_haystack(remove, should_contain);
-
-		StrSafe s;
-		strsafe_init(&s);
-		strsafe_set(&s, base);
-
-		cstr_remove(&s, remove);
-		fprintf(f, "%s,%s,%s\n", base, remove, s.data);
-
-		strsafe_free(&s);
-		free(base);
-		free(remove);
-	}
+static void bench_usage(const char* prog) {
+	printf("usage: %s [--seed N] [--runs N] [--warmup N] [--sample-us N]\n"
+		"          [--min-size BYTES] [--max-size BYTES] [--op find|count|replace_all|split|append]\n"
+		"sizes take a K, M or G suffix and grow 16x from --min-size (16) to --max-size (16M);\n"
+		"--max-size 1G adds a 1 GiB input.\n", prog);
 }
 
-// Test: cstr_remove_all
-void test_cstr_remove_all(FILE* f) {
-	log_header(f, "cstr_remove_all");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* remove = random_string(2);
-		bool should_contain = i < NUM_TESTS / 2;
-		char* base = generate_haystack(remove, should_contain);
-
-		StrSafe s;
-		strsafe_init(&s);
-		strsafe_set(&s, base);
-
-		cstr_remove_all(&s, remove);
-		fprintf(f, "%s,%s,%s\n", base, remove, s.data);
-
-		strsafe_free(&s);
-		free(base);
-		free(remove);
+int main(int argc, char** argv) {
+	Bench_options opt = { 1, 21, 3, 1000000, 16, (size_t)16 << 20, NULL };
+	for (int i = 1; i < argc; ++i) {
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+		if (strcmp(arg, "--help") == 0 || !value) {
+			bench_usage(argv[0]);
+			return strcmp(arg, "--help") == 0 ? 0 : 1;
+		}
+		if (strcmp(arg, "--seed") == 0) opt.seed = strtoull(value, NULL, 10);
+		else if (strcmp(arg, "--runs") == 0) opt.runs = atoi(value);
+		else if (strcmp(arg, "--warmup") == 0) opt.warmup = atoi(value);
+		else if (strcmp(arg, "--sample-us") == 0) opt.sample_ns = strtoull(value, NULL, 10) * 1000;
+		else if (strcmp(arg, "--min-size") == 0) opt.min_size = bench_parse_size(value);
+		else if (strcmp(arg, "--max-size") == 0) opt.max_size = bench_parse_size(value);
+		else if (strcmp(arg, "--op") == 0) opt.op = value;
+		else {
+			bench_usage(argv[0]);
+			return 1;
+		}
+		++i;
 	}
-}
-
-// Test: cstr_append
-void test_cstr_append(FILE* f) {
-	log_header(f, "cstr_append");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* base = random_string(5);
-		char* suffix = random_string(5);
-
-		StrSafe s;
-		strsafe_init(&s);
-		strsafe_set(&s, base);
-
-		cstr_append(&s, suffix);
-		fprintf(f, "%s,%s,%s\n", base, suffix, s.data);
-
-		strsafe_free(&s);
-		free(base);
-		free(suffix);
+	if (opt.runs < 1 || opt.runs > BENCH_MAX_RUNS || opt.warmup < 0 || opt.min_size > opt.max_size) {
+		bench_usage(argv[0]);
+		return 1;
 	}
-}
-
-// Test: cstr_appendv
-void test_cstr_appendv(FILE* f) {
-	log_header(f, "cstr_appendv");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* base = random_string(5);
-		char* s1 = random_string(3);
-		char* s2 = random_string(3);
-		char* s3 = random_string(3);
-
-		StrSafe s;
-		strsafe_init(&s);
-		strsafe_set(&s, base);
 
-		cstr_appendv(&s, s1, s2, s3, NULL);
-		fprintf(f, "%s,%s,%s,%s,%s\n", base, s1, s2, s3, s.data);
-
-		strsafe_free(&s);
-		free(base);
-		free(s1);
-		free(s2);
-		free(s3);
+	char* base = malloc(opt.max_size + 1);
+	if (!base) {
+		fprintf(stderr, "cannot allocate %zu bytes of input\n", opt.max_size);
+		return 1;
 	}
-}
-
-// Test: cstr_split
-void test_cstr_split(FILE* f) {
-	log_header(f, "cstr_split");
-	for (int i = 0; i < NUM_TESTS; ++i) {
-		char* delim = random_string(1);
-		char* base = generate_haystack(delim, true);
-
-		StrSafe s;
-		strsafe_init(&s);
-		strsafe_set(&s, base);
-
-		StrSafe_array parts = cstr_split(&s, delim);
-		fprintf(f, "%s,%s,%d parts", base, delim, parts.array_size);
-		for (int j = 0; j < parts.array_size; ++j) {
-			fprintf(f, ",%s", parts.arr[j].data);
-			strsafe_free(&parts.arr[j]);
+	uint64_t state = opt.seed;
+	bench_fill(base, opt.max_size, &state);
+	base[opt.max_size] = '\0';
+
+	printf("# seed=%llu runs=%d warmup=%d sample_us=%llu\n", (unsigned long long)opt.seed, opt.runs,
+		opt.warmup, (unsigned long long)(opt.sample_ns / 1000));
+	printf("op,impl,size,needle,hits,matches,iters,median_ns,p99_ns,ns_per_byte,gb_per_s,vs_libc\n");
+
+	Bench_case c;
+	strsafe_init(&c.text);
+	size_t entry_count = sizeof(bench_entries) / sizeof(bench_entries[0]);
+	for (size_t size = opt.min_size; size <= opt.max_size; ) {
+		for (size_t n = 0; n < sizeof(bench_needle_lens) / sizeof(bench_needle_lens[0]); ++n) {
+			size_t needle_len = bench_needle_lens[n];
+			if (needle_len > size) continue;
+			for (int hits = 0; hits < 3; ++hits) {
+				// each case gets data of its own that does not depend on which ops are selected
+				uint64_t case_state = opt.seed ^ ((uint64_t)size * 0x100000001b3ull + needle_len * 31 + (uint64_t)hits);
+				bench_prepare(&c, base, size, needle_len, hits, &case_state);
+
+				const char* op = NULL;
+				double baseline_ns = 0;
+				for (size_t e = 0; e < entry_count; ++e) {
+					const Bench_entry* entry = &bench_entries[e];
+					if (opt.op && strcmp(opt.op, entry->op) != 0) continue;
+					if (!entry->needs_hits && hits > 0) continue;
+					if (!op || strcmp(op, entry->op) != 0) {
+						op = entry->op;
+						baseline_ns = 0;
+					}
+
+					Bench_result r = bench_measure(entry->fn, &c, &opt);
+					if (c.flipped) bench_replace_all_strsafe(&c, 1);
+					if (entry->baseline && (baseline_ns == 0 || r.median_ns < baseline_ns)) baseline_ns = r.median_ns;
+
+					printf("%s,%s,%zu,%zu,%s,%zu,%zu,%.1f,%.1f,%.4f,%.3f,", entry->op, entry->impl, size, needle_len,
+						bench_hit_names[hits], c.matches, r.iters, r.median_ns, r.p99_ns, r.median_ns / (double)size,
+						(double)size / r.median_ns);
+					if (!entry->baseline && baseline_ns > 0) printf("%.2f", baseline_ns / r.median_ns);
+					printf("\n");
+					fflush(stdout);
+				}
+			}
 		}
-		fprintf(f, "\n");
-
-		free(parts.arr);
-		strsafe_free(&s);
-		free(base);
-		free(delim);
+		if (size == opt.max_size) break;
+		size = size > opt.max_size / 16 ? opt.max_size : size * 16;
 	}
-}
-// Main
-int main() {
-	srand((unsigned int)time(NULL));
-	FILE* f = fopen("test_results.txt", "w");
-	if (!f) {
-		perror("Failed to open test_results.txt");
-		return 1;
-	}
-	struct timespec start, end;
-	long long duration;
-
-	// StrSafe-based tests
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_set(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_set", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_compare(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_compare", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_copy(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_copy", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_append(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_append", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_appendv(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_appendv", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_insert(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_insert", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_substr(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_substr", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_replace_all(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_replace_all", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_remove_all(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_remove_all", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_count(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_count", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_find(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_find", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_find_from_pos(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_find_from_pos", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_split_at(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_split_at", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_array_free_at(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_array_free_at", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_trim(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_trim", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_strsafe_ensure_capacity(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_strsafe_ensure_capacity", duration);
-
-	// C-string based tests
-
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_cstr_replace(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_cstr_replace", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_cstr_replace_all(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_cstr_replace_all", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_cstr_find(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_cstr_find", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_cstr_find_from_pos(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_cstr_find_from_pos", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_cstr_compare(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_cstr_compare", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_cstr_count(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_cstr_count", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_cstr_remove(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_cstr_remove", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_cstr_remove_all(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_cstr_remove_all", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_cstr_append(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_cstr_append", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_cstr_appendv(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_cstr_appendv", duration);
-	clock_gettime(CLOCK_MONOTONIC, &start);
-	test_cstr_split(f);
-	clock_gettime(CLOCK_MONOTONIC, &end);
-	duration = get_nanoseconds(start, end);
-	log_header_time(f, "test_cstr_split", duration);
-	fclose(f);
+
+	strsafe_free(&c.text);
+	free(base);
 	return 0;
 }